@@ -1,9 +1,14 @@
 #include "ApiServer.h"
 
+#include <future>
+
 #include <meowpowminer/buildinfo.h>
 
+#include <libdevcore/Executor.h>
 #include <libethcore/Farm.h>
 
+#include <libcrypto/progpow.hpp>
+
 #ifndef HOST_NAME_MAX
 #define HOST_NAME_MAX 255
 #endif
@@ -15,6 +20,18 @@
 #define HTTP_ROW1_COLOR "#ffffff"
 #define HTTP_ROWRED_COLOR "#f46542"
 
+/* Pool connections belong to the network io service : api requests
+   handling them run there and wait for completion. Exceptions are
+   rethrown to the caller */
+template <typename Function>
+static void runOnNetworkService(Function _f)
+{
+    std::packaged_task<void()> task(_f);
+    std::future<void> done = task.get_future();
+    g_io_service.post([&task]() { task(); });
+    done.get();
+}
+
 
 /* helper functions getting values from a JSON request */
 static bool getRequestValue(const char* membername, bool& refValue, Json::Value& jRequest,
@@ -225,8 +242,8 @@ static bool parseRequestId(Json::Value& jRequest, Json::Value& jResponse)
 ApiServer::ApiServer(string address, int portnum, string password)
   : m_password(std::move(password)),
     m_address(address),
-    m_acceptor(g_io_service),
-    m_io_strand(g_io_service)
+    m_acceptor(g_api_io_service),
+    m_io_strand(g_api_io_service)
 {
     if (portnum < 0)
     {
@@ -353,7 +370,7 @@ void ApiConnection::disconnect()
 ApiConnection::ApiConnection(
     boost::asio::io_service::strand& _strand, int id, bool readonly, string password)
   : m_sessionId(id),
-    m_socket(g_io_service),
+    m_socket(g_api_io_service),
     m_io_strand(_strand),
     m_readonly(readonly),
     m_password(std::move(password))
@@ -492,7 +509,7 @@ void ApiConnection::processRequest(Json::Value& jRequest, Json::Value& jResponse
     else if (_method == "miner_getconnections")
     {
         // Returns a list of configured pools
-        jResponse["result"] = PoolManager::p().getConnectionsJson();
+        runOnNetworkService([&]() { jResponse["result"] = PoolManager::p().getConnectionsJson(); });
     }
 
     else if (_method == "miner_addconnection")
@@ -511,7 +528,7 @@ void ApiConnection::processRequest(Json::Value& jRequest, Json::Value& jResponse
         try
         {
             // If everything ok then add this new uri
-            PoolManager::p().addConnection(sUri);
+            runOnNetworkService([&]() { PoolManager::p().addConnection(sUri); });
             jResponse["result"] = true;
         }
         catch (...)
@@ -536,7 +553,7 @@ void ApiConnection::processRequest(Json::Value& jRequest, Json::Value& jResponse
             {
                 try
                 {
-                    PoolManager::p().setActiveConnection(index);
+                    runOnNetworkService([&]() { PoolManager::p().setActiveConnection(index); });
                 }
                 catch (const std::exception& _ex)
                 {
@@ -560,7 +577,7 @@ void ApiConnection::processRequest(Json::Value& jRequest, Json::Value& jResponse
             {
                 try
                 {
-                    PoolManager::p().setActiveConnection(uri);
+                    runOnNetworkService([&]() { PoolManager::p().setActiveConnection(uri); });
                 }
                 catch (const std::exception& _ex)
                 {
@@ -595,7 +612,7 @@ void ApiConnection::processRequest(Json::Value& jRequest, Json::Value& jResponse
 
         try
         {
-            PoolManager::p().removeConnection(index);
+            runOnNetworkService([&]() { PoolManager::p().removeConnection(index); });
             jResponse["result"] = true;
         }
         catch (const std::exception& _ex)
@@ -957,7 +974,8 @@ void ApiConnection::onSendSocketDataCompleted(const boost::system::error_code& e
 
 Json::Value ApiConnection::getMinerStat1()
 {
-    auto connection = PoolManager::p().getActiveConnection();
+    std::shared_ptr<URI> connection;
+    runOnNetworkService([&]() { connection = PoolManager::p().getActiveConnection(); });
     TelemetryType t = Farm::f().Telemetry();
     auto runningTime =
         std::chrono::duration_cast<std::chrono::minutes>(steady_clock::now() - t.start);
@@ -1064,18 +1082,21 @@ Json::Value ApiConnection::getMinerStatDetailPerMiner(
                                                              // share
 
     mininginfo["shares"] = jshares;
+    mininginfo["share_latency"] =
+        PoolManager::getShareLatencyJson(_t.miners.at(_index).solutions.latency);
     mininginfo["paused"] = _miner->paused();
     mininginfo["pause_reason"] = _miner->paused() ? _miner->pausedString() : Json::Value::null;
 
     /* Nonce infos */
-    auto segment_width = Farm::f().get_segment_width();
-    uint64_t gpustartnonce = Farm::f().get_nonce_scrambler() + ((uint64_t)_index << segment_width);
-    jsegment.append(toHex(uint64_t(gpustartnonce), HexPrefix::Add));
-    jsegment.append(toHex(uint64_t(gpustartnonce + (1LL << segment_width)), HexPrefix::Add));
+    auto segment = Farm::f().getNonceSegment(_index);
+    jsegment.append(toHex(segment.first, HexPrefix::Add));
+    jsegment.append(toHex(uint64_t(segment.first + segment.second), HexPrefix::Add));
     mininginfo["segment"] = jsegment;
 
     /* Hash & Share infos */
     mininginfo["hashrate"] = toHex((uint32_t)_t.miners.at(_index).hashrate, HexPrefix::Add);
+    mininginfo["idle_gap"] = _miner->kernelIdleGap();
+    mininginfo["dispatch_latency"] = _miner->dispatchLatency();
 
     jRes["hardware"] = hwinfo;
     jRes["mining"] = mininginfo;
@@ -1221,21 +1242,40 @@ Json::Value ApiConnection::getMinerStatDetail()
     }
 
 
+    {
+        // Queues of the io services
+        Json::Value ioinfo = Json::Value(Json::arrayValue);
+        for (auto const& stats : Executor::allStats())
+        {
+            Json::Value jStats;
+            jStats["name"] = stats.name;
+            jStats["threads"] = stats.threads;
+            jStats["handlers"] = stats.handlers;
+            jStats["queued"] = stats.queued;
+            jStats["max_queued"] = stats.maxQueued;
+            jStats["delay"] = stats.delayUs;
+            jStats["max_delay"] = stats.maxDelayUs;
+            ioinfo.append(jStats);
+        }
+        hostinfo["io"] = ioinfo;
+    }
+
     /* Connection info */
     Json::Value connectioninfo;
-    auto connection = PoolManager::p().getActiveConnection();
-    connectioninfo["uri"] = connection->str();
-    connectioninfo["connected"] = PoolManager::p().isConnected();
-    connectioninfo["switches"] = PoolManager::p().getConnectionSwitches();
+    Json::Value mininginfo;
+    runOnNetworkService([&]() {
+        connectioninfo["uri"] = PoolManager::p().getActiveConnection()->str();
+        connectioninfo["connected"] = PoolManager::p().isConnected();
+        connectioninfo["switches"] = PoolManager::p().getConnectionSwitches();
+        mininginfo["epoch"] = PoolManager::p().getCurrentEpoch();
+        mininginfo["epoch_changes"] = PoolManager::p().getEpochChanges();
+        mininginfo["difficulty"] = PoolManager::p().getCurrentDifficulty();
+    });
 
     /* Mining Info */
-    Json::Value mininginfo;
     Json::Value sharesinfo = Json::Value(Json::arrayValue);
 
     mininginfo["hashrate"] = toHex(uint32_t(t.farm.hashrate), HexPrefix::Add);
-    mininginfo["epoch"] = PoolManager::p().getCurrentEpoch();
-    mininginfo["epoch_changes"] = PoolManager::p().getEpochChanges();
-    mininginfo["difficulty"] = PoolManager::p().getCurrentDifficulty();
 
     sharesinfo.append(t.farm.solutions.accepted);
     sharesinfo.append(t.farm.solutions.rejected);
@@ -1245,6 +1285,45 @@ Json::Value ApiConnection::getMinerStatDetail()
     sharesinfo.append(uint64_t(solution_lastupdated.count()));  // interval in seconds from last
                                                                 // found share
     mininginfo["shares"] = sharesinfo;
+    mininginfo["share_latency"] = PoolManager::getShareLatencyJson(t.farm.solutions.latency);
+    mininginfo["verification"] = Farm::f().get_verification_json();
+
+    {
+        // Programs and kernel sources of periods, mostly generated ahead of time
+        auto programs{progpow::get_period_cache_stats()};
+        Json::Value programsinfo;
+        programsinfo["hits"] = Json::UInt64(programs.hits);
+        programsinfo["misses"] = Json::UInt64(programs.misses);
+        programsinfo["generated"] = Json::UInt64(programs.generated);
+        programsinfo["generation_time"] = Json::UInt64(programs.generation_us);
+        programsinfo["max_generation_time"] = Json::UInt64(programs.max_generation_us);
+        mininginfo["programs"] = programsinfo;
+    }
+
+    if (auto context{Farm::f().getEpochContext()})
+    {
+        Json::Value dagmemoryinfo;
+        dagmemoryinfo["light"] = ethash::to_string(ethash::get_epoch_context_memory_type(*context));
+        if (auto full{ethash::find_epoch_context(context->epoch_number, true)})
+            dagmemoryinfo["full"] = ethash::to_string(ethash::get_epoch_context_memory_type(*full));
+        mininginfo["dag_memory"] = dagmemoryinfo;
+    }
+
+    auto dagbuilds{ethash::get_dataset_build_progress()};
+    if (!dagbuilds.empty())
+    {
+        Json::Value daginfo = Json::Value(Json::arrayValue);
+        for (auto const& dagprogress : dagbuilds)
+        {
+            Json::Value buildinfo;
+            buildinfo["epoch"] = dagprogress.epoch_number;
+            buildinfo["numa_node"] = dagprogress.numa_node;
+            buildinfo["progress"] = dagprogress.percent();
+            buildinfo["eta"] = uint64_t(dagprogress.eta().count());
+            daginfo.append(buildinfo);
+        }
+        mininginfo["dag"] = daginfo;
+    }
 
     /* Monitors Info */
     Json::Value monitorinfo;
@@ -4,7 +4,31 @@
 
 // Modified by Firominer's authors 2021
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <list>
+#include <map>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 #include "bitwise.hpp"
 #include "ethash.hpp"
@@ -13,30 +37,220 @@ namespace ethash
 {
 namespace detail
 {
-std::mutex shared_context_mutex;
-std::shared_ptr<epoch_context> shared_context;
-thread_local std::shared_ptr<epoch_context> thread_local_context;
+/**
+ * A slot of the epoch context cache.
+ * The context is published through a shared_future so only the thread
+ * which inserted the slot builds the context while the others wait on it
+ * without holding the cache mutex.
+ */
+struct context_slot
+{
+    uint32_t epoch_number;
+    bool full;
+    unsigned numa_node;  // Node the full dataset replica is local to (0 for light)
+    std::shared_future<std::shared_ptr<epoch_context>> context;
+};
 
-ATTRIBUTE_NOINLINE
-void update_local_context(int epoch_number, bool full)
+std::mutex context_cache_mutex;
+std::list<context_slot> context_cache;  // Most recently used first
+size_t context_cache_capacity_light{3};
+size_t context_cache_capacity_full{1};
+
+std::atomic<unsigned> dataset_build_threads{0};  // 0 = all available CPUs
+std::mutex dataset_progress_mutex;
+std::map<std::pair<uint32_t, unsigned>, dataset_build_progress> dataset_builds;  // In progress, by epoch and node
+dataset_progress_handler dataset_progress_handler_fn;
+
+std::mutex numa_nodes_mutex;
+std::vector<std::vector<unsigned>> numa_nodes;  // CPUs of each node (empty when not NUMA aware)
+
+thread_local std::shared_ptr<epoch_context> thread_local_context_light;
+thread_local std::shared_ptr<epoch_context> thread_local_context_full;
+thread_local unsigned thread_local_context_full_node{0};
+
+/**
+ * Dataset items computed by light lookups (verification of shares).
+ * Items are keyed by epoch and index and spread over shards, each one with
+ * its own lock and evicting with the CLOCK (second chance) algorithm.
+ * Light contexts of the same epoch hold the same items, so they all share it.
+ */
+constexpr size_t kItem_cache_shards{16};
+
+struct alignas(64) item_cache_shard
 {
-    // Release the shared pointer of the obsoleted context.
-    thread_local_context.reset();
+    struct slot
+    {
+        uint64_t key;  // Epoch number in the high word, item index in the low one
+        bool referenced;
+        hash2048 item;
+    };
+
+    std::mutex mutex;
+    std::vector<slot> slots;
+    std::unordered_map<uint64_t, size_t> positions;  // Key to index in slots
+    size_t capacity{0};
+    size_t hand{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
 
-    // Local context invalid, check the shared context.
-    std::lock_guard<std::mutex> lock{shared_context_mutex};
+item_cache_shard item_cache[kItem_cache_shards];
+std::atomic<size_t> item_cache_capacity{0};  // Items (0 = disabled)
 
-    if (!shared_context || shared_context->epoch_number != epoch_number ||
-        full != (shared_context->full_dataset != nullptr))
+static void evict_contexts(bool full)
+{
+    // Dropping a slot only releases the reference held by the cache:
+    // whoever still holds the shared_ptr keeps the context alive.
+    // Capacity applies to each NUMA node on its own.
+    const size_t capacity{full ? context_cache_capacity_full : context_cache_capacity_light};
+    std::vector<size_t> count;
+    for (auto it{context_cache.begin()}; it != context_cache.end();)
     {
-        // Release the shared pointer of the obsoleted context.
-        shared_context.reset();
+        if (it->full == full)
+        {
+            if (count.size() <= it->numa_node)
+                count.resize(it->numa_node + 1, 0);
+            if (++count[it->numa_node] > capacity)
+            {
+                it = context_cache.erase(it);
+                continue;
+            }
+        }
+        ++it;
+    }
+}
+
+/**
+ * Gets the CPUs of a NUMA node, or all of them if no NUMA topology is set
+ */
+static std::vector<unsigned> numa_node_cpus(unsigned numa_node)
+{
+    {
+        std::lock_guard<std::mutex> lock{numa_nodes_mutex};
+        if (numa_node < numa_nodes.size() && !numa_nodes[numa_node].empty())
+            return numa_nodes[numa_node];
+    }
+    std::vector<unsigned> cpus(std::max(std::thread::hardware_concurrency(), 1U));
+    for (unsigned i{0}; i < cpus.size(); ++i)
+        cpus[i] = i;
+    return cpus;
+}
+
+/**
+ * Maps seeds to epochs so calculate_epoch_from_seed never has to scan the
+ * chain of seeds. Built once on first use (it takes a few tens of ms) and
+ * published lock-free; it lives for the whole process.
+ */
+constexpr uint32_t kSeed_table_epochs{30000};
+constexpr uint32_t kSeed_table_slots{1 << 16};  // Power of 2, load factor below 0.5
+static_assert(kSeed_table_slots > 2 * kSeed_table_epochs, "seed table too small");
+
+struct epoch_seed_table
+{
+    hash256 seeds[kSeed_table_epochs];   // Seed of each epoch
+    uint32_t slots[kSeed_table_slots];   // Epoch number + 1 (0 = empty slot)
+};
+
+std::atomic<const epoch_seed_table*> epoch_seed_table_ptr{nullptr};
+
+static const epoch_seed_table* get_epoch_seed_table() noexcept
+{
+    const epoch_seed_table* table{epoch_seed_table_ptr.load(std::memory_order_acquire)};
+    if (table)
+    {
+        return table;
+    }
+
+    // Concurrent first callers may all build it: only one gets published
+    auto* built{new (std::nothrow) epoch_seed_table{}};
+    if (!built)
+    {
+        return nullptr;
+    }
+    hash256 seed{};
+    for (uint32_t epoch{0}; epoch < kSeed_table_epochs; ++epoch)
+    {
+        built->seeds[epoch] = seed;
+        uint32_t slot{seed.word32s[0] & (kSeed_table_slots - 1)};
+        while (built->slots[slot])
+        {
+            slot = (slot + 1) & (kSeed_table_slots - 1);
+        }
+        built->slots[slot] = epoch + 1;
+        seed = keccak256(seed);
+    }
+
+    if (!epoch_seed_table_ptr.compare_exchange_strong(table, built, std::memory_order_acq_rel))
+    {
+        delete built;
+        return table;
+    }
+    return built;
+}
+
+ATTRIBUTE_NOINLINE
+std::shared_ptr<epoch_context> find_or_build_context(uint32_t epoch_number, bool full, unsigned numa_node)
+{
+    std::promise<std::shared_ptr<epoch_context>> builder;
+    std::shared_future<std::shared_ptr<epoch_context>> context;
+    bool owner{false};
+
+    {
+        std::lock_guard<std::mutex> lock{context_cache_mutex};
+
+        for (auto it{context_cache.begin()}; it != context_cache.end(); ++it)
+        {
+            if (it->epoch_number == epoch_number && it->full == full && it->numa_node == numa_node)
+            {
+                // Move to front (most recently used)
+                context_cache.splice(context_cache.begin(), context_cache, it);
+                context = it->context;
+                break;
+            }
+        }
 
-        // Build new context.
-        shared_context = {create_epoch_context(epoch_number, full), destroy_epoch_context};
+        if (!context.valid())
+        {
+            context = builder.get_future().share();
+            owner = true;
+            context_cache.push_front({epoch_number, full, numa_node, context});
+            evict_contexts(full);
+        }
+    }
+
+    // Either somebody else is (or was) building it ...
+    if (!owner)
+    {
+        return context.get();
     }
 
-    thread_local_context = shared_context;
+    // ... or it's up to us. Replicas for other NUMA nodes are copied from
+    // the one of node 0 rather than generated again.
+    try
+    {
+        if (numa_node)
+        {
+            const auto source{find_or_build_context(epoch_number, full, 0)};
+            builder.set_value({create_epoch_context_replica(*source, numa_node), destroy_epoch_context});
+        }
+        else
+        {
+            builder.set_value({create_epoch_context(epoch_number, full), destroy_epoch_context});
+        }
+    }
+    catch (...)
+    {
+        {
+            // Do not leave a failed slot in cache so next request retries
+            std::lock_guard<std::mutex> lock{context_cache_mutex};
+            context_cache.remove_if([&](const context_slot& slot) {
+                return slot.epoch_number == epoch_number && slot.full == full && slot.numa_node == numa_node &&
+                       slot.context.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+            });
+        }
+        builder.set_exception(std::current_exception());
+    }
+    return context.get();
 }
 
 
@@ -87,8 +301,13 @@ struct item_state
     ALWAYS_INLINE hash512 final() noexcept { return keccak512(le::uint32s(mix)); }
 };
 
-hash1024 lazy_lookup_1024(const epoch_context& context, uint32_t index) noexcept
+hash1024 lookup_1024(const epoch_context& context, uint32_t index) noexcept
 {
+    if (context.full_dataset)
+    {
+        return context.full_dataset[index];
+    }
+
     // l1_cache has the first 128 hash1024 items
     static constexpr uint32_t l1_cache_num_items_1024{kL1_cache_size / sizeof(hash1024)};
     if (index < l1_cache_num_items_1024)
@@ -97,23 +316,17 @@ hash1024 lazy_lookup_1024(const epoch_context& context, uint32_t index) noexcept
         return item;
     }
 
-    if (context.full_dataset)
-    {
-        hash1024& item = context.full_dataset[index];
-        if (item.word64s[0] == 0)
-        {
-            // TODO: Copy elision here makes it thread-safe?
-            item = calculate_dataset_item_1024(context, index);
-        }
-        return item;
-    }
-
     auto item = calculate_dataset_item_1024(context, index);
     return item;
 }
 
-hash2048 lazy_lookup_2048(const epoch_context& context, uint32_t index) noexcept
+hash2048 lookup_2048(const epoch_context& context, uint32_t index) noexcept
 {
+    if (context.full_dataset)
+    {
+        return reinterpret_cast<const hash2048*>(context.full_dataset)[index];
+    }
+
     // l1_cache has the first 64 hash2048 items
     static constexpr uint32_t l1_cache_num_items_2048{kL1_cache_size / sizeof(hash2048)};
     if (index < l1_cache_num_items_2048)
@@ -122,18 +335,52 @@ hash2048 lazy_lookup_2048(const epoch_context& context, uint32_t index) noexcept
         return item;
     }
 
-    if (context.full_dataset)
+    if (!item_cache_capacity.load(std::memory_order_relaxed))
+    {
+        return calculate_dataset_item_2048(context, index);
+    }
+
+    auto& shard{item_cache[index % kItem_cache_shards]};
+    const uint64_t key{(uint64_t{context.epoch_number} << 32) | index};
     {
-        hash2048& item = reinterpret_cast<hash2048*>(context.full_dataset)[index];
-        if (item.word64s[0] == 0)
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        const auto it{shard.positions.find(key)};
+        if (it != shard.positions.end())
         {
-            // TODO: Copy elision here makes it thread-safe?
-            item = calculate_dataset_item_2048(context, index);
+            auto& slot{shard.slots[it->second]};
+            slot.referenced = true;
+            ++shard.hits;
+            return slot.item;
         }
-        return item;
+        ++shard.misses;
     }
 
+    // Computed out of the lock : it reads 512 light cache items
     auto item = calculate_dataset_item_2048(context, index);
+
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    if (!shard.capacity || shard.positions.count(key))
+    {
+        return item;
+    }
+    if (shard.slots.size() < shard.capacity)
+    {
+        shard.positions.emplace(key, shard.slots.size());
+        shard.slots.push_back({key, false, item});
+        return item;
+    }
+
+    // Items looked up again since the hand last passed get a second chance
+    while (shard.slots[shard.hand].referenced)
+    {
+        shard.slots[shard.hand].referenced = false;
+        shard.hand = (shard.hand + 1) % shard.slots.size();
+    }
+    auto& victim{shard.slots[shard.hand]};
+    shard.positions.erase(victim.key);
+    shard.positions.emplace(key, shard.hand);
+    victim = {key, false, item};
+    shard.hand = (shard.hand + 1) % shard.slots.size();
     return item;
 }
 
@@ -151,6 +398,104 @@ hash1024 calculate_dataset_item_1024(const epoch_context& context, uint32_t inde
     return hash1024{{item0.final(), item1.final()}};
 }
 
+#if defined(__x86_64__) && __has_attribute(target)
+typedef uint32_t uint32x16 __attribute__((vector_size(64)));
+
+/**
+ * Computes N parts (the 512 bits each item_state makes) with consecutive
+ * seeds in lockstep. The mix of a part is a single vector so a round is a
+ * vector multiply and xor, and the light cache reads of all the parts are
+ * in flight together.
+ */
+template <size_t N>
+static inline ALWAYS_INLINE void calculate_item_parts_lanes(
+    const epoch_context& context, uint32_t seed, hash512 parts[]) noexcept
+{
+    const hash512* const cache{context.light_cache};
+    const uint32_t num_cache_items{context.light_cache_num_items};
+
+    for (uint32_t k{0}; k < N; ++k)
+    {
+        parts[k] = cache[(seed + k) % num_cache_items];
+        parts[k].word32s[0] ^= seed + k;
+    }
+    keccak512_multi(parts, parts, N);
+
+    uint32x16 mix[N];
+    std::memcpy(mix, parts, sizeof(mix));
+    for (uint32_t round{0}; round < kFull_dataset_item_parents; ++round)
+    {
+#pragma GCC unroll 16
+        for (uint32_t k{0}; k < N; ++k)
+        {
+            const uint32_t t{crypto::fnv1((seed + k) ^ round, mix[k][round % 16])};
+            uint32x16 parent;
+            std::memcpy(&parent, &cache[t % num_cache_items], sizeof(parent));
+            mix[k] = (mix[k] * crypto::kFNV_PRIME) ^ parent;
+        }
+    }
+    std::memcpy(parts, mix, sizeof(mix));
+    keccak512_multi(parts, parts, N);
+}
+
+__attribute__((target("avx2"))) static void calculate_item_parts_avx2_x8(
+    const epoch_context& context, uint32_t seed, hash512 parts[]) noexcept
+{
+    calculate_item_parts_lanes<8>(context, seed, parts);
+}
+
+__attribute__((target("avx512f"))) static void calculate_item_parts_avx512_x16(
+    const epoch_context& context, uint32_t seed, hash512 parts[]) noexcept
+{
+    calculate_item_parts_lanes<16>(context, seed, parts);
+}
+#endif
+
+/**
+ * The best implementation computing item parts in lockstep (nullptr if not
+ * available), selected during runtime initialization. A single item is left
+ * to item_state : 2 or 4 parts are too few to gain from it.
+ */
+struct item_parts_function
+{
+    uint32_t num_parts;
+    void (*calculate)(const epoch_context& context, uint32_t seed, hash512 parts[]) noexcept;
+};
+
+item_parts_function item_parts_best{0, nullptr};
+
+#if defined(__x86_64__) && __has_attribute(target)
+__attribute__((constructor)) static void select_item_parts_implementation()
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        item_parts_best = {16, calculate_item_parts_avx512_x16};
+    else if (__builtin_cpu_supports("avx2"))
+        item_parts_best = {8, calculate_item_parts_avx2_x8};
+}
+#endif
+
+void calculate_dataset_items_1024(
+    const epoch_context& context, uint32_t index, uint32_t count, hash1024 items[]) noexcept
+{
+    // Parts of an item have consecutive seeds, and so have consecutive items
+    uint32_t done{0};
+    if (item_parts_best.calculate)
+    {
+        const uint32_t group_items{item_parts_best.num_parts / 2};
+        for (; count - done >= group_items; done += group_items)
+        {
+            const auto seed{static_cast<uint32_t>(static_cast<uint64_t>(index + done) * 2)};
+            item_parts_best.calculate(context, seed, items[done].hash512s);
+        }
+    }
+    for (; done < count; ++done)
+    {
+        items[done] = calculate_dataset_item_1024(context, index + done);
+    }
+}
+
 hash2048 calculate_dataset_item_2048(const epoch_context& context, uint32_t index) noexcept
 {
     item_state item0{context, static_cast<uint32_t>(static_cast<uint64_t>(index) * 4)};
@@ -195,6 +540,163 @@ void build_light_cache(hash_512_function hash_function, hash512 cache[], uint32_
     }
 }
 
+/**
+ * Binds a dataset build thread to the given CPUs. Threads inherit the
+ * affinity of their creator, which for CPU miners is pinned to a single CPU;
+ * on NUMA systems this also makes the pages they touch first local to the
+ * node of the CPUs.
+ */
+static void set_thread_affinity(const std::vector<unsigned>& cpus) noexcept
+{
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (const auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &cpuset);
+    }
+    sched_setaffinity(0, sizeof(cpuset), &cpuset);
+#else
+    (void)cpus;
+#endif
+}
+
+/**
+ * Runs a job on the given number of threads bound to the given CPUs
+ */
+template <typename Job>
+static void run_on_threads(unsigned num_threads, const std::vector<unsigned>& cpus, Job job)
+{
+    auto worker = [&]() noexcept {
+        set_thread_affinity(cpus);
+        job();
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    try
+    {
+        for (unsigned i{0}; i < num_threads; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+        // Could not start all threads: the ones which did (if any) will do
+        // all the work, else the caller does and gets its own affinity back
+        if (threads.empty())
+        {
+#if defined(__linux__)
+            cpu_set_t caller_cpus;
+            const bool saved{sched_getaffinity(0, sizeof(caller_cpus), &caller_cpus) == 0};
+            worker();
+            if (saved)
+                sched_setaffinity(0, sizeof(caller_cpus), &caller_cpus);
+#else
+            worker();
+#endif
+        }
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+static unsigned build_threads_count(const std::vector<unsigned>& cpus) noexcept
+{
+    const unsigned num_threads{dataset_build_threads.load(std::memory_order_relaxed)};
+    return num_threads ? num_threads : static_cast<unsigned>(std::max<size_t>(cpus.size(), 1));
+}
+
+/**
+ * Progress of a full dataset build, or of its copy to another NUMA node.
+ * It's listed among the builds in progress for its lifetime
+ */
+class dataset_progress_tracker
+{
+public:
+    dataset_progress_tracker(uint32_t epoch_number, unsigned numa_node, uint32_t items_done, uint32_t items_total)
+      : key_{epoch_number, numa_node}
+    {
+        std::lock_guard<std::mutex> lock{dataset_progress_mutex};
+        dataset_builds[key_] = {
+            epoch_number, numa_node, items_done, items_total, true, std::chrono::steady_clock::now()};
+    }
+
+    ~dataset_progress_tracker()
+    {
+        std::lock_guard<std::mutex> lock{dataset_progress_mutex};
+        dataset_builds.erase(key_);
+    }
+
+    dataset_progress_tracker(const dataset_progress_tracker&) = delete;
+    dataset_progress_tracker& operator=(const dataset_progress_tracker&) = delete;
+
+    void report(uint32_t items_done) noexcept
+    {
+        std::lock_guard<std::mutex> lock{dataset_progress_mutex};
+        const auto it{dataset_builds.find(key_)};
+        if (it == dataset_builds.end())
+            return;
+        auto& progress{it->second};
+        const unsigned previous_percent{progress.percent()};
+        progress.items_done = items_done;
+        progress.building = items_done < progress.items_total;
+
+        const bool step{progress.percent() / 10 != previous_percent / 10};
+        if (dataset_progress_handler_fn && (step || !progress.building))
+        {
+            try
+            {
+                dataset_progress_handler_fn(progress);
+            }
+            catch (...)
+            {
+                // A failing observer must not break the build
+            }
+        }
+    }
+
+private:
+    const std::pair<uint32_t, unsigned> key_;
+};
+
+/**
+ * Generates all the items of the full dataset. Items are handed out to the
+ * build threads in chunks; the first ones are already in the l1 cache which
+ * shares its memory with the dataset.
+ */
+void build_full_dataset(const epoch_context& context, hash1024* full_dataset, const std::vector<unsigned>& cpus)
+{
+    static constexpr uint32_t chunk_size{4096};
+    static constexpr uint32_t first_item{kL1_cache_size / sizeof(hash1024)};
+    const uint32_t num_items{context.full_dataset_num_items};
+
+    dataset_progress_tracker progress{context.epoch_number, 0, first_item, num_items};
+
+    std::atomic<uint32_t> next_item{first_item};
+    std::atomic<uint32_t> items_done{first_item};
+
+    run_on_threads(build_threads_count(cpus), cpus, [&]() noexcept {
+        for (;;)
+        {
+            const uint32_t begin{next_item.fetch_add(chunk_size, std::memory_order_relaxed)};
+            if (begin >= num_items)
+            {
+                break;
+            }
+            const uint32_t end{std::min(begin + chunk_size, num_items)};
+            calculate_dataset_items_1024(context, begin, end - begin, &full_dataset[begin]);
+            const uint32_t count{end - begin};
+            progress.report(items_done.fetch_add(count, std::memory_order_relaxed) + count);
+        }
+    });
+}
+
 hash512 hash_seed(const hash256& header, uint64_t nonce) noexcept
 {
     nonce = le::uint64(nonce);
@@ -215,7 +717,7 @@ hash256 hash_mix(const epoch_context& context, const hash512& seed)
     for (uint32_t i = 0; i < kNum_dataset_accesses; ++i)
     {
         const uint32_t p = crypto::fnv1(i ^ seed_init, mix.word32s[i % num_words]) % index_limit;
-        const hash1024 newdata = le::uint32s(lazy_lookup_1024(context, p));
+        const hash1024 newdata = le::uint32s(lookup_1024(context, p));
 
         for (size_t j = 0; j < num_words; ++j)
             mix.word32s[j] = crypto::fnv1(mix.word32s[j], newdata.word32s[j]);
@@ -242,47 +744,522 @@ hash256 hash_final(const hash512& seed, const hash256& mix) noexcept
     return keccak256(final_data, sizeof(final_data));
 }
 
+constexpr size_t kPage_size{4096};
+
+static constexpr size_t round_up(size_t size, size_t alignment) noexcept
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Gets page aligned, zeroed anonymous memory. With huge set it tries, in
+ * order, explicit 1 GiB and 2 MiB huge pages, then transparent huge pages,
+ * and eventually falls back to normal pages.
+ */
+static void* allocate_pages(size_t size, bool huge, memory_type& type) noexcept
+{
+#if defined(_WIN32)
+    (void)huge;
+    type = memory_type::kNormal;
+    return VirtualAlloc(nullptr, round_up(size, kPage_size), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    static constexpr int prot{PROT_READ | PROT_WRITE};
+    static constexpr int flags{MAP_PRIVATE | MAP_ANONYMOUS};
+    void* data{MAP_FAILED};
+
+#if defined(MAP_HUGETLB)
+    if (huge)
+    {
+#if defined(MAP_HUGE_1GB)
+        static constexpr size_t huge_page_1g{size_t{1} << 30};
+        if (size >= huge_page_1g)
+        {
+            data = mmap(nullptr, round_up(size, huge_page_1g), prot, flags | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+            if (data != MAP_FAILED)
+            {
+                type = memory_type::kHugePages1G;
+                return data;
+            }
+        }
+#endif
+        static constexpr size_t huge_page_2m{size_t{1} << 21};
+#if defined(MAP_HUGE_2MB)
+        data = mmap(nullptr, round_up(size, huge_page_2m), prot, flags | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+#else
+        data = mmap(nullptr, round_up(size, huge_page_2m), prot, flags | MAP_HUGETLB, -1, 0);
+#endif
+        if (data != MAP_FAILED)
+        {
+            type = memory_type::kHugePages2M;
+            return data;
+        }
+    }
+#endif
+
+    data = mmap(nullptr, round_up(size, kPage_size), prot, flags, -1, 0);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    type = memory_type::kNormal;
+#if defined(MADV_HUGEPAGE)
+    if (huge && madvise(data, round_up(size, kPage_size), MADV_HUGEPAGE) == 0)
+        type = memory_type::kTransparentHugePages;
+#endif
+    return data;
+#endif
+}
+
+static void deallocate_pages(void* data, size_t size, memory_type type) noexcept
+{
+#if defined(_WIN32)
+    (void)size;
+    (void)type;
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    size_t page_size{kPage_size};
+    if (type == memory_type::kHugePages1G)
+        page_size = size_t{1} << 30;
+    else if (type == memory_type::kHugePages2M)
+        page_size = size_t{1} << 21;
+    munmap(data, round_up(size, page_size));
+#endif
+}
+
+static void* allocate_huge_pages(size_t size, memory_type& type) noexcept
+{
+    return allocate_pages(size, true, type);
+}
+
+static void* allocate_normal_pages(size_t size, memory_type& type) noexcept
+{
+    return allocate_pages(size, false, type);
+}
+
+const context_allocator huge_pages_allocator{allocate_huge_pages, deallocate_pages};
+const context_allocator normal_pages_allocator{allocate_normal_pages, deallocate_pages};
+
+std::mutex context_allocator_mutex;
+context_allocator current_context_allocator{huge_pages_allocator};
+
+/**
+ * Owns the memory behind an epoch context: either memory obtained from a
+ * context_allocator or a mapping of a file of the disk cache. The context is
+ * the first member so that destroy_epoch_context can get back here.
+ */
+struct context_storage
+{
+    epoch_context context;
+    char* data;        // Light cache (padded to a page) followed by the full dataset (or only the l1 cache)
+    size_t data_size;
+    memory_type type;
+    context_allocator::deallocate_fn deallocate;  // Nullptr when data points into a file mapping
+};
+
+/**
+ * Layout of a disk cache file: this header, padded to kDisk_cache_header_size
+ * so the data is page aligned in the mapping, followed by a verbatim copy of
+ * the context data.
+ */
+constexpr char kDisk_cache_magic[8]{'M', 'E', 'O', 'W', 'D', 'A', 'G', '\0'};
+constexpr uint32_t kDisk_cache_version{2};
+constexpr size_t kDisk_cache_header_size{4096};
+constexpr uint32_t kDisk_cache_samples{256};  // Dataset items recomputed to check a full file
+
+struct disk_cache_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t revision;
+    uint32_t epoch_number;
+    uint32_t full;
+    uint32_t light_cache_num_items;
+    uint32_t full_dataset_num_items;
+    uint64_t data_size;
+    hash256 light_cache_checksum;
+    hash256 header_checksum;  // keccak256 of all the fields above
+};
+static_assert(sizeof(disk_cache_header) <= kDisk_cache_header_size, "disk cache header too large");
+
+std::mutex disk_cache_mutex;
+std::filesystem::path disk_cache_directory;  // Empty when disabled
+bool disk_cache_full{false};
+size_t disk_cache_max_epochs{2};
+
+static hash256 disk_cache_header_checksum(const disk_cache_header& header) noexcept
+{
+    return keccak256(reinterpret_cast<const uint8_t*>(&header), offsetof(disk_cache_header, header_checksum));
+}
+
+static std::string disk_cache_prefix(bool full)
+{
+    return full ? "meowpow-full-" : "meowpow-light-";
+}
+
+static std::filesystem::path disk_cache_path(
+    const std::filesystem::path& directory, uint32_t epoch_number, bool full)
+{
+    return directory / (disk_cache_prefix(full) + std::to_string(epoch_number) + ".dag");
+}
+
+static const char* map_file(const std::filesystem::path& path, size_t size) noexcept
+{
+#if defined(_WIN32)
+    HANDLE file{CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+    LARGE_INTEGER file_size;
+    HANDLE mapping{nullptr};
+    if (GetFileSizeEx(file, &file_size) && static_cast<uint64_t>(file_size.QuadPart) == size)
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return nullptr;
+    // The view keeps the mapping alive
+    void* view{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size)};
+    CloseHandle(mapping);
+    return static_cast<const char*>(view);
+#else
+    const int fd{open(path.c_str(), O_RDONLY)};
+    if (fd == -1)
+        return nullptr;
+    struct stat st;
+    void* view{MAP_FAILED};
+    if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) == size)
+        view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return view == MAP_FAILED ? nullptr : static_cast<const char*>(view);
+#endif
+}
+
+static void unmap_file(const char* view, size_t size) noexcept
+{
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(view);
+#else
+    munmap(const_cast<char*>(view), size);
+#endif
+}
+
+/**
+ * Checks the data of a mapped context against its light cache: the light
+ * cache must match its checksum and some dataset items (all the ones in the
+ * l1 cache, plus a sample of the full dataset if any) must match the values
+ * they are computed from it.
+ */
+static bool verify_disk_cache_data(const epoch_context& context, const hash256& light_cache_checksum) noexcept
+{
+    const hash256 checksum{
+        keccak256(reinterpret_cast<const uint8_t*>(context.light_cache), context.light_cache_size)};
+    if (!is_equal(checksum, light_cache_checksum))
+        return false;
+
+    const auto* l1_items{reinterpret_cast<const hash2048*>(context.l1_cache)};
+    for (uint32_t i{0}; i < kL1_cache_size / sizeof(hash2048); ++i)
+    {
+        const hash2048 item{calculate_dataset_item_2048(context, i)};
+        if (std::memcmp(&item, &l1_items[i], sizeof(item)) != 0)
+            return false;
+    }
+
+    if (context.full_dataset)
+    {
+        for (uint32_t i{0}; i < kDisk_cache_samples; ++i)
+        {
+            const auto index{static_cast<uint32_t>(
+                (uint64_t{i} * context.full_dataset_num_items + context.full_dataset_num_items / 2) /
+                kDisk_cache_samples)};
+            const hash1024 item{calculate_dataset_item_1024(context, index)};
+            if (std::memcmp(&item, &context.full_dataset[index], sizeof(item)) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Maps the context of an epoch from the disk cache
+ * @return  The context or nullptr if not cached (or invalid)
+ */
+static context_storage* load_context(uint32_t epoch_number, bool full, uint32_t light_cache_num_items,
+    uint32_t full_dataset_num_items, size_t light_cache_size, size_t dataset_offset, size_t data_size)
+{
+    std::filesystem::path path;
+    {
+        std::lock_guard<std::mutex> lock{disk_cache_mutex};
+        if (disk_cache_directory.empty() || (full && !disk_cache_full))
+            return nullptr;
+        path = disk_cache_path(disk_cache_directory, epoch_number, full);
+    }
+
+    const size_t file_size{kDisk_cache_header_size + data_size};
+    const char* const view{map_file(path, file_size)};
+    if (!view)
+        return nullptr;
+
+    disk_cache_header header;
+    std::memcpy(&header, view, sizeof(header));
+    const bool header_valid{std::memcmp(header.magic, kDisk_cache_magic, sizeof(header.magic)) == 0 &&
+                            header.version == kDisk_cache_version && header.revision == kRevision &&
+                            header.epoch_number == epoch_number && header.full == uint32_t{full} &&
+                            header.light_cache_num_items == light_cache_num_items &&
+                            header.full_dataset_num_items == full_dataset_num_items &&
+                            header.data_size == data_size &&
+                            is_equal(header.header_checksum, disk_cache_header_checksum(header))};
+
+    char* const data{const_cast<char*>(view) + kDisk_cache_header_size};
+    const auto* const light_cache{reinterpret_cast<const hash512*>(data)};
+    const auto* const l1_cache{reinterpret_cast<const uint32_t*>(data + dataset_offset)};
+    const auto* const full_dataset{full ? reinterpret_cast<const hash1024*>(l1_cache) : nullptr};
+
+    auto* storage{new context_storage{{epoch_number, light_cache_num_items, light_cache_size, full_dataset_num_items,
+                                          get_full_dataset_size(full_dataset_num_items), light_cache, l1_cache,
+                                          full_dataset},
+        data, data_size, memory_type::kFileMapping, nullptr}};
+
+    if (!header_valid || !verify_disk_cache_data(storage->context, header.light_cache_checksum))
+    {
+        delete storage;
+        unmap_file(view, file_size);
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return nullptr;
+    }
+
+    // Recently used files are the last ones to be evicted
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return storage;
+}
+
+/**
+ * Keeps only the most recently used files of the given kind
+ */
+static void evict_disk_cache(const std::filesystem::path& directory, bool full, size_t max_epochs)
+{
+    const std::string prefix{disk_cache_prefix(full)};
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+    {
+        const std::string name{entry.path().filename().string()};
+        if (name.compare(0, prefix.size(), prefix) != 0 || entry.path().extension() != ".dag")
+            continue;
+        files.emplace_back(entry.last_write_time(ec), entry.path());
+    }
+
+    if (files.size() <= max_epochs)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i{max_epochs}; i < files.size(); ++i)
+        std::filesystem::remove(files[i].second, ec);
+}
+
+/**
+ * Stores the context in the disk cache (if enabled for its kind).
+ * The file is written aside and renamed so readers never see it partial.
+ * Failures are not fatal: the context simply won't be cached.
+ */
+static void save_context(const context_storage& storage)
+{
+    const epoch_context& context{storage.context};
+    const bool full{context.full_dataset != nullptr};
+
+    std::filesystem::path directory;
+    size_t max_epochs;
+    {
+        std::lock_guard<std::mutex> lock{disk_cache_mutex};
+        if (disk_cache_directory.empty() || (full && !disk_cache_full))
+            return;
+        directory = disk_cache_directory;
+        max_epochs = disk_cache_max_epochs;
+    }
+
+    disk_cache_header header{};
+    std::memcpy(header.magic, kDisk_cache_magic, sizeof(header.magic));
+    header.version = kDisk_cache_version;
+    header.revision = kRevision;
+    header.epoch_number = context.epoch_number;
+    header.full = uint32_t{full};
+    header.light_cache_num_items = context.light_cache_num_items;
+    header.full_dataset_num_items = context.full_dataset_num_items;
+    header.data_size = storage.data_size;
+    header.light_cache_checksum =
+        keccak256(reinterpret_cast<const uint8_t*>(context.light_cache), context.light_cache_size);
+    header.header_checksum = disk_cache_header_checksum(header);
+
+    std::vector<char> header_block(kDisk_cache_header_size, 0);
+    std::memcpy(header_block.data(), &header, sizeof(header));
+
+    const std::filesystem::path path{disk_cache_path(directory, context.epoch_number, full)};
+    std::filesystem::path tmp_path{path};
+    tmp_path += ".tmp";
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    {
+        std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+        file.write(header_block.data(), static_cast<std::streamsize>(header_block.size()));
+        file.write(storage.data, static_cast<std::streamsize>(storage.data_size));
+        file.close();
+        if (!file)
+        {
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmp_path, ec);
+        return;
+    }
+
+    evict_disk_cache(directory, full, max_epochs);
+}
+
 epoch_context* create_epoch_context(uint32_t epoch_number, bool full)
 {
-    static constexpr size_t context_alloc_size{sizeof(epoch_context)};
     const uint32_t light_cache_num_items{calculate_light_cache_num_items(epoch_number)};
     const uint32_t full_dataset_num_items{calculate_full_dataset_num_items(epoch_number)};
-    const size_t light_cache_size{static_cast<size_t>(light_cache_num_items) * kLight_cache_item_size};
+    const size_t light_cache_size{get_light_cache_size(light_cache_num_items)};
+
+    const size_t full_dataset_size{full ? get_full_dataset_size(full_dataset_num_items) : kL1_cache_size};
 
-    const size_t full_dataset_size{
-        full ? static_cast<size_t>(full_dataset_num_items) * kFull_dataset_item_size : kL1_cache_size};
+    // Both the light cache and the dataset start on a page boundary so no
+    // item straddles more cache lines than needed
+    const size_t dataset_offset{round_up(light_cache_size, kPage_size)};
+    const size_t data_size{dataset_offset + full_dataset_size};
 
-    const size_t alloc_size{context_alloc_size + light_cache_size + full_dataset_size};
+    // A warm restart maps the context in instead of building it
+    if (auto* storage{load_context(epoch_number, full, light_cache_num_items, full_dataset_num_items,
+            light_cache_size, dataset_offset, data_size)})
+    {
+        return &storage->context;
+    }
+
+    context_allocator allocator;
+    {
+        std::lock_guard<std::mutex> lock{context_allocator_mutex};
+        allocator = current_context_allocator;
+    }
 
     // Allocate light_cache memory
-    char* const alloc_data = static_cast<char*>(std::calloc(1, alloc_size));
-    if (!alloc_data)
+    memory_type type{memory_type::kNormal};
+    char* const data = static_cast<char*>(allocator.allocate(data_size, type));
+    if (!data)
     {
         throw std::runtime_error("Out of memory");
     }
 
-    hash512* const light_cache{reinterpret_cast<hash512*>(alloc_data + context_alloc_size)};
+    hash512* const light_cache{reinterpret_cast<hash512*>(data)};
     const hash256 epoch_seed = calculate_seed_from_epoch(epoch_number);
     build_light_cache(keccak512, light_cache, light_cache_num_items, epoch_seed);
 
-    uint32_t* const l1_cache{reinterpret_cast<uint32_t*>(alloc_data + context_alloc_size + light_cache_size)};
-    hash1024* full_dataset{full ? reinterpret_cast<hash1024*>(l1_cache) : nullptr};
+    uint32_t* const l1_cache{reinterpret_cast<uint32_t*>(data + dataset_offset)};
+    hash1024* const full_dataset{full ? reinterpret_cast<hash1024*>(l1_cache) : nullptr};
+
+    context_storage* const storage{new (std::nothrow) context_storage{
+        {epoch_number, light_cache_num_items, light_cache_size, full_dataset_num_items,
+            get_full_dataset_size(full_dataset_num_items), light_cache, l1_cache, full_dataset},
+        data, data_size, type, allocator.deallocate}};
+    if (!storage)
+    {
+        allocator.deallocate(data, data_size, type);
+        throw std::runtime_error("Out of memory");
+    }
+    epoch_context* const context{&storage->context};
 
-    epoch_context* const context =
-        new (alloc_data) epoch_context{epoch_number, light_cache_num_items, get_light_cache_size(light_cache_num_items),
-            full_dataset_num_items, get_full_dataset_size(full_dataset_num_items), light_cache, l1_cache, full_dataset};
+    // Item i of 2048 bits is made of items 2i and 2i + 1 of 1024 bits
+    calculate_dataset_items_1024(*context, 0, kL1_cache_size / sizeof(hash1024), reinterpret_cast<hash1024*>(l1_cache));
 
-    auto* full_dataset_2048 = reinterpret_cast<hash2048*>(l1_cache);
+    // Items only depend on the light cache so the context can be handed out
+    // read-only once they're all in place
+    if (full_dataset)
+        build_full_dataset(*context, full_dataset, numa_node_cpus(0));
+
+    try
+    {
+        save_context(*storage);
+    }
+    catch (...)
+    {
+        // Not being able to cache the context is not an error
+    }
 
-    for (uint32_t i{0}; i < kL1_cache_size / sizeof(hash2048); ++i)
-        full_dataset_2048[i] = calculate_dataset_item_2048(*context, i);
     return context;
 }
 
+epoch_context* create_epoch_context_replica(const epoch_context& source, unsigned numa_node)
+{
+    static constexpr size_t chunk_size{size_t{1} << 24};
+    const auto& source_storage{*reinterpret_cast<const context_storage*>(&source)};
+    const size_t data_size{source_storage.data_size};
+
+    context_allocator allocator;
+    {
+        std::lock_guard<std::mutex> lock{context_allocator_mutex};
+        allocator = current_context_allocator;
+    }
+
+    memory_type type{memory_type::kNormal};
+    char* const data = static_cast<char*>(allocator.allocate(data_size, type));
+    if (!data)
+    {
+        throw std::runtime_error("Out of memory");
+    }
+
+    // Pages are placed on the node of the thread touching them first. Progress
+    // is reported in dataset items, in proportion of the bytes copied
+    const std::vector<unsigned> cpus{numa_node_cpus(numa_node)};
+    const uint32_t num_items{source.full_dataset_num_items};
+    dataset_progress_tracker progress{source.epoch_number, numa_node, 0, num_items};
+    std::atomic<size_t> next_offset{0};
+    std::atomic<size_t> bytes_done{0};
+    run_on_threads(build_threads_count(cpus), cpus, [&]() noexcept {
+        for (;;)
+        {
+            const size_t offset{next_offset.fetch_add(chunk_size, std::memory_order_relaxed)};
+            if (offset >= data_size)
+            {
+                break;
+            }
+            const size_t size{std::min(chunk_size, data_size - offset)};
+            std::memcpy(data + offset, source_storage.data + offset, size);
+            const size_t done{bytes_done.fetch_add(size, std::memory_order_relaxed) + size};
+            progress.report(static_cast<uint32_t>(uint64_t{num_items} * done / data_size));
+        }
+    });
+
+    const auto* const light_cache{reinterpret_cast<const hash512*>(data)};
+    const auto dataset_offset{
+        static_cast<size_t>(reinterpret_cast<const char*>(source.l1_cache) - source_storage.data)};
+    const auto* const l1_cache{reinterpret_cast<const uint32_t*>(data + dataset_offset)};
+    const auto* const full_dataset{source.full_dataset ? reinterpret_cast<const hash1024*>(l1_cache) : nullptr};
+
+    context_storage* const storage{new (std::nothrow) context_storage{
+        {source.epoch_number, source.light_cache_num_items, source.light_cache_size, source.full_dataset_num_items,
+            source.full_dataset_size, light_cache, l1_cache, full_dataset},
+        data, data_size, type, allocator.deallocate}};
+    if (!storage)
+    {
+        allocator.deallocate(data, data_size, type);
+        throw std::runtime_error("Out of memory");
+    }
+    return &storage->context;
+}
+
 void destroy_epoch_context(epoch_context* context) noexcept
 {
-    context->~epoch_context();
-    std::free(context);
+    auto* storage{reinterpret_cast<context_storage*>(context)};
+    if (storage->deallocate)
+        storage->deallocate(storage->data, storage->data_size, storage->type);
+    else
+        unmap_file(storage->data - kDisk_cache_header_size, kDisk_cache_header_size + storage->data_size);
+    delete storage;
 }
 
 }  // namespace detail
@@ -376,43 +1353,26 @@ hash256 calculate_seed_from_epoch(uint32_t epoch_number) noexcept
 
 std::optional<uint32_t> calculate_epoch_from_seed(const hash256& seed) noexcept
 {
-    static constexpr uint32_t num_tries{30000};
-    static thread_local std::optional<uint32_t> cached_epoch_number{};
-    static thread_local hash256 cached_epoch_seed{};
-
-    // Do we have something in cache ?
-    if (cached_epoch_number.has_value())
+    const detail::epoch_seed_table* const table{detail::get_epoch_seed_table()};
+    if (!table)
     {
-        if (is_equal(seed, cached_epoch_seed))
-        {
-            return cached_epoch_number.value();
-        }
-        // Try the next seed, will match for sequential epoch access.
-        hash256 next{keccak256(cached_epoch_seed)};
-        if (is_equal(next, seed))
-        {
-            cached_epoch_seed = next;
-            *cached_epoch_number = *cached_epoch_number + 1;
-            return cached_epoch_number.value();
-        }
+        return std::nullopt;
     }
 
-    // Nothing in cache or not next in sequence ...
-    // restart linear search from epoch 0
-    cached_epoch_seed = {};
-    for (uint32_t i{0}; i < num_tries; i++)
+    // Open addressing with linear probing keyed by the first word of the seed
+    for (uint32_t slot{seed.word32s[0] & (detail::kSeed_table_slots - 1)};;
+         slot = (slot + 1) & (detail::kSeed_table_slots - 1))
     {
-        if (is_equal(cached_epoch_seed, seed))
+        const uint32_t entry{table->slots[slot]};
+        if (!entry)
         {
-            cached_epoch_number.emplace(i);
-            return cached_epoch_number.value();
+            return std::nullopt;  // No matches found
+        }
+        if (is_equal(table->seeds[entry - 1], seed))
+        {
+            return entry - 1;
         }
-        cached_epoch_seed = keccak256(cached_epoch_seed);
     }
-
-    // No matches found
-    cached_epoch_number.reset();
-    return std::nullopt;
 }
 
 uint32_t calculate_epoch_from_block_num(const uint64_t block_num) noexcept
@@ -459,16 +1419,152 @@ VerificationResult verify_full(const uint64_t block_num, const hash256& header_h
     return verify_full(*epoch_context, header_hash, mix_hash, nonce, boundary);
 }
 
-std::shared_ptr<epoch_context> get_epoch_context(uint32_t epoch_number, bool full) noexcept
+std::shared_ptr<epoch_context> get_epoch_context(uint32_t epoch_number, bool full, unsigned numa_node) noexcept
 {
-    // Check if local context matches epoch number.
-    if (!detail::thread_local_context || detail::thread_local_context->epoch_number != epoch_number ||
-        full != (detail::thread_local_context->full_dataset != nullptr))
+    // Light contexts are small enough to not be replicated
+    if (!full)
+        numa_node = 0;
+
+    // Light and full contexts are kept apart so callers asking for
+    // different kinds do not evict each other
+    auto& local_context{full ? detail::thread_local_context_full : detail::thread_local_context_light};
+
+    // Check if local context matches epoch number (and node).
+    if (!local_context || local_context->epoch_number != epoch_number ||
+        (full && detail::thread_local_context_full_node != numa_node))
     {
-        detail::update_local_context(epoch_number, full);
+        // Release the shared pointer of the obsoleted context.
+        local_context.reset();
+        local_context = detail::find_or_build_context(epoch_number, full, numa_node);
+        if (full)
+            detail::thread_local_context_full_node = numa_node;
     }
 
-    return detail::thread_local_context;
+    return local_context;
+}
+
+std::shared_ptr<epoch_context> find_epoch_context(uint32_t epoch_number, bool full) noexcept
+{
+    std::lock_guard<std::mutex> lock{detail::context_cache_mutex};
+    for (const auto& slot : detail::context_cache)
+    {
+        if (slot.epoch_number == epoch_number && slot.full == full && slot.numa_node == 0)
+        {
+            if (slot.context.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return nullptr;
+            try
+            {
+                return slot.context.get();
+            }
+            catch (...)
+            {
+                return nullptr;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void set_epoch_context_cache_capacity(size_t light_capacity, size_t full_capacity) noexcept
+{
+    std::lock_guard<std::mutex> lock{detail::context_cache_mutex};
+    detail::context_cache_capacity_light = std::max<size_t>(light_capacity, 1);
+    detail::context_cache_capacity_full = std::max<size_t>(full_capacity, 1);
+    detail::evict_contexts(false);
+    detail::evict_contexts(true);
+}
+
+void set_numa_nodes(const std::vector<std::vector<unsigned>>& nodes)
+{
+    std::lock_guard<std::mutex> lock{detail::numa_nodes_mutex};
+    detail::numa_nodes = nodes;
+}
+
+void set_epoch_context_disk_cache(const std::string& directory, bool full, size_t max_epochs)
+{
+    std::lock_guard<std::mutex> lock{detail::disk_cache_mutex};
+    detail::disk_cache_directory = directory;
+    detail::disk_cache_full = full;
+    detail::disk_cache_max_epochs = std::max<size_t>(max_epochs, 1);
+}
+
+void set_epoch_context_allocator(const context_allocator& allocator) noexcept
+{
+    std::lock_guard<std::mutex> lock{detail::context_allocator_mutex};
+    detail::current_context_allocator = allocator;
+}
+
+memory_type get_epoch_context_memory_type(const epoch_context& context) noexcept
+{
+    return reinterpret_cast<const detail::context_storage*>(&context)->type;
+}
+
+const char* to_string(memory_type type) noexcept
+{
+    switch (type)
+    {
+    case memory_type::kTransparentHugePages:
+        return "transparent huge pages";
+    case memory_type::kHugePages2M:
+        return "2 MiB huge pages";
+    case memory_type::kHugePages1G:
+        return "1 GiB huge pages";
+    case memory_type::kFileMapping:
+        return "file mapping";
+    default:
+        return "normal pages";
+    }
+}
+
+void set_dataset_build_threads(unsigned num_threads) noexcept
+{
+    detail::dataset_build_threads.store(num_threads, std::memory_order_relaxed);
+}
+
+void set_dataset_progress_handler(dataset_progress_handler handler)
+{
+    std::lock_guard<std::mutex> lock{detail::dataset_progress_mutex};
+    detail::dataset_progress_handler_fn = std::move(handler);
+}
+
+std::vector<dataset_build_progress> get_dataset_build_progress()
+{
+    std::vector<dataset_build_progress> builds;
+    std::lock_guard<std::mutex> lock{detail::dataset_progress_mutex};
+    for (const auto& build : detail::dataset_builds)
+        builds.push_back(build.second);
+    return builds;
+}
+
+void set_dataset_item_cache_capacity(size_t num_items)
+{
+    const size_t shard_capacity{(num_items + detail::kItem_cache_shards - 1) / detail::kItem_cache_shards};
+    for (auto& shard : detail::item_cache)
+    {
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        shard.slots.clear();
+        shard.slots.shrink_to_fit();
+        shard.positions.clear();
+        shard.slots.reserve(shard_capacity);
+        shard.positions.reserve(shard_capacity);
+        shard.capacity = shard_capacity;
+        shard.hand = 0;
+    }
+    detail::item_cache_capacity.store(shard_capacity * detail::kItem_cache_shards, std::memory_order_relaxed);
+}
+
+dataset_item_cache_stats get_dataset_item_cache_stats() noexcept
+{
+    dataset_item_cache_stats stats;
+    stats.capacity = detail::item_cache_capacity.load(std::memory_order_relaxed);
+    for (auto& shard : detail::item_cache)
+    {
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        stats.size += shard.slots.size();
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+    }
+    return stats;
 }
 
 hash256 get_boundary_from_diff(const intx::uint256 difficulty) noexcept
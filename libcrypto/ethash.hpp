@@ -8,8 +8,12 @@
 #ifndef CRYPTO_ETHASH_HPP_
 #define CRYPTO_ETHASH_HPP_
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 #include <intx/intx.hpp>
 
@@ -52,7 +56,71 @@ struct epoch_context
     const size_t full_dataset_size;
     const hash512* const light_cache;
     const uint32_t* const l1_cache;
-    hash1024* full_dataset;
+    const hash1024* const full_dataset;  // Fully built when present (read-only)
+};
+
+/**
+ * Kind of memory backing the data of an epoch context
+ */
+enum class memory_type
+{
+    kNormal,
+    kTransparentHugePages,
+    kHugePages2M,
+    kHugePages1G,
+    kFileMapping  // Mapped from the on-disk cache
+};
+
+/**
+ * Provides the memory of epoch contexts. allocate must return zeroed and
+ * page aligned memory (or nullptr) and set the kind of memory it got.
+ */
+struct context_allocator
+{
+    using allocate_fn = void* (*)(size_t size, memory_type& type) noexcept;
+    using deallocate_fn = void (*)(void* data, size_t size, memory_type type) noexcept;
+
+    allocate_fn allocate;
+    deallocate_fn deallocate;
+};
+
+/**
+ * Progress of a full dataset build, or of its copy to another NUMA node.
+ */
+struct dataset_build_progress
+{
+    uint32_t epoch_number{0};
+    unsigned numa_node{0};
+    uint32_t items_done{0};
+    uint32_t items_total{0};
+    bool building{false};
+    std::chrono::steady_clock::time_point started{};
+
+    unsigned percent() const noexcept { return items_total ? unsigned(uint64_t{items_done} * 100 / items_total) : 0; }
+
+    // Estimated time left, extrapolated from the pace so far
+    std::chrono::seconds eta() const noexcept
+    {
+        if (!items_done || items_done >= items_total)
+            return std::chrono::seconds(0);
+        const auto elapsed{std::chrono::steady_clock::now() - started};
+        return std::chrono::duration_cast<std::chrono::seconds>(elapsed * (items_total - items_done) / items_done);
+    }
+};
+
+using dataset_progress_handler = std::function<void(const dataset_build_progress&)>;
+
+/**
+ * Counters of the cache of dataset items computed by light lookups
+ */
+struct dataset_item_cache_stats
+{
+    size_t capacity{0};  // Items (0 = disabled)
+    size_t size{0};      // Items held
+    uint64_t hits{0};
+    uint64_t misses{0};
+
+    double hit_rate() const noexcept { return (hits + misses) ? double(hits) / double(hits + misses) : 0.0; }
 };
 
 
@@ -62,6 +130,14 @@ struct result
     hash256 mix_hash;
 };
 
+struct search_result
+{
+    bool solution_found{false};
+    uint64_t nonce{0};
+    hash256 final_hash{};
+    hash256 mix_hash{};
+};
+
 enum class VerificationResult
 {
     kOk,             // Verification ok
@@ -74,22 +150,44 @@ namespace detail
 // using lookup_fn = hash1024 (*)(const epoch_context&, uint32_t);
 using hash_512_function = hash512 (*)(const uint8_t* data, size_t size);
 
-hash1024 lazy_lookup_1024(const epoch_context& context, uint32_t index) noexcept;
-hash2048 lazy_lookup_2048(const epoch_context& context, uint32_t index) noexcept;
+hash1024 lookup_1024(const epoch_context& context, uint32_t index) noexcept;
+hash2048 lookup_2048(const epoch_context& context, uint32_t index) noexcept;
 hash1024 calculate_dataset_item_1024(const epoch_context& context, uint32_t index) noexcept;
 hash2048 calculate_dataset_item_2048(const epoch_context& context, uint32_t index) noexcept;
 
+/**
+ * Computes count consecutive dataset items from index, several of them in
+ * lockstep (SIMD) when the CPU allows. Results are the ones of calculate_dataset_item_1024.
+ */
+void calculate_dataset_items_1024(
+    const epoch_context& context, uint32_t index, uint32_t count, hash1024 items[]) noexcept;
+
 hash512 hash_seed(const hash256& header, uint64_t nonce) noexcept;
 hash256 hash_mix(const epoch_context& context, const hash512& seed);
 hash256 hash_final(const hash512& seed, const hash256& mix) noexcept;
 
 void destroy_epoch_context(epoch_context* context) noexcept;
 
+// Tries explicit 1 GiB and 2 MiB huge pages, then transparent huge pages, then normal pages (default)
+extern const context_allocator huge_pages_allocator;
+// Normal pages only
+extern const context_allocator normal_pages_allocator;
+
 /**
- * Creates the dag epoch context
+ * Creates the dag epoch context.
+ * It's mapped from the disk cache when available there, otherwise it's built
+ * (and stored in the disk cache if enabled). When full the whole dataset is
+ * generated before returning, split among the threads set with
+ * set_dataset_build_threads()
  */
 epoch_context* create_epoch_context(uint32_t epoch_number, bool full);
 
+/**
+ * Creates a copy of a context whose memory is local to the given NUMA node
+ * (see set_numa_nodes())
+ */
+epoch_context* create_epoch_context_replica(const epoch_context& source, unsigned numa_node);
+
 }  // namespace detail
 
 /**
@@ -135,6 +233,8 @@ hash256 calculate_seed_from_epoch(uint32_t epoch_number) noexcept;
 
 /**
  * Calculates the epoch number provided a seed hash.
+ * Seeds of the first 30000 epochs are looked up in a process wide table
+ * built on first use, so it does not depend on the epoch asked before.
  * @param seed          The hash256 seed
  * @return              The epoch number if found.
  */
@@ -197,11 +297,98 @@ VerificationResult verify_full(const uint64_t block_num, const hash256& header_h
 using epoch_context_ptr = std::unique_ptr<epoch_context, decltype(&detail::destroy_epoch_context)>;
 
 /**
- * Creates an DAG context for given epoch number
+ * Gets the DAG context for given epoch number from the process wide cache
+ * building it if not yet available. Light and full contexts are cached
+ * independently. Concurrent requests for the same context wait for the
+ * first one to complete the build instead of building it again.
+ * Full contexts of NUMA nodes other than 0 are replicas of the one of node 0.
+ * @param epoch_number
+ * @param full          Whether or not the full dataset has to be allocated
+ * @param numa_node     NUMA node the full dataset has to be local to
+ * @return              A shared_ptr to the context
+ */
+std::shared_ptr<epoch_context> get_epoch_context(uint32_t epoch_number, bool full, unsigned numa_node = 0) noexcept;
+
+/**
+ * Sets the NUMA topology full contexts are replicated on.
+ * The context of node 0 is generated by the CPUs of node 0 and then copied
+ * to other nodes by their own CPUs, so its pages are local to them.
+ * @param nodes         The CPUs of each node (an empty set disables replicas)
+ */
+void set_numa_nodes(const std::vector<std::vector<unsigned>>& nodes);
+
+/**
+ * Gets the DAG context for given epoch number from the process wide cache
+ * only if it's already built. It never builds nor waits for a build.
  * @param epoch_number
- * @return              A unique_ptr to the context
+ * @param full          Whether the context with the full dataset is wanted
+ * @return              A shared_ptr to the context or nullptr
+ */
+std::shared_ptr<epoch_context> find_epoch_context(uint32_t epoch_number, bool full) noexcept;
+
+/**
+ * Sets how many light and full contexts the cache keeps (least recently
+ * used ones are evicted first, replicas of each NUMA node on their own).
+ * Contexts still referenced elsewhere remain alive until released.
+ * @param light_capacity  Number of light contexts (min 1)
+ * @param full_capacity   Number of full contexts (min 1)
+ */
+void set_epoch_context_cache_capacity(size_t light_capacity, size_t full_capacity) noexcept;
+
+/**
+ * Enables the on-disk cache of epoch contexts. Built contexts are stored in
+ * a file per epoch and kind, and mapped back in (after an integrity check)
+ * instead of being built again, e.g. after a restart.
+ * @param directory     Where the files are stored (empty disables the cache)
+ * @param full          Whether full datasets are stored too (GBs per epoch)
+ * @param max_epochs    Number of files kept per kind (least recently used are removed)
+ */
+void set_epoch_context_disk_cache(const std::string& directory, bool full, size_t max_epochs);
+
+/**
+ * Sets the allocator of the memory of contexts built from now on
+ * (e.g. detail::normal_pages_allocator to avoid huge pages)
+ */
+void set_epoch_context_allocator(const context_allocator& allocator) noexcept;
+
+/**
+ * Gets the kind of memory backing the data of a context
+ */
+memory_type get_epoch_context_memory_type(const epoch_context& context) noexcept;
+
+const char* to_string(memory_type type) noexcept;
+
+/**
+ * Sets how many threads generate the full dataset
+ * @param num_threads     Number of threads (0 = all available CPUs)
+ */
+void set_dataset_build_threads(unsigned num_threads) noexcept;
+
+/**
+ * Sets the handler notified while full datasets are being generated or
+ * copied to NUMA nodes. It is called from the build threads at every 10%
+ * of progress of each build.
+ */
+void set_dataset_progress_handler(dataset_progress_handler handler);
+
+/**
+ * Gets the progress of the full dataset builds in progress, at most one
+ * per epoch and NUMA node
+ */
+std::vector<dataset_build_progress> get_dataset_build_progress();
+
+/**
+ * Sets how many dataset items computed by light lookups (i.e. share
+ * verification without the full dataset) are kept for reuse. Items are
+ * 256 bytes each; all of them are dropped on every call.
+ * @param num_items     Number of items (0 disables the cache)
+ */
+void set_dataset_item_cache_capacity(size_t num_items);
+
+/**
+ * Gets the counters of the cache of dataset items
  */
-std::shared_ptr<epoch_context> get_epoch_context(uint32_t epoch_number, bool full) noexcept;
+dataset_item_cache_stats get_dataset_item_cache_stats() noexcept;
 
 hash256 get_boundary_from_diff(const intx::uint256 difficulty) noexcept;
 
@@ -541,6 +541,113 @@ void keccakf800(uint32_t state[25])
     keccakf800_best(state);
 }
 
+#if defined(__x86_64__) && __has_attribute(target)
+typedef uint64_t uint64x4 __attribute__((vector_size(32)));
+typedef uint64_t uint64x8 __attribute__((vector_size(64)));
+
+constexpr int rho_offsets[24] = {
+    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+constexpr int pi_lanes[24] = {
+    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+/// The Keccak-f[1600] function over several states at once: word i of the
+/// state of lane k is element k of state[i].
+///
+/// The implementation based on the compact one of "tiny_sha3" by Markku-Juhani O. Saarinen,
+/// https://github.com/mjosaarinen/tiny_sha3, MIT License.
+template <typename V>
+static inline ALWAYS_INLINE void keccakf1600_lanes(V state[25])
+{
+    for (int round{0}; round < 24; ++round)
+    {
+        // Theta
+        V bc[5];
+#pragma GCC unroll 5
+        for (int i{0}; i < 5; ++i)
+            bc[i] = state[i] ^ state[i + 5] ^ state[i + 10] ^ state[i + 15] ^ state[i + 20];
+#pragma GCC unroll 5
+        for (int i{0}; i < 5; ++i)
+        {
+            const V t{bc[(i + 4) % 5] ^ (bc[(i + 1) % 5] << 1) ^ (bc[(i + 1) % 5] >> 63)};
+#pragma GCC unroll 5
+            for (int j{0}; j < 25; j += 5)
+                state[j + i] ^= t;
+        }
+
+        // Rho and Pi
+        V t{state[1]};
+#pragma GCC unroll 24
+        for (int i{0}; i < 24; ++i)
+        {
+            const int j{pi_lanes[i]};
+            const V next{state[j]};
+            state[j] = (t << rho_offsets[i]) | (t >> (64 - rho_offsets[i]));
+            t = next;
+        }
+
+        // Chi
+#pragma GCC unroll 5
+        for (int j{0}; j < 25; j += 5)
+        {
+#pragma GCC unroll 5
+            for (int i{0}; i < 5; ++i)
+                bc[i] = state[j + i];
+#pragma GCC unroll 5
+            for (int i{0}; i < 5; ++i)
+                state[j + i] ^= ~bc[(i + 1) % 5] & bc[(i + 2) % 5];
+        }
+
+        // Iota
+        state[0] ^= round_constants_64[round];
+    }
+}
+
+/// Keccak-512 of W inputs of 64 bytes: a single block each, the padding
+/// bits are at both ends of the 72 bytes rate.
+template <typename V, size_t W>
+static inline ALWAYS_INLINE void keccak512_lanes(const hash512 input[], hash512 output[])
+{
+    V state[25]{};
+    for (size_t i{0}; i < 8; ++i)
+        for (size_t k{0}; k < W; ++k)
+            state[i][k] = le::uint64(input[k].word64s[i]);
+    state[8] ^= 0x8000000000000001;
+
+    keccakf1600_lanes(state);
+
+    for (size_t i{0}; i < 8; ++i)
+        for (size_t k{0}; k < W; ++k)
+            output[k].word64s[i] = le::uint64(state[i][k]);
+}
+
+__attribute__((target("avx2"))) static void keccak512_avx2(const hash512 input[], hash512 output[])
+{
+    keccak512_lanes<uint64x4, 4>(input, output);
+}
+
+__attribute__((target("avx512f"))) static void keccak512_avx512(const hash512 input[], hash512 output[])
+{
+    keccak512_lanes<uint64x8, 8>(input, output);
+}
+#endif
+
+/// The best multi-state Keccak-512 implementations (nullptr if not available)
+/// for groups of 4 and 8 inputs, selected during runtime initialization.
+static void (*keccak512_x4_best)(const hash512[], hash512[]) = nullptr;
+static void (*keccak512_x8_best)(const hash512[], hash512[]) = nullptr;
+
+#if defined(__x86_64__) && __has_attribute(target)
+__attribute__((constructor)) static void select_keccak512_multi_implementation()
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        keccak512_x4_best = keccak512_avx2;
+    if (__builtin_cpu_supports("avx512f"))
+        keccak512_x8_best = keccak512_avx512;
+}
+#endif
+
 static inline ALWAYS_INLINE void keccak(
     uint64_t* out, size_t bits, const uint8_t* input, size_t input_size)
 {
@@ -617,4 +724,20 @@ hash512 keccak512(const hash512& input)
     return keccak512(input.bytes, sizeof(input));
 }
 
+void keccak512_multi(const hash512 input[], hash512 output[], size_t count)
+{
+    if (keccak512_x8_best)
+    {
+        for (; count >= 8; count -= 8, input += 8, output += 8)
+            keccak512_x8_best(input, output);
+    }
+    if (keccak512_x4_best)
+    {
+        for (; count >= 4; count -= 4, input += 4, output += 4)
+            keccak512_x4_best(input, output);
+    }
+    for (; count; --count, ++input, ++output)
+        *output = keccak512(*input);
+}
+
 }  // namespace ethash
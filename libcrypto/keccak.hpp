@@ -27,6 +27,10 @@ hash256 keccak256(const uint8_t* input, size_t input_size);
 hash512 keccak512(const hash512& input);
 hash512 keccak512(const uint8_t* input, size_t input_size);
 
+/// keccak512 of count inputs of 64 bytes. Groups of inputs go through
+/// multi-state (SIMD) permutations when the CPU allows. Output may alias input.
+void keccak512_multi(const hash512 input[], hash512 output[], size_t count);
+
 }  // namespace ethash
 
 #endif  // !CRYPTO_KECCAK_HPP_
@@ -6,7 +6,25 @@
 
 #include "progpow.hpp"
 #include "bitwise.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__x86_64__) && __has_attribute(target)
+#include <immintrin.h>
+#endif
 
 namespace progpow
 {
@@ -37,6 +55,286 @@ mix_rng_state::mix_rng_state(uint64_t seed) noexcept
     }
 }
 
+program::program(uint64_t period_) noexcept : period{period_}
+{
+    // Replays the very same sequence of RNG draws round() used to make
+    // on every iteration
+    mix_rng_state state{period};
+
+    size_t n{0};
+    for (uint32_t i{0}; i < std::max(kCache_count, kMath_count); ++i)
+    {
+        if (i < kCache_count)
+        {
+            auto& o{ops[n++]};
+            o.type = op_type::CacheLoad;
+            o.src1 = static_cast<uint8_t>(state.next_src());
+            o.src2 = 0;
+            o.dst = static_cast<uint8_t>(state.next_dst());
+            o.sel1 = state.rng();
+            o.sel2 = 0;
+        }
+        if (i < kMath_count)
+        {
+            // Generate 2 unique source indexes.
+            const auto src_rnd{state.rng() % (kRegs * (kRegs - 1))};
+            const auto src1{src_rnd % kRegs};  // O <= src1 < num_regs
+            auto src2{src_rnd / kRegs};        // 0 <= src2 < num_regs - 1
+            if (src2 >= src1)
+            {
+                ++src2;
+            }
+
+            auto& o{ops[n++]};
+            o.type = op_type::Math;
+            o.src1 = static_cast<uint8_t>(src1);
+            o.src2 = static_cast<uint8_t>(src2);
+            o.sel1 = state.rng();
+            o.dst = static_cast<uint8_t>(state.next_dst());
+            o.sel2 = state.rng();
+        }
+    }
+
+    for (size_t i{0}; i < kWords_per_lane; i++)
+    {
+        dag_dst[i] = (i == 0 ? 0 : state.next_dst());
+        dag_sel[i] = state.rng();
+    }
+}
+
+/**
+ * Cache of what each period needs: the decoded program (CPU hashing and
+ * verification) and the kernel sources asked for so far. Whenever a period
+ * is looked up a low priority thread generates the next ones ahead of time
+ * so period boundaries do not wait on code generation.
+ */
+struct period_slot
+{
+    uint64_t period;
+    std::shared_ptr<const program> prog;
+    std::shared_ptr<const std::string> sources[2];  // Indexed by kernel_type
+};
+
+static constexpr uint64_t periods_lookahead{2};
+static constexpr size_t periods_capacity{periods_lookahead + 4};
+
+static std::mutex periods_mutex;
+static std::condition_variable periods_cv;
+static std::list<period_slot> periods;  // Most recently used first
+static uint64_t periods_horizon{0};     // Last period to generate ahead of time
+static bool sources_wanted[2]{false, false};
+static period_cache_stats periods_stats;
+static thread_local std::shared_ptr<const program> thread_local_program;
+
+static period_slot& touch_period(uint64_t period)
+{
+    auto it{std::find_if(periods.begin(), periods.end(), [period](const period_slot& slot) {
+        return slot.period == period;
+    })};
+    if (it != periods.end())
+    {
+        periods.splice(periods.begin(), periods, it);
+    }
+    else
+    {
+        periods.push_front({period, nullptr, {}});
+        if (periods.size() > periods_capacity)
+        {
+            periods.pop_back();
+        }
+    }
+    return periods.front();
+}
+
+static void count_generation(std::chrono::steady_clock::duration elapsed)
+{
+    const auto us{static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count())};
+    ++periods_stats.generated;
+    periods_stats.generation_us += us;
+    periods_stats.max_generation_us = std::max(periods_stats.max_generation_us, us);
+}
+
+static void lower_thread_priority() noexcept
+{
+#if defined(__linux__)
+    // Under Linux the nice value is an attribute of the thread
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#elif defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#endif
+}
+
+/**
+ * Generates the missing parts of the periods up to periods_horizon
+ */
+class period_generator
+{
+public:
+    ~period_generator()
+    {
+        {
+            std::lock_guard<std::mutex> lock{periods_mutex};
+            stopping_ = true;
+        }
+        periods_cv.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    // Called with periods_mutex held. Periods already looked at are looked
+    // at again on rescan (e.g. sources of a new kind are wanted)
+    void schedule(uint64_t period, bool rescan)
+    {
+        if (rescan)
+        {
+            next_ = 0;
+        }
+        else if (period + periods_lookahead <= periods_horizon)
+        {
+            return;
+        }
+        periods_horizon = std::max(periods_horizon, period + periods_lookahead);
+        if (!thread_.joinable())
+        {
+            thread_ = std::thread(&period_generator::run, this);
+        }
+        periods_cv.notify_one();
+    }
+
+private:
+    void run()
+    {
+        lower_thread_priority();
+
+        std::unique_lock<std::mutex> lock{periods_mutex};
+        while (!stopping_)
+        {
+            // Only the periods after the last one looked up
+            next_ = std::max(next_, periods_horizon - periods_lookahead + 1);
+            if (next_ > periods_horizon)
+            {
+                periods_cv.wait(lock);
+                continue;
+            }
+
+            const uint64_t period{next_++};
+            const auto& slot{touch_period(period)};
+            const bool need_program{!slot.prog};
+            const bool need_sources[2]{
+                sources_wanted[0] && !slot.sources[0], sources_wanted[1] && !slot.sources[1]};
+
+            lock.unlock();
+            std::shared_ptr<const program> prog;
+            std::shared_ptr<const std::string> sources[2];
+            std::chrono::steady_clock::duration elapsed[3]{};
+            auto started{std::chrono::steady_clock::now()};
+            if (need_program)
+            {
+                prog = std::make_shared<const program>(period);
+                elapsed[0] = std::chrono::steady_clock::now() - started;
+            }
+            for (size_t kind{0}; kind < 2; ++kind)
+            {
+                if (need_sources[kind])
+                {
+                    started = std::chrono::steady_clock::now();
+                    sources[kind] =
+                        std::make_shared<const std::string>(getKern(period, static_cast<kernel_type>(kind)));
+                    elapsed[kind + 1] = std::chrono::steady_clock::now() - started;
+                }
+            }
+            lock.lock();
+
+            auto& stored{touch_period(period)};
+            if (prog && !stored.prog)
+            {
+                stored.prog = prog;
+                count_generation(elapsed[0]);
+            }
+            for (size_t kind{0}; kind < 2; ++kind)
+            {
+                if (sources[kind] && !stored.sources[kind])
+                {
+                    stored.sources[kind] = sources[kind];
+                    count_generation(elapsed[kind + 1]);
+                }
+            }
+        }
+    }
+
+    std::thread thread_;
+    uint64_t next_{0};  // Next period to look at
+    bool stopping_{false};
+};
+
+static period_generator periods_generator;
+
+std::shared_ptr<const program> get_program(uint64_t period)
+{
+    if (thread_local_program && thread_local_program->period == period)
+    {
+        return thread_local_program;
+    }
+
+    std::lock_guard<std::mutex> lock{periods_mutex};
+    periods_generator.schedule(period, false);
+    auto& slot{touch_period(period)};
+    if (slot.prog)
+    {
+        ++periods_stats.hits;
+    }
+    else
+    {
+        // Decoding is cheap (a few dozens of RNG draws), no need to do it
+        // outside the lock
+        ++periods_stats.misses;
+        const auto started{std::chrono::steady_clock::now()};
+        slot.prog = std::make_shared<const program>(period);
+        count_generation(std::chrono::steady_clock::now() - started);
+    }
+
+    thread_local_program = slot.prog;
+    return thread_local_program;
+}
+
+std::shared_ptr<const std::string> get_kernel_source(uint64_t period, kernel_type kern)
+{
+    const auto kind{static_cast<size_t>(kern)};
+    {
+        std::lock_guard<std::mutex> lock{periods_mutex};
+        const bool rescan{!sources_wanted[kind]};
+        sources_wanted[kind] = true;
+        periods_generator.schedule(period, rescan);
+        const auto& slot{touch_period(period)};
+        if (slot.sources[kind])
+        {
+            ++periods_stats.hits;
+            return slot.sources[kind];
+        }
+        ++periods_stats.misses;
+    }
+
+    const auto started{std::chrono::steady_clock::now()};
+    auto source{std::make_shared<const std::string>(getKern(period, kern))};
+
+    std::lock_guard<std::mutex> lock{periods_mutex};
+    auto& slot{touch_period(period)};
+    if (!slot.sources[kind])
+    {
+        slot.sources[kind] = source;
+        count_generation(std::chrono::steady_clock::now() - started);
+    }
+    return slot.sources[kind];
+}
+
+period_cache_stats get_period_cache_stats()
+{
+    std::lock_guard<std::mutex> lock{periods_mutex};
+    return periods_stats;
+}
+
 NO_SANITIZE("unsigned-integer-overflow")
 static void random_merge(uint32_t& a, uint32_t b, uint32_t sel) noexcept
 {
@@ -338,78 +636,360 @@ std::string getKern(uint64_t prog_seed, kernel_type kern)
     return ret.str();
 }
 
-using mix_t = std::array<std::array<uint32_t, kRegs>, kLanes>;
+// Mix registers of all the lanes stored register-major: all the lanes of a
+// register are contiguous so the SIMD implementations can process them at once.
+struct alignas(64) mix_t
+{
+    uint32_t regs[kRegs][kLanes];
+};
 
-static void round(const ethash::epoch_context& context, uint32_t r, mix_t& mix, mix_rng_state state)
+// Index of the DAG item round r of this mix will load.
+static inline uint32_t dag_item_index(const ethash::epoch_context& context, uint32_t r, const mix_t& mix) noexcept
 {
-    static const uint32_t l1_cache_words{ethash::kL1_cache_size / sizeof(uint32_t)};
     const uint32_t num_items{static_cast<uint32_t>(context.full_dataset_num_items / 2)};
-    const uint32_t item_index{mix.at(r % kLanes).at(0) % num_items};
-
-    // Load DAG Data
-    ethash::hash2048 item{ethash::detail::lazy_lookup_2048(context, item_index)};
+    return mix.regs[0][r % kLanes] % num_items;
+}
 
-    const auto max_operations{std::max(kCache_count, kMath_count)};
+static void round_generic(const ethash::epoch_context& context, uint32_t r, mix_t& mix, const program& prog,
+    const ethash::hash2048& item)
+{
+    auto& regs{mix.regs};
 
     // Process lanes.
-    for (unsigned i = 0; i < max_operations; ++i)
+    for (const auto& op : prog.ops)
     {
-        if (i < kCache_count)  // Random access to cached memory.
+        if (op.type == program::op_type::CacheLoad)  // Random access to cached memory.
         {
-            const auto src{state.next_src()};
-            const auto dst{state.next_dst()};
-            const auto sel{state.rng()};
-
-            for (uint64_t l{0}; l < kLanes; ++l)
+            for (size_t l{0}; l < kLanes; ++l)
             {
-                const size_t offset = mix.at(l).at(src) % ethash::kL1_cache_words;
-                random_merge(mix.at(l).at(dst), ethash::le::uint32(context.l1_cache[offset]), sel);
+                const size_t offset = regs[op.src1][l] % ethash::kL1_cache_words;
+                random_merge(regs[op.dst][l], ethash::le::uint32(context.l1_cache[offset]), op.sel1);
             }
         }
-        if (i < kMath_count)  // Random math.
+        else  // Random math.
         {
-            // Generate 2 unique source indexes.
-            const auto src_rnd{state.rng() % (kRegs * (kRegs - 1))};
-            const auto src1{src_rnd % kRegs};  // O <= src1 < num_regs
-            auto src2{src_rnd / kRegs};        // 0 <= src2 < num_regs - 1
-            if (src2 >= src1)
+            for (size_t l{0}; l < kLanes; ++l)
             {
-                ++src2;
+                const uint32_t data = random_math(regs[op.src1][l], regs[op.src2][l], op.sel1);
+                random_merge(regs[op.dst][l], data, op.sel2);
             }
+        }
+    }
+
+    // Dag access
+    for (size_t l = 0; l < kLanes; l++)
+    {
+        const auto offset = ((l ^ r) % kLanes) * kWords_per_lane;
+        for (size_t i = 0; i < kWords_per_lane; i++)
+        {
+            const auto word = ethash::le::uint32(item.word32s[offset + i]);
+            random_merge(regs[prog.dag_dst[i]][l], word, prog.dag_sel[i]);
+        }
+    }
+}
+
+/// The pointer to the best implementation of a single round,
+/// selected during runtime initialization.
+static void (*round_best)(const ethash::epoch_context&, uint32_t, mix_t&, const program&,
+    const ethash::hash2048&) = round_generic;
+
+#if defined(__x86_64__) && __has_attribute(target)
+
+// The SIMD implementations below process the 16 lanes at once applying
+// every operation to the whole row of a register.
+// All of them must be bit-exact with round_generic().
+
+static_assert(kLanes == 16, "SIMD rounds expect 16 lanes");
+static_assert((ethash::kL1_cache_words & (ethash::kL1_cache_words - 1)) == 0, "L1 cache words not a power of 2");
+
+// AVX2: every register row is held by two 8 x 32-bit vectors.
+
+__attribute__((target("avx2"))) static inline __m256i rotl_avx2(__m256i a, __m256i s)
+{
+    s = _mm256_and_si256(s, _mm256_set1_epi32(31));
+    return _mm256_or_si256(_mm256_sllv_epi32(a, s), _mm256_srlv_epi32(a, _mm256_sub_epi32(_mm256_set1_epi32(32), s)));
+}
+
+__attribute__((target("avx2"))) static inline __m256i rotr_avx2(__m256i a, __m256i s)
+{
+    s = _mm256_and_si256(s, _mm256_set1_epi32(31));
+    return _mm256_or_si256(_mm256_srlv_epi32(a, s), _mm256_sllv_epi32(a, _mm256_sub_epi32(_mm256_set1_epi32(32), s)));
+}
+
+__attribute__((target("avx2"))) static inline __m256i mul33_avx2(__m256i a)
+{
+    return _mm256_add_epi32(_mm256_slli_epi32(a, 5), a);
+}
+
+__attribute__((target("avx2"))) static inline __m256i clz_avx2(__m256i x)
+{
+    // Binary search on the leading bits: there's no lzcnt for 32 bit lanes
+    const __m256i zero{_mm256_setzero_si256()};
+    __m256i n{zero};
+    __m256i m;
+
+    m = _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(int(0xFFFF0000))), zero);
+    n = _mm256_add_epi32(n, _mm256_and_si256(m, _mm256_set1_epi32(16)));
+    x = _mm256_blendv_epi8(x, _mm256_slli_epi32(x, 16), m);
+    m = _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(int(0xFF000000))), zero);
+    n = _mm256_add_epi32(n, _mm256_and_si256(m, _mm256_set1_epi32(8)));
+    x = _mm256_blendv_epi8(x, _mm256_slli_epi32(x, 8), m);
+    m = _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(int(0xF0000000))), zero);
+    n = _mm256_add_epi32(n, _mm256_and_si256(m, _mm256_set1_epi32(4)));
+    x = _mm256_blendv_epi8(x, _mm256_slli_epi32(x, 4), m);
+    m = _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(int(0xC0000000))), zero);
+    n = _mm256_add_epi32(n, _mm256_and_si256(m, _mm256_set1_epi32(2)));
+    x = _mm256_blendv_epi8(x, _mm256_slli_epi32(x, 2), m);
+    m = _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(int(0x80000000))), zero);
+    n = _mm256_add_epi32(n, _mm256_and_si256(m, _mm256_set1_epi32(1)));
+    x = _mm256_blendv_epi8(x, _mm256_slli_epi32(x, 1), m);
+
+    // Only a zero input has still the top bit clear (clz32(0) == 32)
+    return _mm256_add_epi32(n, _mm256_srli_epi32(_mm256_xor_si256(x, _mm256_set1_epi32(-1)), 31));
+}
+
+__attribute__((target("avx2"))) static inline __m256i popcnt_avx2(__m256i x)
+{
+    x = _mm256_sub_epi32(x, _mm256_and_si256(_mm256_srli_epi32(x, 1), _mm256_set1_epi32(0x55555555)));
+    x = _mm256_add_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x33333333)),
+        _mm256_and_si256(_mm256_srli_epi32(x, 2), _mm256_set1_epi32(0x33333333)));
+    x = _mm256_and_si256(_mm256_add_epi32(x, _mm256_srli_epi32(x, 4)), _mm256_set1_epi32(0x0F0F0F0F));
+    return _mm256_srli_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(0x01010101)), 24);
+}
+
+__attribute__((target("avx2"))) static inline __m256i random_merge_avx2(__m256i a, __m256i b, uint32_t sel)
+{
+    const __m256i x{_mm256_set1_epi32(int((sel >> 16) % 31 + 1))};
+    switch (sel % 4)
+    {
+    case 0:
+        return _mm256_add_epi32(mul33_avx2(a), b);
+    case 1:
+        return mul33_avx2(_mm256_xor_si256(a, b));
+    case 2:
+        return _mm256_xor_si256(rotl_avx2(a, x), b);
+    default:
+        return _mm256_xor_si256(rotr_avx2(a, x), b);
+    }
+}
+
+__attribute__((target("avx2"))) static inline __m256i random_math_avx2(__m256i a, __m256i b, uint32_t sel)
+{
+    switch (sel % 11)
+    {
+    default:
+    case 0:
+        return _mm256_add_epi32(a, b);
+    case 1:
+        return _mm256_mullo_epi32(a, b);
+    case 2:
+    {
+        const __m256i even{_mm256_srli_epi64(_mm256_mul_epu32(a, b), 32)};
+        const __m256i odd{_mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32))};
+        return _mm256_blend_epi32(even, odd, 0xAA);
+    }
+    case 3:
+        return _mm256_min_epu32(a, b);
+    case 4:
+        return rotl_avx2(a, b);
+    case 5:
+        return rotr_avx2(a, b);
+    case 6:
+        return _mm256_and_si256(a, b);
+    case 7:
+        return _mm256_or_si256(a, b);
+    case 8:
+        return _mm256_xor_si256(a, b);
+    case 9:
+        return _mm256_add_epi32(clz_avx2(a), clz_avx2(b));
+    case 10:
+        return _mm256_add_epi32(popcnt_avx2(a), popcnt_avx2(b));
+    }
+}
 
-            const auto sel1{state.rng()};
-            const auto dst{state.next_dst()};
-            const auto sel2{state.rng()};
+__attribute__((target("avx2"))) static void round_avx2(const ethash::epoch_context& context, uint32_t r,
+    mix_t& mix, const program& prog, const ethash::hash2048& item)
+{
+    auto& regs{mix.regs};
+    const auto* l1_cache{reinterpret_cast<const int*>(context.l1_cache)};
+    const __m256i l1_mask{_mm256_set1_epi32(ethash::kL1_cache_words - 1)};
+    const __m256i lane_ids[2]{_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15)};
 
-            for (uint64_t l{0}; l < kLanes; ++l)
+    for (const auto& op : prog.ops)
+    {
+        for (size_t h{0}; h < 2; ++h)
+        {
+            auto* dst{reinterpret_cast<__m256i*>(&regs[op.dst][h * 8])};
+            const __m256i src1{_mm256_load_si256(reinterpret_cast<const __m256i*>(&regs[op.src1][h * 8]))};
+            if (op.type == program::op_type::CacheLoad)
             {
-                const uint32_t data = random_math(mix.at(l).at(src1), mix.at(l).at(src2), sel1);
-                random_merge(mix.at(l).at(dst), data, sel2);
+                const __m256i data{_mm256_i32gather_epi32(l1_cache, _mm256_and_si256(src1, l1_mask), 4)};
+                _mm256_store_si256(dst, random_merge_avx2(_mm256_load_si256(dst), data, op.sel1));
+            }
+            else
+            {
+                const __m256i src2{_mm256_load_si256(reinterpret_cast<const __m256i*>(&regs[op.src2][h * 8]))};
+                const __m256i data{random_math_avx2(src1, src2, op.sel1)};
+                _mm256_store_si256(dst, random_merge_avx2(_mm256_load_si256(dst), data, op.sel2));
             }
         }
     }
 
-    // Dag Access pattern
-    uint32_t dsts[kWords_per_lane];
-    uint32_t sels[kWords_per_lane];
-    for (size_t i = 0; i < kWords_per_lane; i++)
+    // Dag access: lane l merges the words of item's ((l ^ r) % kLanes) slice
+    for (size_t h{0}; h < 2; ++h)
     {
-        dsts[i] = (i == 0 ? 0 : state.next_dst());
-        sels[i] = state.rng();
+        const __m256i offsets{_mm256_slli_epi32(
+            _mm256_and_si256(_mm256_xor_si256(lane_ids[h], _mm256_set1_epi32(int(r))), _mm256_set1_epi32(kLanes - 1)),
+            2)};
+        for (size_t i{0}; i < kWords_per_lane; ++i)
+        {
+            const __m256i words{_mm256_i32gather_epi32(reinterpret_cast<const int*>(item.word32s),
+                _mm256_add_epi32(offsets, _mm256_set1_epi32(int(i))), 4)};
+            auto* dst{reinterpret_cast<__m256i*>(&regs[prog.dag_dst[i]][h * 8])};
+            _mm256_store_si256(dst, random_merge_avx2(_mm256_load_si256(dst), words, prog.dag_sel[i]));
+        }
     }
+}
 
-    // Dag access
-    for (size_t l = 0; l < kLanes; l++)
+// AVX-512: every register row fits a single 16 x 32-bit vector.
+
+__attribute__((target("avx512f"))) static inline __m512i mul33_avx512(__m512i a)
+{
+    return _mm512_add_epi32(_mm512_slli_epi32(a, 5), a);
+}
+
+__attribute__((target("avx512f"))) static inline __m512i popcnt_avx512(__m512i x)
+{
+    x = _mm512_sub_epi32(x, _mm512_and_si512(_mm512_srli_epi32(x, 1), _mm512_set1_epi32(0x55555555)));
+    x = _mm512_add_epi32(_mm512_and_si512(x, _mm512_set1_epi32(0x33333333)),
+        _mm512_and_si512(_mm512_srli_epi32(x, 2), _mm512_set1_epi32(0x33333333)));
+    x = _mm512_and_si512(_mm512_add_epi32(x, _mm512_srli_epi32(x, 4)), _mm512_set1_epi32(0x0F0F0F0F));
+    return _mm512_srli_epi32(_mm512_mullo_epi32(x, _mm512_set1_epi32(0x01010101)), 24);
+}
+
+__attribute__((target("avx512f"))) static inline __m512i random_merge_avx512(__m512i a, __m512i b, uint32_t sel)
+{
+    const __m512i x{_mm512_set1_epi32(int((sel >> 16) % 31 + 1))};
+    switch (sel % 4)
     {
-        const auto offset = ((l ^ r) % kLanes) * kWords_per_lane;
-        for (size_t i = 0; i < kWords_per_lane; i++)
+    case 0:
+        return _mm512_add_epi32(mul33_avx512(a), b);
+    case 1:
+        return mul33_avx512(_mm512_xor_si512(a, b));
+    case 2:
+        return _mm512_xor_si512(_mm512_rolv_epi32(a, x), b);
+    default:
+        return _mm512_xor_si512(_mm512_rorv_epi32(a, x), b);
+    }
+}
+
+__attribute__((target("avx512f,avx512cd"))) static inline __m512i random_math_avx512(
+    __m512i a, __m512i b, uint32_t sel)
+{
+    switch (sel % 11)
+    {
+    default:
+    case 0:
+        return _mm512_add_epi32(a, b);
+    case 1:
+        return _mm512_mullo_epi32(a, b);
+    case 2:
+    {
+        const __m512i even{_mm512_srli_epi64(_mm512_mul_epu32(a, b), 32)};
+        const __m512i odd{_mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32))};
+        return _mm512_mask_blend_epi32(0xAAAA, even, odd);
+    }
+    case 3:
+        return _mm512_min_epu32(a, b);
+    case 4:
+        return _mm512_rolv_epi32(a, b);
+    case 5:
+        return _mm512_rorv_epi32(a, b);
+    case 6:
+        return _mm512_and_si512(a, b);
+    case 7:
+        return _mm512_or_si512(a, b);
+    case 8:
+        return _mm512_xor_si512(a, b);
+    case 9:
+        return _mm512_add_epi32(_mm512_lzcnt_epi32(a), _mm512_lzcnt_epi32(b));
+    case 10:
+        return _mm512_add_epi32(popcnt_avx512(a), popcnt_avx512(b));
+    }
+}
+
+__attribute__((target("avx512f,avx512cd"))) static void round_avx512(const ethash::epoch_context& context,
+    uint32_t r, mix_t& mix, const program& prog, const ethash::hash2048& item)
+{
+    auto& regs{mix.regs};
+    const auto* l1_cache{context.l1_cache};
+    const __m512i l1_mask{_mm512_set1_epi32(ethash::kL1_cache_words - 1)};
+    const __m512i lane_ids{_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)};
+
+    for (const auto& op : prog.ops)
+    {
+        const __m512i src1{_mm512_load_si512(regs[op.src1])};
+        const __m512i dst{_mm512_load_si512(regs[op.dst])};
+        if (op.type == program::op_type::CacheLoad)
         {
-            const auto word = ethash::le::uint32(item.word32s[offset + i]);
-            random_merge(mix.at(l).at(dsts[i]), word, sels[i]);
+            const __m512i data{_mm512_i32gather_epi32(_mm512_and_si512(src1, l1_mask), l1_cache, 4)};
+            _mm512_store_si512(regs[op.dst], random_merge_avx512(dst, data, op.sel1));
         }
+        else
+        {
+            const __m512i data{random_math_avx512(src1, _mm512_load_si512(regs[op.src2]), op.sel1)};
+            _mm512_store_si512(regs[op.dst], random_merge_avx512(dst, data, op.sel2));
+        }
+    }
+
+    // Dag access: lane l merges the words of item's ((l ^ r) % kLanes) slice
+    const __m512i offsets{_mm512_slli_epi32(
+        _mm512_and_si512(_mm512_xor_si512(lane_ids, _mm512_set1_epi32(int(r))), _mm512_set1_epi32(kLanes - 1)), 2)};
+    for (size_t i{0}; i < kWords_per_lane; ++i)
+    {
+        const __m512i words{
+            _mm512_i32gather_epi32(_mm512_add_epi32(offsets, _mm512_set1_epi32(int(i))), item.word32s, 4)};
+        _mm512_store_si512(regs[prog.dag_dst[i]],
+            random_merge_avx512(_mm512_load_si512(regs[prog.dag_dst[i]]), words, prog.dag_sel[i]));
     }
 }
 
+__attribute__((constructor)) static void select_round_implementation()
+{
+    // Init CPU information.
+    // This is needed on macOS because of the bug: https://bugs.llvm.org/show_bug.cgi?id=48459.
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd"))
+        round_best = round_avx512;
+    else if (__builtin_cpu_supports("avx2"))
+        round_best = round_avx2;
+}
+#endif
+
+bool detail::use_round_implementation(round_implementation impl) noexcept
+{
+    switch (impl)
+    {
+    case round_implementation::generic:
+        round_best = round_generic;
+        return true;
+#if defined(__x86_64__) && __has_attribute(target)
+    case round_implementation::avx2:
+        if (!__builtin_cpu_supports("avx2"))
+            return false;
+        round_best = round_avx2;
+        return true;
+    case round_implementation::avx512:
+        if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512cd"))
+            return false;
+        round_best = round_avx512;
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
 
 static mix_t init_mix(uint64_t seed)
 {
@@ -417,19 +997,72 @@ static mix_t init_mix(uint64_t seed)
     const uint32_t w = crypto::fnv1a(z, static_cast<uint32_t>(seed >> 32));
 
     mix_t mix;
-    for (uint32_t l{0}; l < mix.size(); l++)
+    for (uint32_t l{0}; l < kLanes; l++)
     {
         const uint32_t jsr = crypto::fnv1a(w, l);
         const uint32_t jcong = crypto::fnv1a(jsr, l);
         crypto::kiss99 rng{z, w, jsr, jcong};
-        for (auto& row : mix.at(l))
+        for (uint32_t i{0}; i < kRegs; i++)
         {
-            row = rng();
+            mix.regs[i][l] = rng();
         }
     }
     return mix;
 }
 
+// Reduces the mix to the final 256-bit mix hash.
+static ethash::hash256 reduce_mix(const mix_t& mix) noexcept
+{
+    // Reduce mix data to a single per-lane result.
+    uint32_t lane_hash[kLanes];
+    for (size_t l{0}; l < kLanes; ++l)
+    {
+        lane_hash[l] = crypto::kFNV_OFFSET_BASIS;
+        for (uint32_t i{0}; i < kRegs; ++i)
+        {
+            lane_hash[l] = crypto::fnv1a(lane_hash[l], mix.regs[i][l]);
+        }
+    }
+
+    // Reduce all lanes to a single 256-bit result.
+    static const size_t num_words{sizeof(ethash::hash256) / sizeof(uint32_t)};
+    ethash::hash256 mix_hash{};
+    for (auto& w : mix_hash.word32s)
+    {
+        w = crypto::kFNV_OFFSET_BASIS;
+    }
+
+    for (size_t l{0}; l < kLanes; ++l)
+    {
+        mix_hash.word32s[l % num_words] = crypto::fnv1a(mix_hash.word32s[l % num_words], lane_hash[l]);
+    }
+
+#if __BYTE_ORDER != __LITTLE_ENDIAN
+    for (auto& w : mix_hash.word32s)
+    {
+        w = ethash::le::uint32(w);
+    }
+#endif
+
+    return mix_hash;
+}
+
+// Hints the CPU to start fetching a DAG item (only if the full dataset is available)
+static inline void prefetch_dag_item(const ethash::epoch_context& context, uint32_t index) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    if (context.full_dataset)
+    {
+        const auto* item{reinterpret_cast<const char*>(context.full_dataset) + size_t{index} * sizeof(ethash::hash2048)};
+        for (size_t offset{0}; offset < sizeof(ethash::hash2048); offset += 64)
+            __builtin_prefetch(item + offset);
+    }
+#else
+    (void)context;
+    (void)index;
+#endif
+}
+
 static const uint32_t meowcoin_meowpow[15] = {
         0x0000004D, //M
         0x00000045, //E
@@ -474,46 +1107,21 @@ ethash::hash256 hash_seed(const ethash::hash256& header_hash, uint64_t nonce) no
 
 ethash::hash256 hash_mix(const ethash::epoch_context& context, const uint32_t period, uint64_t seed)
 {
-    auto mix{init_mix(seed)};
-    mix_rng_state state(period);
-
-    for (uint32_t i{0}; i < kDag_count; ++i)
-    {
-        round(context, i, mix, state);
-    }
-
-    // Reduce mix data to a single per-lane result.
-    uint32_t lane_hash[kLanes];
-    for (size_t l{0}; l < kLanes; ++l)
-    {
-        lane_hash[l] = crypto::kFNV_OFFSET_BASIS;
-        for (uint32_t i{0}; i < kRegs; ++i)
-        {
-            lane_hash[l] = crypto::fnv1a(lane_hash[l], mix.at(l).at(i));
-        }
-    }
-
-    // Reduce all lanes to a single 256-bit result.
-    static const size_t num_words{sizeof(ethash::hash256) / sizeof(uint32_t)};
-    ethash::hash256 mix_hash{};
-    for (auto& w : mix_hash.word32s)
-    {
-        w = crypto::kFNV_OFFSET_BASIS;
-    }
+    return hash_mix(context, *get_program(period), seed);
+}
 
-    for (size_t l{0}; l < kLanes; ++l)
-    {
-        mix_hash.word32s[l % num_words] = crypto::fnv1a(mix_hash.word32s[l % num_words], lane_hash[l]);
-    }
+ethash::hash256 hash_mix(const ethash::epoch_context& context, const program& prog, uint64_t seed)
+{
+    auto mix{init_mix(seed)};
 
-#if __BYTE_ORDER != __LITTLE_ENDIAN
-    for (auto& w : mix_hash.word32s)
+    for (uint32_t r{0}; r < kDag_count; ++r)
     {
-        w = ethash::le::uint32(w);
+        // Load DAG Data
+        const ethash::hash2048 item{ethash::detail::lookup_2048(context, dag_item_index(context, r, mix))};
+        round_best(context, r, mix, prog, item);
     }
-#endif
 
-    return mix_hash;
+    return reduce_mix(mix);
 }
 
 ethash::hash256 hash_final(const ethash::hash256& input_hash, const ethash::hash256& mix_hash) noexcept
@@ -532,14 +1140,78 @@ ethash::hash256 hash_final(const ethash::hash256& input_hash, const ethash::hash
 
 ethash::result hash(
     const ethash::epoch_context& context, const uint32_t period, const ethash::hash256& header_hash, uint64_t nonce)
+{
+    return progpow::hash(context, *get_program(period), header_hash, nonce);
+}
+
+ethash::result hash(
+    const ethash::epoch_context& context, const program& prog, const ethash::hash256& header_hash, uint64_t nonce)
 {
     const ethash::hash256 seed_hash{progpow::hash_seed(header_hash, nonce)};
     const uint64_t seed_64{seed_hash.word64s[0]};
-    const ethash::hash256 mix_hash{progpow::hash_mix(context, period, seed_64)};
+    const ethash::hash256 mix_hash{progpow::hash_mix(context, prog, seed_64)};
     const ethash::hash256 final_hash{progpow::hash_final(seed_hash, mix_hash)};
     return {final_hash, mix_hash};
 }
 
+ethash::search_result search(const ethash::epoch_context& context, const uint32_t period,
+    const ethash::hash256& header_hash, const ethash::hash256& boundary, uint64_t start_nonce, size_t count)
+{
+    return progpow::search(context, *get_program(period), header_hash, boundary, start_nonce, count);
+}
+
+ethash::search_result search(const ethash::epoch_context& context, const program& prog,
+    const ethash::hash256& header_hash, const ethash::hash256& boundary, uint64_t start_nonce, size_t count)
+{
+    // Number of nonces hashed in lockstep. While one of them runs its round the
+    // DAG item of the next round of the others is already on its way to the cache.
+    constexpr size_t kBatch{4};
+
+    const uint64_t boundary_upper{ethash::be::uint64(boundary.word64s[0])};
+    ethash::hash256 seed_hash[kBatch];
+    mix_t mix[kBatch];
+
+    // Counted down rather than compared to an end nonce : a batch may end at 2^64
+    uint64_t nonce{start_nonce};
+    for (uint64_t left{count}; left; left -= std::min<uint64_t>(kBatch, left), nonce += kBatch)
+    {
+        const size_t batch{static_cast<size_t>(std::min<uint64_t>(kBatch, left))};
+
+        for (size_t k{0}; k < batch; ++k)
+        {
+            seed_hash[k] = progpow::hash_seed(header_hash, nonce + k);
+            mix[k] = init_mix(seed_hash[k].word64s[0]);
+            prefetch_dag_item(context, dag_item_index(context, 0, mix[k]));
+        }
+
+        for (uint32_t r{0}; r < kDag_count; ++r)
+        {
+            for (size_t k{0}; k < batch; ++k)
+            {
+                const ethash::hash2048 item{
+                    ethash::detail::lookup_2048(context, dag_item_index(context, r, mix[k]))};
+                round_best(context, r, mix[k], prog, item);
+                if (r + 1 < kDag_count)
+                    prefetch_dag_item(context, dag_item_index(context, r + 1, mix[k]));
+            }
+        }
+
+        for (size_t k{0}; k < batch; ++k)
+        {
+            const ethash::hash256 mix_hash{reduce_mix(mix[k])};
+            const ethash::hash256 final_hash{progpow::hash_final(seed_hash[k], mix_hash)};
+
+            // Most of the candidates are already rejected by the upper 64 bits
+            if (ethash::be::uint64(final_hash.word64s[0]) > boundary_upper)
+                continue;
+            if (ethash::is_less_or_equal(final_hash, boundary))
+                return {true, nonce + k, final_hash, mix_hash};
+        }
+    }
+
+    return {};
+}
+
 ethash::VerificationResult verify_full(const ethash::epoch_context& context, const uint32_t period,
     const ethash::hash256& header_hash, const ethash::hash256& mix_hash, uint64_t nonce,
     const ethash::hash256& boundary) noexcept
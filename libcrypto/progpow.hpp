@@ -10,6 +10,8 @@
 
 #include "ethash.hpp"
 #include "kiss99.hpp"
+#include <array>
+#include <memory>
 #include <stdint.h>
 #include <string>
 
@@ -64,15 +66,95 @@ private:
     std::array<uint32_t, kRegs> src_seq_;
 };
 
+// ProgPoW decoded program.
+//
+// The sequence of random cache loads, random math and DAG merges only depends on the
+// period, and every round of a hash executes the very same sequence. This holds it
+// fully decoded (operands and selectors) so the hashing path does not need to run the
+// KISS99 RNG at all. Instances are immutable and can be shared among threads.
+struct program
+{
+    enum class op_type : uint8_t
+    {
+        CacheLoad,  // dst = merge(dst, l1_cache[src1 % kL1_cache_words], sel1)
+        Math        // dst = merge(dst, math(src1, src2, sel1), sel2)
+    };
+
+    struct op
+    {
+        op_type type;
+        uint8_t src1;
+        uint8_t src2;
+        uint8_t dst;
+        uint32_t sel1;
+        uint32_t sel2;
+    };
+
+    explicit program(uint64_t period) noexcept;
+
+    const uint64_t period;
+    std::array<op, kCache_count + kMath_count> ops;    // Per round operations (in order)
+    std::array<uint32_t, kWords_per_lane> dag_dst;     // DAG word merge destinations
+    std::array<uint32_t, kWords_per_lane> dag_sel;     // DAG word merge selectors
+};
+
+/**
+ * Gets the decoded program for given period.
+ * Programs are built once and shared among all threads; the ones of the
+ * next periods are built ahead of time by a low priority thread.
+ * @param period        The ProgPoW period (block number / kPeriodLength)
+ * @return              A shared_ptr to the immutable program
+ */
+std::shared_ptr<const program> get_program(uint64_t period);
+
+/**
+ * Gets the kernel source of given kind for given period.
+ * Sources are generated once and shared; once a kind has been asked for,
+ * the sources of the next periods are generated ahead of time by a low
+ * priority thread.
+ * @param period        The ProgPoW period (block number / kPeriodLength)
+ * @return              A shared_ptr to the immutable source text
+ */
+std::shared_ptr<const std::string> get_kernel_source(uint64_t period, kernel_type kern);
+
+/**
+ * Counters of the cache of programs and kernel sources of periods
+ */
+struct period_cache_stats
+{
+    uint64_t hits{0};               // Lookups served from the cache
+    uint64_t misses{0};             // Lookups which had to generate on the spot
+    uint64_t generated{0};          // Programs and sources generated, ahead of time or not
+    uint64_t generation_us{0};      // Total time spent generating them
+    uint64_t max_generation_us{0};  // Longest generation
+};
+
+period_cache_stats get_period_cache_stats();
 
 std::string getKern(uint64_t seed, kernel_type kern);
 
 ethash::hash256 hash_seed(const ethash::hash256& header_hash, uint64_t nonce) noexcept;
 ethash::hash256 hash_mix(const ethash::epoch_context& context, const uint32_t period, uint64_t seed);
+ethash::hash256 hash_mix(const ethash::epoch_context& context, const program& prog, uint64_t seed);
 ethash::hash256 hash_final(const ethash::hash256& input_hash, const ethash::hash256& mix_hash) noexcept;
 
 ethash::result hash(
     const ethash::epoch_context& context, const uint32_t period, const ethash::hash256& header_hash, uint64_t nonce);
+ethash::result hash(
+    const ethash::epoch_context& context, const program& prog, const ethash::hash256& header_hash, uint64_t nonce);
+
+/**
+ * Searches a range of nonces for a solution.
+ * Nonces are hashed in small interleaved batches to overlap the DAG accesses of one
+ * with the computation of the others.
+ * @param start_nonce   The first nonce to try
+ * @param count         The number of consecutive nonces to try
+ * @return              The first solution found in the range (lowest nonce), if any
+ */
+ethash::search_result search(const ethash::epoch_context& context, const uint32_t period,
+    const ethash::hash256& header_hash, const ethash::hash256& boundary, uint64_t start_nonce, size_t count);
+ethash::search_result search(const ethash::epoch_context& context, const program& prog,
+    const ethash::hash256& header_hash, const ethash::hash256& boundary, uint64_t start_nonce, size_t count);
 
 ethash::VerificationResult verify_full(const ethash::epoch_context& context, const uint32_t period,
     const ethash::hash256& header_hash, const ethash::hash256& mix_hash, uint64_t nonce,
@@ -81,6 +163,27 @@ ethash::VerificationResult verify_full(const ethash::epoch_context& context, con
 ethash::VerificationResult verify_full(const uint64_t block_number, const ethash::hash256& header_hash,
     const ethash::hash256& mix_hash, uint64_t nonce, const ethash::hash256& boundary) noexcept;
 
+namespace detail
+{
+/**
+ * Implementations of a ProgPoW round, all bit-exact. The best one the CPU
+ * supports is selected at startup.
+ */
+enum class round_implementation
+{
+    generic,
+    avx2,
+    avx512
+};
+
+/**
+ * Makes hashes and searches use the given round implementation (tests).
+ * Not thread safe : no hash may be running meanwhile.
+ * @return  False, changing nothing, if the CPU or the build doesn't support it
+ */
+bool use_round_implementation(round_implementation impl) noexcept;
+}  // namespace detail
+
 }  // namespace progpow
 
 #endif  // !CRYPTO_PROGPOW_HPP_
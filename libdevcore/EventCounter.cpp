@@ -0,0 +1,54 @@
+#include <climits>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "EventCounter.h"
+
+using namespace std;
+using namespace dev;
+
+#if defined(__linux__)
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+#endif
+
+void EventCounter::notify() noexcept
+{
+    m_value.fetch_add(1, std::memory_order_release);
+    if (!m_sleepers.load(std::memory_order_seq_cst))
+        return;
+
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_value), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    // Sleepers check the value under the lock : taking it closes the gap
+    // between their check and their wait
+    {
+        std::lock_guard<std::mutex> l(x_wait);
+    }
+    m_wait.notify_all();
+#endif
+}
+
+void EventCounter::wait(uint32_t _seen, std::chrono::milliseconds _timeout) const noexcept
+{
+    m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+#if defined(__linux__)
+    // The kernel only puts us asleep if the value is still _seen
+    auto s = std::chrono::duration_cast<std::chrono::seconds>(_timeout);
+    struct timespec ts;
+    ts.tv_sec = s.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(_timeout - s).count();
+    syscall(SYS_futex, reinterpret_cast<uint32_t const*>(&m_value), FUTEX_WAIT_PRIVATE, _seen, &ts, nullptr, 0);
+#else
+    std::unique_lock<std::mutex> l(x_wait);
+    m_wait.wait_for(l, _timeout, [&]() { return m_value.load(std::memory_order_relaxed) != _seen; });
+#endif
+
+    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace dev
+{
+/// A counter threads can sleep on until it moves. Reading it is a single
+/// relaxed load, cheap enough for inner loops. On linux sleepers wait on a
+/// futex, elsewhere on a condition variable
+class EventCounter
+{
+public:
+    /// Current value
+    uint32_t value() const noexcept { return m_value.load(std::memory_order_relaxed); }
+
+    /// Bumps the value and wakes every sleeper. Writes made before are
+    /// visible to whoever sees the new value and issues an acquire fence
+    void notify() noexcept;
+
+    /// Sleeps till the value is no longer _seen or _timeout elapses
+    void wait(uint32_t _seen, std::chrono::milliseconds _timeout) const noexcept;
+
+private:
+    std::atomic<uint32_t> m_value = {0};
+    mutable std::atomic<unsigned> m_sleepers = {0};  // No need to wake anyone when none
+
+#if !defined(__linux__)
+    mutable std::mutex x_wait;
+    mutable std::condition_variable m_wait;
+#endif
+};
+
+}  // namespace dev
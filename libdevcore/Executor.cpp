@@ -0,0 +1,153 @@
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "Executor.h"
+#include "Log.h"
+
+using namespace std;
+using namespace dev;
+
+Mutex Executor::x_executors;
+std::vector<Executor*> Executor::s_executors;
+
+namespace
+{
+// Interval among probes
+const std::chrono::milliseconds c_probeInterval(500);
+
+void raiseThreadPriority()
+{
+#if defined(__linux__)
+    // Threads have their own nice value on linux
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), -10);
+#elif defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+#endif
+}
+
+void storeMax(std::atomic<unsigned>& _max, unsigned _value)
+{
+    unsigned current = _max.load(std::memory_order_relaxed);
+    while (_value > current &&
+           !_max.compare_exchange_weak(current, _value, std::memory_order_relaxed))
+    {
+    }
+}
+
+}  // namespace
+
+Executor::Executor(
+    std::string _name, boost::asio::io_service& _service, unsigned _threads, Priority _priority)
+  : m_name(std::move(_name)),
+    m_service(_service),
+    m_threadCount(std::max(_threads, 1U)),
+    m_priority(_priority),
+    m_probeTimer(_service)
+{
+}
+
+Executor::~Executor()
+{
+    stop();
+}
+
+void Executor::start()
+{
+    if (!m_threads.empty())
+        return;
+
+    m_work.reset(new boost::asio::io_service::work(m_service));
+    for (unsigned i = 0; i < m_threadCount; i++)
+        m_threads.emplace_back(&Executor::run, this);
+
+    m_probeTimer.expires_from_now(c_probeInterval);
+    m_probeTimer.async_wait(
+        boost::bind(&Executor::probe, this, boost::asio::placeholders::error));
+
+    Guard l(x_executors);
+    s_executors.push_back(this);
+}
+
+void Executor::stop()
+{
+    if (m_threads.empty())
+        return;
+
+    {
+        Guard l(x_executors);
+        s_executors.erase(std::remove(s_executors.begin(), s_executors.end(), this), s_executors.end());
+    }
+
+    m_work.reset();
+    m_service.stop();
+    for (auto& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+}
+
+void Executor::run()
+{
+    setThreadName(m_name.c_str());
+    if (m_priority == Priority::High)
+        raiseThreadPriority();
+
+    // One handler at a time so they can be counted
+    while (m_service.run_one())
+        m_handlers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Executor::probe(const boost::system::error_code& ec)
+{
+    if (ec)
+        return;
+
+    // Whatever has been queued meanwhile runs before the probe
+    auto posted = std::chrono::steady_clock::now();
+    uint64_t handlers = m_handlers.load(std::memory_order_relaxed);
+    m_service.post([this, posted, handlers]() {
+        unsigned queued =
+            static_cast<unsigned>(m_handlers.load(std::memory_order_relaxed) - handlers);
+        unsigned delay = static_cast<unsigned>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - posted)
+                                                   .count());
+
+        m_queued.store(queued, std::memory_order_relaxed);
+        storeMax(m_maxQueued, queued);
+        m_delayUs.store(
+            (m_delayUs.load(std::memory_order_relaxed) * 7 + delay) / 8, std::memory_order_relaxed);
+        storeMax(m_maxDelayUs, delay);
+
+        m_probeTimer.expires_from_now(c_probeInterval);
+        m_probeTimer.async_wait(
+            boost::bind(&Executor::probe, this, boost::asio::placeholders::error));
+    });
+}
+
+Executor::Stats Executor::stats() const
+{
+    Stats s;
+    s.name = m_name;
+    s.threads = m_threadCount;
+    s.handlers = m_handlers.load(std::memory_order_relaxed);
+    s.queued = m_queued.load(std::memory_order_relaxed);
+    s.maxQueued = m_maxQueued.load(std::memory_order_relaxed);
+    s.delayUs = m_delayUs.load(std::memory_order_relaxed);
+    s.maxDelayUs = m_maxDelayUs.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<Executor::Stats> Executor::allStats()
+{
+    std::vector<Stats> all;
+    Guard l(x_executors);
+    for (auto executor : s_executors)
+        all.push_back(executor->stats());
+    return all;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/bind.hpp>
+
+#include "Guards.h"
+
+namespace dev
+{
+/// Runs an io_service on thread(s) of its own. A probe is periodically
+/// posted to tell how long handlers wait in queue and how many handlers
+/// were queued ahead of it
+class Executor
+{
+public:
+    enum class Priority
+    {
+        Normal,
+        High  // Best effort : needs privileges on most systems
+    };
+
+    struct Stats
+    {
+        std::string name;
+        unsigned threads = 0;
+        uint64_t handlers = 0;     // Handlers run so far
+        unsigned queued = 0;       // Handlers ahead of the last probe
+        unsigned maxQueued = 0;
+        unsigned delayUs = 0;      // Smoothed queue wait of the probes
+        unsigned maxDelayUs = 0;
+    };
+
+    Executor(std::string _name, boost::asio::io_service& _service, unsigned _threads = 1,
+        Priority _priority = Priority::Normal);
+    ~Executor();
+
+    Executor(Executor const&) = delete;
+    Executor& operator=(Executor const&) = delete;
+
+    void start();
+    void stop();
+
+    boost::asio::io_service& service() { return m_service; }
+    Stats stats() const;
+
+    /// Stats of every started executor
+    static std::vector<Stats> allStats();
+
+private:
+    void run();
+    void probe(const boost::system::error_code& ec);
+
+    std::string m_name;
+    boost::asio::io_service& m_service;
+    unsigned m_threadCount;
+    Priority m_priority;
+
+    std::unique_ptr<boost::asio::io_service::work> m_work;
+    std::vector<std::thread> m_threads;
+    boost::asio::steady_timer m_probeTimer;
+
+    std::atomic<uint64_t> m_handlers = {0};
+    std::atomic<unsigned> m_queued = {0};
+    std::atomic<unsigned> m_maxQueued = {0};
+    std::atomic<unsigned> m_delayUs = {0};
+    std::atomic<unsigned> m_maxDelayUs = {0};
+
+    static Mutex x_executors;
+    static std::vector<Executor*> s_executors;
+};
+
+}  // namespace dev
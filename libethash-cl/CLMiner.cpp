@@ -7,11 +7,13 @@
 
 #include "CLMiner.h"
 #include "CLMiner_kernel.h"
+#include "CLProgramCache.h"
 #include <libethcore/Farm.h>
 #include <libcrypto/ethash.hpp>
 #include <libcrypto/progpow.hpp>
 
 #include "CLMiner.h"
+#include <deque>
 #include <fstream>
 #include <iostream>
 
@@ -257,14 +259,21 @@ CLMiner::CLMiner(unsigned _index, CLSettings _settings, DeviceDescriptor& _devic
   : Miner("cl-", _index), m_settings(_settings)
 {
     m_deviceDescriptor = _device;
+    if (_device.tuning.localWorkSize)
+    {
+        m_settings.localWorkSize = _device.tuning.localWorkSize;
+        m_settings.globalWorkSizeMultiplier = _device.tuning.globalWorkMultiplier;
+    }
     m_settings.localWorkSize = ((m_settings.localWorkSize + 7) / 8) * 8;
     m_settings.globalWorkSize = m_settings.localWorkSize * m_settings.globalWorkSizeMultiplier;
+    CLProgramCache::setDirectory(m_settings.binaryCacheDir, uint64_t(m_settings.binaryCacheMb) << 20);
 }
 
 CLMiner::~CLMiner()
 {
-    stopWorking();
+    triggerStopWorking();
     kick_miner();
+    stopWorking();
 }
 
 // NOTE: The following struct must match the one defined in
@@ -284,6 +293,17 @@ struct SearchResults
     uint32_t abort;
 };
 
+// A search kernel queued on the device along with the read of its results
+struct SearchBatch
+{
+    unsigned buffer = 0;                      // Index of the results buffer
+    std::shared_ptr<const WorkPackage> work;  // Work searched, shared with the other batches of the job
+    uint64_t startNonce = 0;                  // First nonce of the batch
+    uint64_t count = 0;                       // Nonces of the batch, the kernel may search past them
+    cl::Event kernel;
+    cl::Event read;
+};
+
 void CLMiner::workLoop()
 {
     // Memory for zero-ing buffers. Cannot be static or const because crashes on macOS.
@@ -291,9 +311,9 @@ void CLMiner::workLoop()
 
     uint64_t startNonce = 0;
 
-    // The work package currently processed by GPU.
-    WorkPackage current;
-    current.header = h256();
+    // The work package currently processed by GPU and its snapshot sequence
+    auto current = std::make_shared<const WorkPackage>();
+    uint64_t currentSequence = 0;
     uint64_t old_period_seed = -1;
     int old_epoch = -1;
 
@@ -304,41 +324,131 @@ void CLMiner::workLoop()
 
     try
     {
-        // Read results.
-        SearchResults results;
+        // Batches queued on the device, oldest first. Each one has its own
+        // results buffer so the next batch is queued before the results of
+        // the previous one are read and the device never waits on the host
+        std::deque<SearchBatch> batches;
+        std::vector<SearchResults> results(m_searchBuffers.size());
+        unsigned nextBuffer = 0;
+
+        // Header is written asynchronously from here
+        h256 header;
+        cl::Event headerWrite;
+
+        // Device time the last collected kernel ended at (0 = pipeline was drained)
+        cl_ulong lastKernelEnd = 0;
+
+        // Waits for the oldest batch and reports what it found
+        auto collect = [&]() {
+            SearchBatch& batch = batches.front();
+            batch.read.wait();
+            {
+                std::scoped_lock l(x_abort);
+                m_bufferSequence[batch.buffer] = 0;
+            }
+
+            SearchResults& found = results[batch.buffer];
+            uint32_t count = std::min<uint32_t>(found.count, c_maxSearchResults);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                // Nonces past a partial batch belong to another miner
+                if (found.rslt[i].gid >= batch.count)
+                    continue;
+                uint64_t nonce = batch.startNonce + found.rslt[i].gid;
+                h256 mix;
+                memcpy(mix.data(), (char*)found.rslt[i].mix, sizeof(found.rslt[i].mix));
 
-        // zero the result count
-        m_queue.enqueueWriteBuffer(m_searchBuffer, CL_TRUE, offsetof(SearchResults, count), sizeof(zerox3), zerox3);
+                WorkPackage work = *batch.work;
+                work.startNonce = batch.startNonce;
+                Farm::f().submitProof(Solution{nonce, mix, work, std::chrono::steady_clock::now(), m_index});
+
+                cllog << EthWhite << "Job: " << work.header.abridged() << " Sol: 0x" << toHex(nonce) << EthReset;
+            }
+
+            // Report hash count
+            updateHashRate(m_settings.localWorkSize, found.hashCount);
+
+            // Device idle time from the end of the previous kernel to the start of this one.
+            // Kernels of an out of order queue may overlap
+            cl_ulong kernelStart = batch.kernel.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+            if (lastKernelEnd)
+                updateKernelIdleGap(
+                    kernelStart > lastKernelEnd ? unsigned((kernelStart - lastKernelEnd) / 1000) : 0);
+            lastKernelEnd = batch.kernel.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+            batches.pop_front();
+        };
+
+        // Collects every batch in flight. Idle time until next batch is not accounted
+        auto drain = [&]() {
+            while (!batches.empty())
+                collect();
+            lastKernelEnd = 0;
+        };
+
+        // Work to process next and the generation it was picked at
+        uint32_t generation = workGeneration();
+        auto next = work();
+        uint64_t nextSequence = workSequence();
 
         while (!shouldStop())
         {
-            // no need to read the abort flag.
-            m_queue.enqueueReadBuffer(m_searchBuffer, CL_TRUE, offsetof(SearchResults, count),
-                2 * sizeof(results.count), (void*)&results.count);
-            if (results.count)
+            // Switch to new work sizes. A new local work size needs the kernel rebuilt
+            std::optional<TuningPoint> tuning;
             {
-                m_queue.enqueueReadBuffer(
-                    m_searchBuffer, CL_TRUE, 0, results.count * sizeof(results.rslt[0]), (void*)&results);
+                std::scoped_lock l(x_tuning);
+                tuning.swap(m_pendingTuning);
+            }
+            if (tuning)
+            {
+                drain();
+                m_settings.globalWorkSize = tuning->localWorkSize * tuning->globalWorkMultiplier;
+                if (tuning->localWorkSize != m_settings.localWorkSize)
+                {
+                    m_settings.localWorkSize = tuning->localWorkSize;
+                    if (m_compileThread)
+                        m_compileThread->join();
+                    m_compileThread.reset();
+                    if (old_period_seed != uint64_t(-1))
+                    {
+                        compileKernel(old_period_seed, m_program, m_searchKernel);
+                        m_nextProgpowPeriod = old_period_seed + 1;
+                        m_compileThread.reset(new std::thread([&] {
+                            try
+                            {
+                                asyncCompile();
+                            }
+                            catch (const std::exception& ex)
+                            {
+                                cllog << "Failed to compile MeowPoW kernal : " << ex.what();
+                            }
+                        }));
+                    }
+                    // Have the new kernel set up with current work
+                    currentSequence = 0;
+                }
             }
-            // clean the solution count, hash count, and abort flag
-            m_queue.enqueueWriteBuffer(
-                m_searchBuffer, CL_FALSE, offsetof(SearchResults, count), sizeof(zerox3), zerox3);
-            m_kickEnabled.store(true, std::memory_order_relaxed);
-
-            // Wait for work or 3 seconds (whichever the first)
-            bool new_work_expected{true};
 
-            const WorkPackage next = work();
-            if (!next)
+            // Only pick the work again when its generation moved
+            const uint32_t seen = workGeneration();
+            if (seen != generation)
+            {
+                generation = seen;
+                next = work();
+                nextSequence = workSequence();
+            }
+            if (!*next)
             {
-                std::unique_lock l(x_work);
-                m_new_work_signal.wait_for(l, std::chrono::milliseconds(50));
+                drain();
+                waitWork(generation);
                 continue;
             }
 
-            if (current.header != next.header)
+            // Snapshots are compared rather than headers : a job dispatched again with
+            // the same header comes with a new nonce space
+            if (currentSequence != nextSequence)
             {
-                uint64_t period_seed = next.block.value() / progpow::kPeriodLength;
+                uint64_t period_seed = next->block.value() / progpow::kPeriodLength;
                 if (m_nextProgpowPeriod == 0)
                 {
                     m_nextProgpowPeriod = period_seed;
@@ -400,16 +510,18 @@ void CLMiner::workLoop()
                     }));
                     continue;
                 }
-                if (next.epoch.has_value() && old_epoch != static_cast<int>(next.epoch.value()))
+                if (next->epoch.has_value() && old_epoch != static_cast<int>(next->epoch.value()))
                 {
+                    // Batches in flight still read the DAG
+                    drain();
                     if (!initEpoch())
                         break;  // This will simply exit the thread
-                    old_epoch = static_cast<int>(next.epoch.value());
+                    old_epoch = static_cast<int>(next->epoch.value());
                     continue;
                 }
 
                 // Upper 64 bits of the boundary.
-                const uint64_t target = (uint64_t)(u64)((u256)next.get_boundary() >> 192);
+                const uint64_t target = (uint64_t)(u64)((u256)next->get_boundary() >> 192);
                 assert(target > 0);
 
                 // If upper 64 bits of target are 0xffffffffffffffff then any nonce would
@@ -417,19 +529,29 @@ void CLMiner::workLoop()
                 if (target == UINT64_MAX)
                 {
                     cllog << "Difficulty too low for GPU. Skipping job";
+                    drain();
+                    waitWork(generation);
                     continue;
                 }
 
-                startNonce = next.startNonce;
+                startNonce = next->startNonce;
 
-                // Update header constant buffer.
-                m_queue.enqueueWriteBuffer(m_header, CL_FALSE, 0, 32, next.header.data());
+                // Update header constant buffer. An in order queue runs the write after
+                // the batches in flight, an out of order one needs a barrier
+                if (headerWrite())
+                    headerWrite.wait();
+                header = next->header;
+                if (m_settings.outOfOrder)
+                    m_queue.enqueueBarrierWithWaitList();
+                m_queue.enqueueWriteBuffer(m_header, CL_FALSE, 0, 32, header.data(), nullptr, &headerWrite);
 
-                m_searchKernel.setArg(0, m_searchBuffer);  // Supply output buffer to kernel.
-                m_searchKernel.setArg(1, m_header);        // Supply header buffer to kernel.
-                m_searchKernel.setArg(2, *m_dag);          // Supply DAG buffer to kernel.
+                m_searchKernel.setArg(1, m_header);  // Supply header buffer to kernel.
+                m_searchKernel.setArg(2, *m_dag);    // Supply DAG buffer to kernel.
                 m_searchKernel.setArg(4, target);
 
+                current = next;  // kernels now processing newest work
+                currentSequence = nextSequence;
+
 #ifdef DEV_BUILD
                 if (g_logOptions & LOG_SWITCH)
                     cllog << "Switch time: "
@@ -440,32 +562,75 @@ void CLMiner::workLoop()
 #endif
             }
 
-            // Run the kernel.
-            m_searchKernel.setArg(3, startNonce);
-            m_queue.enqueueNDRangeKernel(
-                m_searchKernel, cl::NullRange, m_settings.globalWorkSize, m_settings.localWorkSize);
+            // Bounded nonce spaces are claimed batch by batch. Once all searched
+            // the device idles till new work
+            uint64_t count = m_settings.globalWorkSize;
+            if (current->nonces && batches.size() < m_searchBuffers.size())
+            {
+                auto claimed = current->nonces->claim(m_index, count);
+                startNonce = claimed.first;
+                count = claimed.second;
+                if (!count)
+                {
+                    if (batches.empty())
+                        waitWork(generation);
+                    else
+                        collect();
+                    continue;
+                }
+            }
 
-            if (results.count)
+            if (batches.size() < m_searchBuffers.size())
             {
-                // Report results while the kernel is running.
-                for (uint32_t i = 0; i < results.count; i++)
+                // Queue one more batch : clean the solution count, hash count and abort flag
+                // of its buffer, run the kernel, then read results as soon as it completes
+                SearchBatch batch;
+                batch.buffer = nextBuffer;
+                cl::Buffer& buffer = m_searchBuffers[batch.buffer];
+
+                // From here kicks abort the batch once its work is stale, after the
+                // write clearing its buffer. Work already replaced isn't queued at all
+                std::vector<cl::Event> ready(1);
                 {
-                    uint64_t nonce = current.startNonce + results.rslt[i].gid;
-                    h256 mix;
-                    memcpy(mix.data(), (char*)results.rslt[i].mix, sizeof(results.rslt[i].mix));
+                    std::unique_lock l(x_abort);
+                    if (currentSequence != latestWorkSequence())
+                    {
+                        l.unlock();
+                        waitWork(generation);
+                        continue;
+                    }
+                    m_queue.enqueueWriteBuffer(buffer, CL_FALSE, offsetof(SearchResults, count), sizeof(zerox3),
+                        zerox3, nullptr, &ready[0]);
+                    m_bufferSequence[batch.buffer] = currentSequence;
+                    m_bufferCleared[batch.buffer] = ready[0];
+                }
+                nextBuffer = (nextBuffer + 1) % m_searchBuffers.size();
+                if (headerWrite())
+                    ready.push_back(headerWrite);
 
-                    Farm::f().submitProof(Solution{nonce, mix, current, std::chrono::steady_clock::now(), m_index});
+                m_searchKernel.setArg(0, buffer);  // Supply output buffer to kernel.
+                m_searchKernel.setArg(3, startNonce);
+                m_queue.enqueueNDRangeKernel(m_searchKernel, cl::NullRange, m_settings.globalWorkSize,
+                    m_settings.localWorkSize, &ready, &batch.kernel);
 
-                    cllog << EthWhite << "Job: " << current.header.abridged() << " Sol: 0x" << toHex(nonce) << EthReset;
-                }
+                std::vector<cl::Event> searched{batch.kernel};
+                m_queue.enqueueReadBuffer(
+                    buffer, CL_FALSE, 0, sizeof(SearchResults), &results[batch.buffer], &searched, &batch.read);
+                m_queue.flush();
+
+                batch.work = current;
+                batch.startNonce = startNonce;
+                batch.count = count;
+                // Increase start nonce for following kernel execution.
+                startNonce += m_settings.globalWorkSize;
+                batches.push_back(std::move(batch));
+
+                // Fill the pipeline before waiting on any batch
+                if (batches.size() < m_searchBuffers.size())
+                    continue;
             }
 
-            current = next;  // kernel now processing newest work
-            current.startNonce = startNonce;
-            // Increase start nonce for following kernel execution.
-            startNonce += m_settings.globalWorkSize;
-            // Report hash count
-            updateHashRate(m_settings.localWorkSize, results.hashCount);
+            collect();
         }
 
         m_queue.finish();
@@ -478,16 +643,60 @@ void CLMiner::workLoop()
     }
 }
 
+std::vector<TuningPoint> CLMiner::tuningCandidates()
+{
+    // Local work sizes are sorted so the kernel is rebuilt as little as possible
+    std::vector<TuningPoint> candidates;
+    for (unsigned local : {64, 128, 256})
+    {
+        if (local > m_deviceDescriptor.clMaxWorkGroup)
+            continue;
+        for (unsigned multiplier : {8192, 16384, 32768, 65536})
+        {
+            TuningPoint point;
+            point.localWorkSize = local;
+            point.globalWorkMultiplier = multiplier;
+            candidates.push_back(point);
+        }
+    }
+    return candidates;
+}
+
+void CLMiner::applyTuning(TuningPoint const& _point)
+{
+    if (!_point.localWorkSize || !_point.globalWorkMultiplier)
+        return;
+    {
+        std::scoped_lock l(x_tuning);
+        m_pendingTuning = _point;
+    }
+    notifyWork();
+}
+
 void CLMiner::kick_miner()
 {
-    // Memory for abort Cannot be static because crashes on macOS.
-    bool f = true;
-    if (m_kickEnabled.compare_exchange_weak(f, false, std::memory_order_relaxed))
+    // Abort the batches in flight on stale work, or all of them when stopping. Batches
+    // of the latest work keep searching the nonces they claimed. Each abort waits for
+    // the write clearing its buffer, which would reset the flag otherwise
     {
-        static const uint32_t one = 1;
-        m_abortqueue.enqueueWriteBuffer(m_searchBuffer, CL_TRUE, offsetof(SearchResults, abort), sizeof(one), &one);
+        std::scoped_lock l(x_abort);
+        const uint64_t latest = latestWorkSequence();
+        bool aborted = false;
+        for (size_t i = 0; i < m_bufferSequence.size(); i++)
+        {
+            if (!m_bufferSequence[i] || (m_bufferSequence[i] == latest && !shouldStop()))
+                continue;
+            static const uint32_t one = 1;
+            std::vector<cl::Event> cleared{m_bufferCleared[i]};
+            m_abortqueue.enqueueWriteBuffer(
+                m_searchBuffers[i], CL_FALSE, offsetof(SearchResults, abort), sizeof(one), &one, &cleared);
+            m_bufferSequence[i] = 0;
+            aborted = true;
+        }
+        if (aborted)
+            m_abortqueue.flush();
     }
-    m_new_work_signal.notify_one();
+    notifyWork();
 }
 
 void CLMiner::enumDevices(std::map<std::string, DeviceDescriptor>& _DevicesCollection)
@@ -508,6 +717,8 @@ void CLMiner::enumDevices(std::map<std::string, DeviceDescriptor>& _DevicesColle
             platformType = ClPlatformTypeEnum::Clover;
         else if (platformName == "NVIDIA CUDA")
             platformType = ClPlatformTypeEnum::Nvidia;
+        else if (platformName == "Portable Computing Language")
+            platformType = ClPlatformTypeEnum::Pocl;
         else
         {
             std::cerr << "Unrecognized platform " << platformName << std::endl;
@@ -638,15 +849,37 @@ bool CLMiner::initDevice()
 
     // create context
     m_context = cl::Context(m_device);
-    m_queue = cl::CommandQueue(m_context, m_device);
+
+    // Profiling tells the idle time of the device between search kernels
+    cl_command_queue_properties properties = CL_QUEUE_PROFILING_ENABLE;
+    if (m_settings.outOfOrder)
+    {
+        if (m_device.getInfo<CL_DEVICE_QUEUE_PROPERTIES>() & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)
+        {
+            properties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+        }
+        else
+        {
+            cllog << "Out of order queue not supported by device. Using an in order one";
+            m_settings.outOfOrder = false;
+        }
+    }
+    m_queue = cl::CommandQueue(m_context, m_device, properties);
     m_abortqueue = cl::CommandQueue(m_context, m_device);
 
     ETHCL_LOG("Creating buffers");
     // create buffer for header
     m_header = cl::Buffer(m_context, CL_MEM_READ_ONLY, 32);
 
-    // create mining buffers
-    m_searchBuffer = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(SearchResults));
+    // create mining buffers, one per batch in flight
+    {
+        std::scoped_lock l(x_abort);
+        m_searchBuffers.clear();
+        for (unsigned i = 0; i < std::max(m_settings.pipelineDepth, 1U); i++)
+            m_searchBuffers.emplace_back(m_context, CL_MEM_READ_WRITE, sizeof(SearchResults));
+        m_bufferSequence.assign(m_searchBuffers.size(), 0);
+        m_bufferCleared.assign(m_searchBuffers.size(), cl::Event());
+    }
 
     // Set Hardware Monitor Info
     if (m_deviceDescriptor.clPlatformType == ClPlatformTypeEnum::Nvidia)
@@ -661,7 +894,8 @@ bool CLMiner::initDevice()
         m_hwmoninfo.devicePciId = m_deviceDescriptor.uniqueId;
         m_hwmoninfo.deviceIndex = -1;  // Will be later on mapped by nvml (see Farm() constructor)
     }
-    else if (m_deviceDescriptor.clPlatformType == ClPlatformTypeEnum::Clover)
+    else if (m_deviceDescriptor.clPlatformType == ClPlatformTypeEnum::Clover ||
+             m_deviceDescriptor.clPlatformType == ClPlatformTypeEnum::Pocl)
     {
         m_hwmoninfo.deviceType = HwMonitorInfoType::UNKNOWN;
         m_hwmoninfo.devicePciId = m_deviceDescriptor.uniqueId;
@@ -701,7 +935,9 @@ bool CLMiner::initDevice()
     s << " Memory : " << dev::getFormattedMemory((double)m_deviceDescriptor.totalMemory);
     cllog << s.str();
 
-    if ((m_deviceDescriptor.clPlatformType == ClPlatformTypeEnum::Amd) && (m_deviceDescriptor.clMaxComputeUnits != 36))
+    // Tuned work sizes have been measured on this very device
+    if ((m_deviceDescriptor.clPlatformType == ClPlatformTypeEnum::Amd) && (m_deviceDescriptor.clMaxComputeUnits != 36) &&
+        !m_deviceDescriptor.tuning.localWorkSize)
     {
         m_settings.globalWorkSize = (m_settings.globalWorkSize * m_deviceDescriptor.clMaxComputeUnits) / 36;
         // make sure that global work size is evenly divisible by the local workgroup size
@@ -838,7 +1074,7 @@ void CLMiner::asyncCompile()
 
 void CLMiner::compileKernel(uint64_t period_seed, cl::Program& program, cl::Kernel& searchKernel)
 {
-    std::string code = progpow::getKern(period_seed, progpow::kernel_type::OpenCL);
+    std::string code = *progpow::get_kernel_source(period_seed, progpow::kernel_type::OpenCL);
     code += std::string(CLMiner_kernel);
 
     addDefinition(code, "GROUP_SIZE", m_settings.localWorkSize);
@@ -888,17 +1124,60 @@ void CLMiner::compileKernel(uint64_t period_seed, cl::Program& program, cl::Kern
     write.close();
 #endif
 
-    // create miner OpenCL program
-    cl::Program::Sources sources{code.data()};
-    program = cl::Program(m_context, sources);
-    try
+    // Builds the program from source, false on failure
+    auto buildSource = [&]() {
+        cl::Program::Sources sources{code.data()};
+        program = cl::Program(m_context, sources);
+        try
+        {
+            program.build({m_device}, m_options);
+        }
+        catch (cl::BuildError const& buildErr)
+        {
+            cwarn << "OpenCL kernel build log:\n" << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(m_device);
+            cwarn << "OpenCL kernel build error (" << buildErr.err() << "):\n" << buildErr.what();
+            return false;
+        }
+        return true;
+    };
+
+    // create miner OpenCL program. Devices of the same model and driver share one
+    // build, which is also kept on disk if a cache directory is set
+    const std::string key = CLProgramCache::key(code,
+        m_deviceDescriptor.clPlatformName + "/" + m_deviceDescriptor.clName, m_device.getInfo<CL_DRIVER_VERSION>(),
+        m_options);
+    // A binary the device rejects is dropped and built again from source, which
+    // caches the fresh binary in its place
+    bool built = false;
+    bool ready = false;
+    for (unsigned attempt = 0; attempt < 2 && !built && !ready; attempt++)
     {
-        program.build({m_device}, m_options);
+        CLProgramCache::Binary binary = CLProgramCache::get(key, [&]() {
+            built = true;
+            ready = buildSource();
+            return ready ? program.getInfo<CL_PROGRAM_BINARIES>().at(0) : CLProgramCache::Binary();
+        });
+        if (built)
+            break;
+        try
+        {
+            std::vector<cl::Device> devices{m_device};
+            cl::Program::Binaries binaries{binary};
+            program = cl::Program(m_context, devices, binaries);
+            program.build(devices, m_options);
+            ready = true;
+        }
+        catch (cl::Error const& err)
+        {
+            cwarn << ethCLErrorHelper("Cached OpenCL kernel binary rejected", err);
+            CLProgramCache::drop(key);
+        }
     }
-    catch (cl::BuildError const& buildErr)
+    // Another miner cached a binary rejected again : don't insist
+    if (!built && !ready)
+        ready = buildSource();
+    if (!ready)
     {
-        cwarn << "OpenCL kernel build log:\n" << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(m_device);
-        cwarn << "OpenCL kernel build error (" << buildErr.err() << "):\n" << buildErr.what();
         pause(MinerPauseEnum::PauseDueToInitEpochError);
         return;
     }
@@ -907,5 +1186,5 @@ void CLMiner::compileKernel(uint64_t period_seed, cl::Program& program, cl::Kern
     searchKernel.setArg(1, m_header);
     searchKernel.setArg(5, 0);
 
-    cllog << "Pre-compiled period " << period_seed << " OpenCL MeowPoW kernal";
+    cllog << "Pre-compiled period " << period_seed << " OpenCL MeowPoW kernal" << (built ? "" : " (cached)");
 }
@@ -48,6 +48,9 @@ public:
 
     static void enumDevices(std::map<std::string, DeviceDescriptor>& _DevicesCollection);
 
+    std::vector<TuningPoint> tuningCandidates() override;
+    void applyTuning(TuningPoint const& _point) override;
+
 protected:
     bool initDevice() override;
 
@@ -69,7 +72,13 @@ private:
     cl::Kernel m_dagKernel;
     cl::Device m_device;
     cl::Buffer m_header;
-    cl::Buffer m_searchBuffer;
+    std::vector<cl::Buffer> m_searchBuffers;  // One per search batch in flight
+
+    // Work sequence of the batch on each search buffer (0 when none or aborted) and
+    // the write clearing the buffer before it. Kicks abort stale batches only
+    std::mutex x_abort;
+    std::vector<uint64_t> m_bufferSequence;
+    std::vector<cl::Event> m_bufferCleared;
 
     cl::Buffer* m_dag = nullptr;
     cl::Buffer* m_light = nullptr;
@@ -83,7 +92,9 @@ private:
     char m_options[256] = {0};
     int m_computeCapability = 0;
 
-    std::atomic<bool> m_kickEnabled = {false};
+    // Work sizes to switch to, picked up by the work loop
+    std::mutex x_tuning;
+    std::optional<TuningPoint> m_pendingTuning;
 
 };
 
@@ -0,0 +1,250 @@
+/// Cache of built OpenCL program binaries.
+///
+/// @file
+/// @copyright GNU General Public License
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <libcrypto/keccak.hpp>
+#include <libdevcore/CommonData.h>
+
+#include "CLProgramCache.h"
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+// A cached file is this header followed by the binary
+const char c_magic[8] = {'M', 'E', 'O', 'W', 'C', 'L', 'B', 0};
+const uint32_t c_version = 1;
+const char c_prefix[] = "meowpow-cl-";
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t size;             // Bytes of the binary
+    ethash::hash256 checksum;  // keccak256 of the binary
+};
+
+// A program being looked up or built
+struct Entry
+{
+    std::mutex mutex;
+    bool done = false;
+    CLProgramCache::Binary binary;
+};
+
+std::mutex s_mutex;
+std::filesystem::path s_directory;  // Empty when disabled
+uint64_t s_maxBytes = 0;
+
+// Programs in use. Entries go away with their last user
+std::map<std::string, std::weak_ptr<Entry>> s_entries;
+
+std::filesystem::path filePath(std::filesystem::path const& _directory, std::string const& _key)
+{
+    return _directory / (c_prefix + _key + ".bin");
+}
+
+ethash::hash256 checksum(CLProgramCache::Binary const& _binary)
+{
+    return ethash::keccak256(_binary.data(), _binary.size());
+}
+
+// Reads a binary back. Files which are truncated or don't match their
+// checksum are removed
+CLProgramCache::Binary load(std::filesystem::path const& _path)
+{
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(_path, ec);
+    if (ec)
+        return {};
+
+    CLProgramCache::Binary binary;
+    FileHeader header;
+    std::ifstream file(_path, std::ios::binary);
+    bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                 memcmp(header.magic, c_magic, sizeof(c_magic)) == 0 && header.version == c_version &&
+                 header.size && fileSize == sizeof(header) + header.size;
+    if (valid)
+    {
+        binary.resize(header.size);
+        valid = file.read(reinterpret_cast<char*>(binary.data()), binary.size()) &&
+                ethash::is_equal(header.checksum, checksum(binary));
+    }
+    file.close();
+
+    if (!valid)
+    {
+        std::filesystem::remove(_path, ec);
+        return {};
+    }
+
+    // Recently used files are the last ones to be evicted
+    std::filesystem::last_write_time(_path, std::filesystem::file_time_type::clock::now(), ec);
+    return binary;
+}
+
+// Keeps the most recently used files within the given size
+void evict(std::filesystem::path const& _directory, uint64_t _maxBytes)
+{
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+
+    std::error_code ec;
+    for (auto const& entry : std::filesystem::directory_iterator(_directory, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, sizeof(c_prefix) - 1, c_prefix) != 0 || entry.path().extension() != ".bin")
+            continue;
+        files.emplace_back(entry.last_write_time(ec), entry.path());
+    }
+
+    std::sort(files.begin(), files.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+    uint64_t total = 0;
+    for (auto const& file : files)
+    {
+        total += std::filesystem::file_size(file.second, ec);
+        if (total > _maxBytes)
+            std::filesystem::remove(file.second, ec);
+    }
+}
+
+// Writes the binary aside then renames it so readers never see it partial.
+// Failures are not fatal : the binary simply won't be cached
+void store(std::filesystem::path const& _directory, uint64_t _maxBytes, std::string const& _key,
+    CLProgramCache::Binary const& _binary)
+{
+    if (sizeof(FileHeader) + _binary.size() > _maxBytes)
+        return;
+
+    FileHeader header{};
+    memcpy(header.magic, c_magic, sizeof(c_magic));
+    header.version = c_version;
+    header.size = _binary.size();
+    header.checksum = checksum(_binary);
+
+    std::error_code ec;
+    std::filesystem::create_directories(_directory, ec);
+
+    std::filesystem::path path = filePath(_directory, _key);
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(_binary.data()), _binary.size());
+        if (!file.flush())
+        {
+            file.close();
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmpPath, ec);
+        return;
+    }
+
+    evict(_directory, _maxBytes);
+}
+
+}  // namespace
+
+void CLProgramCache::setDirectory(std::string const& _directory, uint64_t _maxBytes)
+{
+    std::lock_guard<std::mutex> l(s_mutex);
+    s_directory = _directory;
+    s_maxBytes = _maxBytes;
+}
+
+std::string CLProgramCache::key(
+    std::string const& _source, std::string const& _device, std::string const& _driver, std::string const& _options)
+{
+    // Sizes go along so parts can't be shifted into each other
+    std::string material;
+    for (auto part : {&_source, &_device, &_driver, &_options})
+    {
+        material += std::to_string(part->size());
+        material += ':';
+        material += *part;
+    }
+    ethash::hash256 digest =
+        ethash::keccak256(reinterpret_cast<const uint8_t*>(material.data()), material.size());
+    return toHex(std::vector<uint8_t>(digest.bytes, digest.bytes + 16));
+}
+
+CLProgramCache::Binary CLProgramCache::get(std::string const& _key, std::function<Binary()> const& _build)
+{
+    std::shared_ptr<Entry> entry;
+    std::filesystem::path directory;
+    uint64_t maxBytes;
+    {
+        std::lock_guard<std::mutex> l(s_mutex);
+        for (auto it = s_entries.begin(); it != s_entries.end();)
+            it = it->second.expired() ? s_entries.erase(it) : std::next(it);
+        entry = s_entries[_key].lock();
+        if (!entry)
+        {
+            entry = std::make_shared<Entry>();
+            s_entries[_key] = entry;
+        }
+        directory = s_directory;
+        maxBytes = s_maxBytes;
+    }
+
+    // Whoever comes first loads or builds, others wait for it
+    std::lock_guard<std::mutex> l(entry->mutex);
+    if (!entry->done)
+    {
+        if (!directory.empty())
+            entry->binary = load(filePath(directory, _key));
+        if (entry->binary.empty())
+        {
+            entry->binary = _build();
+            if (!entry->binary.empty() && !directory.empty())
+                store(directory, maxBytes, _key, entry->binary);
+        }
+        entry->done = !entry->binary.empty();
+    }
+    return entry->binary;
+}
+
+void CLProgramCache::drop(std::string const& _key)
+{
+    std::shared_ptr<Entry> entry;
+    std::filesystem::path directory;
+    {
+        std::lock_guard<std::mutex> l(s_mutex);
+        auto it = s_entries.find(_key);
+        if (it != s_entries.end())
+            entry = it->second.lock();
+        directory = s_directory;
+    }
+
+    if (entry)
+    {
+        std::lock_guard<std::mutex> l(entry->mutex);
+        entry->done = false;
+        entry->binary.clear();
+    }
+    if (!directory.empty())
+    {
+        std::error_code ec;
+        std::filesystem::remove(filePath(directory, _key), ec);
+    }
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,44 @@
+/// Cache of built OpenCL program binaries.
+///
+/// @file
+/// @copyright GNU General Public License
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+/// Binaries of built OpenCL programs, so a program is built once per
+/// source, device model, driver and build options. Miners asking for the
+/// same program at once share one build. When a directory is set binaries
+/// are also stored on disk and reused by next runs
+class CLProgramCache
+{
+public:
+    using Binary = std::vector<unsigned char>;
+
+    /// Sets the directory of the disk store (empty disables it) and the
+    /// size it may take. Least recently used binaries are evicted first
+    static void setDirectory(std::string const& _directory, uint64_t _maxBytes);
+
+    /// Digest of everything the binary of a program depends on
+    static std::string key(std::string const& _source, std::string const& _device, std::string const& _driver,
+        std::string const& _options);
+
+    /// Returns the binary of the program with the given key, running _build
+    /// on a miss. Callers with the same key wait for the first one's build.
+    /// _build returns an empty binary when it fails, which is not cached
+    static Binary get(std::string const& _key, std::function<Binary()> const& _build);
+
+    /// Forgets a binary the device could not load
+    static void drop(std::string const& _key);
+};
+
+}  // namespace eth
+}  // namespace dev
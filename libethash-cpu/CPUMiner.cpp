@@ -34,10 +34,7 @@ along with ethminer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <boost/version.hpp>
 
-#if 0
-#include <boost/fiber/numa/pin_thread.hpp>
-#include <boost/fiber/numa/topology.hpp>
-#endif
+#include <fstream>
 
 #include "CPUMiner.h"
 
@@ -101,18 +98,7 @@ static size_t getTotalPhysAvailableMemory()
  */
 unsigned CPUMiner::getNumDevices()
 {
-#if 0
-    static unsigned cpus = 0;
-
-    if (cpus == 0)
-    {
-        std::vector< boost::fibers::numa::node > topo = boost::fibers::numa::topology();
-        for (auto n : topo) {
-            cpus += n.logical_cpus.size();
-        }
-    }
-    return cpus;
-#elif defined(__APPLE__) || defined(__MACOSX)
+#if defined(__APPLE__) || defined(__MACOSX)
 #error "TODO: Function CPUMiner::getNumDevices() on MAXOSX not implemented"
 #elif defined(__linux__)
     long cpus_available;
@@ -131,6 +117,62 @@ unsigned CPUMiner::getNumDevices()
 #endif
 }
 
+/*
+ * Parses a sysfs cpu list (eg "0-7,16-23")
+ */
+static std::vector<unsigned> parseCpuList(const std::string& list)
+{
+    std::vector<unsigned> cpus;
+    std::istringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        try
+        {
+            auto dash = range.find('-');
+            unsigned first = std::stoul(range.substr(0, dash));
+            unsigned last = (dash == std::string::npos ? first : std::stoul(range.substr(dash + 1)));
+            for (unsigned cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        catch (const std::exception&)
+        {
+            // Ignore malformed ranges (eg trailing newline)
+        }
+    }
+    return cpus;
+}
+
+/*
+ * returns the CPUs of each NUMA node (nodes are renumbered from 0 skipping
+ * the ones without CPUs). Empty if the system is not NUMA.
+ */
+static std::vector<std::vector<unsigned>> getNumaNodes()
+{
+    std::vector<std::vector<unsigned>> nodes;
+#if defined(__linux__)
+    for (unsigned node = 0; node < 1024; node++)
+    {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!f)
+        {
+            // Node ids may have holes but are dense in practice
+            if (node > 64)
+                break;
+            continue;
+        }
+        std::string list;
+        std::getline(f, list);
+        auto cpus = parseCpuList(list);
+        if (!cpus.empty())
+            nodes.push_back(cpus);
+    }
+#endif
+    if (nodes.size() < 2)
+        nodes.clear();
+    return nodes;
+}
+
 
 /* ######################## CPU Miner ######################## */
 
@@ -146,14 +188,16 @@ CPUMiner::CPUMiner(unsigned _index, CPSettings _settings, DeviceDescriptor& _dev
   : Miner("cpu-", _index), m_settings(_settings)
 {
     m_deviceDescriptor = _device;
+    m_batchSize = _device.tuning.batchSize ? _device.tuning.batchSize : std::max(m_settings.batchSize, 1U);
 }
 
 
 CPUMiner::~CPUMiner()
 {
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::~CPUMiner() begin");
-    stopWorking();
+    triggerStopWorking();
     kick_miner();
+    stopWorking();
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::~CPUMiner() end");
 }
 
@@ -166,7 +210,8 @@ bool CPUMiner::initDevice()
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::initDevice begin");
 
     cpulog << "Using CPU: " << m_deviceDescriptor.cpCpuNumer << " " << m_deviceDescriptor.cuName
-           << " Memory : " << dev::getFormattedMemory((double)m_deviceDescriptor.totalMemory);
+           << " Memory : " << dev::getFormattedMemory((double)m_deviceDescriptor.totalMemory)
+           << " NUMA node : " << m_deviceDescriptor.cpNumaNode;
 
 #if defined(__APPLE__) || defined(__MACOSX)
 #error "TODO: Function CPUMiner::initDevice() on MAXOSX not implemented"
@@ -221,45 +266,79 @@ bool CPUMiner::initEpoch_internal()
 */
 void CPUMiner::kick_miner()
 {
-    m_new_work.store(true, std::memory_order_relaxed);
-    m_new_work_signal.notify_one();
+    notifyWork();
+}
+
+
+std::vector<TuningPoint> CPUMiner::tuningCandidates()
+{
+    // Small batches switch jobs fast, large ones check for new work less often
+    std::vector<TuningPoint> candidates;
+    for (unsigned batch : {16, 32, 64, 128, 256, 512})
+    {
+        TuningPoint point;
+        point.batchSize = batch;
+        candidates.push_back(point);
+    }
+    return candidates;
+}
+
+
+void CPUMiner::applyTuning(TuningPoint const& _point)
+{
+    if (_point.batchSize)
+        m_batchSize.store(_point.batchSize, std::memory_order_relaxed);
 }
 
 
-void CPUMiner::search(const dev::eth::WorkPackage& w)
+void CPUMiner::search(const dev::eth::WorkPackage& w, uint32_t _generation)
 {
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::search() begin");
-    constexpr size_t blocksize = 64;
 
-    const auto context{ethash::get_epoch_context(w.epoch.value(), true)};
+    // Each NUMA node has its own copy of the DAG
+    const auto context{ethash::get_epoch_context(w.epoch.value(), true, m_deviceDescriptor.cpNumaNode)};
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::search() context loaded");
+    if (m_index == 0 && m_contextEpoch != context->epoch_number)
+    {
+        m_contextEpoch = context->epoch_number;
+        cpulog << "Epoch #" << context->epoch_number << " DAG in "
+               << ethash::to_string(ethash::get_epoch_context_memory_type(*context));
+    }
 
     auto header{ethash::from_bytes(w.header.data())};
     auto boundary{ethash::from_bytes(w.get_boundary().data())};
-    auto period{w.block.value() / progpow::kPeriodLength};
+    const auto program{progpow::get_program(w.block.value() / progpow::kPeriodLength)};
     auto nonce{w.startNonce};
     bool found{false};
 
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::search() search loop");
-    while (m_new_work.load(std::memory_order_relaxed) == false && !found)
+    while (workGeneration() == _generation && !found)
     {
-        // Do the search
-        for (size_t i{0}; i < blocksize; i++, nonce++)
+        size_t blocksize{m_batchSize.load(std::memory_order_relaxed)};
+
+        // Bounded nonce spaces are claimed batch by batch till all searched
+        if (w.nonces)
         {
-            auto result{progpow::hash(*context, period, header, nonce)};
-            if (ethash::is_less_or_equal(result.final_hash, boundary))
-            {
-                h256 mix{reinterpret_cast<::byte*>(result.mix_hash.bytes), h256::ConstructFromPointer};
-                h256 fin{reinterpret_cast<::byte*>(result.final_hash.bytes), h256::ConstructFromPointer};
-                Solution sol{nonce, mix, w, std::chrono::steady_clock::now(), m_index};
-                cpulog << EthWhite << "Job: " << w.header.abridged() << " Sol: " << toHex(sol.nonce, HexPrefix::Add)
-                       << EthReset;
-                Farm::f().submitProof(sol);
-                found = true;
+            auto claimed{w.nonces->claim(m_index, blocksize)};
+            if (!claimed.second)
                 break;
-            }
+            nonce = claimed.first;
+            blocksize = claimed.second;
         }
 
+        // Do the search
+        auto result{progpow::search(*context, *program, header, boundary, nonce, blocksize)};
+        if (result.solution_found)
+        {
+            h256 mix{reinterpret_cast<::byte*>(result.mix_hash.bytes), h256::ConstructFromPointer};
+            Solution sol{result.nonce, mix, w, std::chrono::steady_clock::now(), m_index};
+            cpulog << EthWhite << "Job: " << w.header.abridged() << " Sol: " << toHex(sol.nonce, HexPrefix::Add)
+                   << EthReset;
+            FarmFace::f().submitProof(sol);
+            found = true;
+        }
+        nonce += blocksize;
+
         // Update the hash rate
         updateHashRate(blocksize, 1);
     }
@@ -275,37 +354,28 @@ void CPUMiner::workLoop()
 {
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::workLoop() begin");
 
-    WorkPackage current;
-    current.header = h256();
-
     if (!initDevice())
     {
         return;
     }
 
+    uint64_t searched = 0;  // Sequence of the work last searched
+
     while (!shouldStop())
     {
-        // Wait for work
-        bool new_work_expected{true};
-        if (!m_new_work.compare_exchange_strong(new_work_expected, false))
-        {
-            std::unique_lock l(x_work);
-            m_new_work_signal.wait_for(l, std::chrono::milliseconds(50));
-            continue;
-        }
-
-        const WorkPackage w = work();
-        if (!w)
+        // Generation is read first : work published meanwhile moves it
+        const uint32_t generation = workGeneration();
+        const auto w = work();
+
+        // Search each work once, till new work or a solution, then wait for
+        // new work. Waits time out : searching the same work again would
+        // find the same solution again
+        if (*w && workSequence() != searched)
         {
-            continue;
+            searched = workSequence();
+            search(*w, generation);
         }
-
-        // Persist most recent job.
-        // Job's differences should be handled at higher level
-        current = w;
-
-        // Start searching
-        search(w);
+        waitWork(generation);
     }
 
     DEV_BUILD_LOG_PROGRAMFLOW(cpulog, "cp-" << m_index << " CPUMiner::workLoop() end");
@@ -316,6 +386,10 @@ void CPUMiner::enumDevices(std::map<string, DeviceDescriptor>& _DevicesCollectio
 {
     unsigned numDevices = getNumDevices();
 
+    // Full DAGs get replicated on each NUMA node
+    auto numaNodes = getNumaNodes();
+    ethash::set_numa_nodes(numaNodes);
+
     for (unsigned i = 0; i < numDevices; i++)
     {
         string uniqueId;
@@ -339,6 +413,12 @@ void CPUMiner::enumDevices(std::map<string, DeviceDescriptor>& _DevicesCollectio
         deviceDescriptor.totalMemory = getTotalPhysAvailableMemory();
 
         deviceDescriptor.cpCpuNumer = i;
+        deviceDescriptor.cpNumaNode = 0;
+        for (unsigned node = 0; node < numaNodes.size(); node++)
+        {
+            if (std::find(numaNodes[node].begin(), numaNodes[node].end(), i) != numaNodes[node].end())
+                deviceDescriptor.cpNumaNode = node;
+        }
 
         _DevicesCollection[uniqueId] = deviceDescriptor;
     }
@@ -21,6 +21,7 @@ along with ethminer.  If not, see <http://www.gnu.org/licenses/>.
 #include <libethcore/Miner.h>
 
 #include <functional>
+#include <optional>
 
 namespace dev
 {
@@ -35,7 +36,10 @@ public:
     static unsigned getNumDevices();
     static void enumDevices(std::map<std::string, DeviceDescriptor>& _DevicesCollection);
 
-    void search(const dev::eth::WorkPackage& w);
+    void search(const dev::eth::WorkPackage& w, uint32_t _generation);
+
+    std::vector<TuningPoint> tuningCandidates() override;
+    void applyTuning(TuningPoint const& _point) override;
 
 protected:
     bool initDevice() override;
@@ -43,7 +47,8 @@ protected:
     void kick_miner() override;
 
 private:
-    std::atomic<bool> m_new_work = {false};
+    std::optional<uint32_t> m_contextEpoch;  // Epoch of the DAG last reported in log
+    std::atomic<unsigned> m_batchSize;       // Nonces searched between two checks for new work
     void workLoop() override;
     CPSettings m_settings;
 };
@@ -49,8 +49,9 @@ CUDAMiner::CUDAMiner(unsigned _index, CUSettings _settings, DeviceDescriptor& _d
 
 CUDAMiner::~CUDAMiner()
 {
-    stopWorking();
+    triggerStopWorking();
     kick_miner();
+    stopWorking();
 }
 
 bool CUDAMiner::initDevice()
@@ -205,18 +206,13 @@ void CUDAMiner::workLoop()
     {
         while (!shouldStop())
         {
-            // Wait for work
-            bool new_work_expected{true};
-            if (!m_new_work.compare_exchange_strong(new_work_expected, false))
-            {
-                std::unique_lock l(x_work);
-                m_new_work_signal.wait_for(l, std::chrono::milliseconds(50));
-                continue;
-            }
-
-            const WorkPackage w = work();
+            // Generation is read first : work published meanwhile moves it
+            const uint32_t generation = workGeneration();
+            const auto next = work();
+            const WorkPackage& w = *next;
             if (!w)
             {
+                waitWork(generation);
                 continue;
             }
             if (w.epoch.has_value() && old_epoch != static_cast<int>(w.epoch.value()))
@@ -226,7 +222,7 @@ void CUDAMiner::workLoop()
                     break;  // This will simply exit the thread
                 }
                 old_epoch = static_cast<int>(w.epoch.value());
-                if (m_new_work.load())
+                if (workGeneration() != generation)
                 {
                     continue;
                 }
@@ -298,7 +294,8 @@ void CUDAMiner::workLoop()
             uint64_t upper64OfBoundary = (uint64_t)(u64)((u256)w.get_boundary() >> 192);
 
             // Eventually start searching
-            search(current.header.data(), upper64OfBoundary, current.startNonce, w);
+            search(current.header.data(), upper64OfBoundary, current.startNonce, w, generation);
+            waitWork(generation);
         }
 
         // Reset miner and stop working
@@ -314,8 +311,7 @@ void CUDAMiner::workLoop()
 
 void CUDAMiner::kick_miner()
 {
-    m_new_work.store(true, std::memory_order_relaxed);
-    m_new_work_signal.notify_one();
+    notifyWork();
 }
 
 int CUDAMiner::getNumDevices()
@@ -407,7 +403,7 @@ void CUDAMiner::compileKernel(uint64_t period_seed, uint64_t dag_elms, CUfunctio
 {
     const char* name = "meowpow_search";
 
-    std::string text = progpow::getKern(period_seed, progpow::kernel_type::Cuda);
+    std::string text = *progpow::get_kernel_source(period_seed, progpow::kernel_type::Cuda);
     text += std::string(CUDAMiner_kernel);
 
     std::string tmpDir;
@@ -498,7 +494,8 @@ void CUDAMiner::compileKernel(uint64_t period_seed, uint64_t dag_elms, CUfunctio
             << to_string(m_deviceDescriptor.cuComputeMajor) << '.' << to_string(m_deviceDescriptor.cuComputeMinor);
 }
 
-void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_nonce, const dev::eth::WorkPackage& w)
+void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_nonce, const dev::eth::WorkPackage& w,
+    uint32_t _generation)
 {
     set_header(*reinterpret_cast<hash32_t const*>(header));
     if (m_current_target != target)
@@ -521,10 +518,32 @@ void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_no
 
     auto search_start = std::chrono::steady_clock::now();
 
+    // First nonce and nonces of the batch each stream runs (0 = idle). Bounded
+    // nonce spaces are claimed batch by batch, the kernel may search past them
+    std::vector<uint64_t> stream_nonces(m_settings.streams, 0);
+    std::vector<uint64_t> stream_counts(m_settings.streams, 0);
+    auto claim = [&](uint32_t _stream) {
+        if (w.nonces)
+        {
+            auto claimed = w.nonces->claim(m_index, m_batch_size);
+            stream_nonces[_stream] = claimed.first;
+            stream_counts[_stream] = claimed.second;
+        }
+        else
+        {
+            stream_nonces[_stream] = start_nonce;
+            stream_counts[_stream] = m_batch_size;
+            start_nonce += m_batch_size;
+        }
+        return stream_counts[_stream] != 0;
+    };
+
     // prime each stream, clear search result buffers and start the search
     uint32_t current_index;
-    for (current_index = 0; current_index < m_settings.streams; current_index++, start_nonce += m_batch_size)
+    for (current_index = 0; current_index < m_settings.streams; current_index++)
     {
+        if (!claim(current_index))
+            break;
         cudaStream_t stream = m_streams[current_index];
         volatile Search_results& buffer(*m_search_buf[current_index]);
         buffer.count = 0;
@@ -532,7 +551,8 @@ void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_no
         // Run the batch for this stream
         volatile Search_results* Buffer = &buffer;
         bool hack_false = false;
-        void* args[] = {&start_nonce, &current_header, &m_current_target, &dag, &Buffer, &hack_false};
+        void* args[] = {
+            &stream_nonces[current_index], &current_header, &m_current_target, &dag, &Buffer, &hack_false};
         CU_SAFE_CALL(cuLaunchKernel(m_kernel[m_kernelExecIx],  //
             m_settings.gridSize, 1, 1,                         // grid dim
             m_settings.blockSize, 1, 1,                        // block dim
@@ -551,28 +571,32 @@ void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_no
     while (!done)
     {
         // Exit next time around if there's new work awaiting
-        done = (done || m_new_work.load() || paused());
+        done = (done || workGeneration() != _generation || paused());
 
         //// Check on every batch if we need to suspend mining
         // if (!done)
         //    done = paused();
 
         // This inner loop will process each cuda stream individually
-        for (current_index = 0; current_index < m_settings.streams; current_index++, start_nonce += m_batch_size)
+        uint32_t searched = 0;
+        for (current_index = 0; current_index < m_settings.streams; current_index++)
         {
             // Each pass of this loop will wait for a stream to exit,
             // save any found solutions, then restart the stream
             // on the next group of nonces.
+            if (!stream_counts[current_index])
+                continue;
+            searched++;
             cudaStream_t stream = m_streams[current_index];
+            uint64_t nonce_base = stream_nonces[current_index];
+            uint64_t nonce_count = stream_counts[current_index];
+            stream_counts[current_index] = 0;
 
             // Wait for the stream complete
             CUDA_SAFE_CALL(cudaStreamSynchronize(stream));
 
             if (shouldStop())
-            {
-                m_new_work.store(false, std::memory_order_relaxed);
                 done = true;
-            }
 
             // Detect solutions in current stream's solution buffer
             volatile Search_results& buffer(*m_search_buf[current_index]);
@@ -594,11 +618,12 @@ void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_no
 
             // restart the stream on the next batch of nonces
             // unless we are done for this round.
-            if (!done)
+            if (!done && claim(current_index))
             {
                 volatile Search_results* Buffer = &buffer;
                 bool hack_false = false;
-                void* args[] = {&start_nonce, &current_header, &m_current_target, &dag, &Buffer, &hack_false};
+                void* args[] = {
+                    &stream_nonces[current_index], &current_header, &m_current_target, &dag, &Buffer, &hack_false};
                 CU_SAFE_CALL(cuLaunchKernel(m_kernel[m_kernelExecIx],  //
                     m_settings.gridSize, 1, 1,                         // grid dim
                     m_settings.blockSize, 1, 1,                        // block dim
@@ -608,9 +633,11 @@ void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_no
             }
             if (found_count)
             {
-                uint64_t nonce_base = start_nonce - m_streams_batch_size;
                 for (uint32_t i = 0; i < found_count; i++)
                 {
+                    // Nonces past a partial batch belong to another miner
+                    if (gids[i] >= nonce_count)
+                        continue;
                     uint64_t nonce = nonce_base + gids[i];
                     Farm::f().submitProof(Solution{nonce, mixHashes[i], w, std::chrono::steady_clock::now(), m_index});
 
@@ -625,14 +652,15 @@ void CUDAMiner::search(uint8_t const* header, uint64_t target, uint64_t start_no
         }
 
         // Update the hash rate
-        updateHashRate(m_batch_size, m_settings.streams);
+        updateHashRate(m_batch_size, searched);
+
+        // Whole nonce space searched : idle till new work
+        if (!searched)
+            break;
 
         // Bail out if it's shutdown time
         if (shouldStop())
-        {
-            m_new_work.store(false, std::memory_order_relaxed);
             break;
-        }
     }
 
 #ifdef DEV_BUILD
@@ -37,8 +37,8 @@ public:
     static int getNumDevices();
     static void enumDevices(std::map<std::string, DeviceDescriptor>& _DevicesCollection);
 
-    void search(
-        uint8_t const* header, uint64_t target, uint64_t _startN, const dev::eth::WorkPackage& w);
+    void search(uint8_t const* header, uint64_t target, uint64_t _startN, const dev::eth::WorkPackage& w,
+        uint32_t _generation);
 
 protected:
     bool initDevice() override;
@@ -48,8 +48,6 @@ protected:
     void kick_miner() override;
 
 private:
-    std::atomic<bool> m_new_work = {false};
-
     void workLoop() override;
 
     uint8_t m_kernelCompIx = 0;
@@ -0,0 +1,337 @@
+/*
+ This file is part of ethminer.
+
+ ethminer is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ethminer is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with ethminer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+
+#include <boost/dll.hpp>
+
+#include <json/json.h>
+
+#include "Autotuner.h"
+#include "Farm.h"
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+// Time left to miners to settle on new work sizes before measuring
+const std::chrono::milliseconds c_settleTime(2000);
+
+// Interval among the jobs handed to miners while measuring
+const std::chrono::milliseconds c_jobInterval(1000);
+
+// Fewer CPU threads are kept if they get this close to the best hashrate
+const double c_threadsTolerance = 0.98;
+
+}  // namespace
+
+Autotuner::Autotuner(AutotunerSettings _settings) : Worker("tuner"), m_settings(std::move(_settings)) {}
+
+Autotuner::~Autotuner()
+{
+    stopWorking();
+}
+
+std::string Autotuner::profilePath(std::string const& _profile)
+{
+    if (!_profile.empty())
+        return _profile;
+    return (boost::dll::program_location().parent_path() / "tuning.json").string();
+}
+
+std::map<std::string, TuningPoint> Autotuner::loadProfile(std::string const& _profile)
+{
+    std::map<std::string, TuningPoint> points;
+
+    std::ifstream file(profilePath(_profile));
+    Json::Value root;
+    Json::Reader jRdr;
+    if (!file || !jRdr.parse(file, root) || !root.isObject() || !root["devices"].isObject())
+        return points;
+
+    Json::Value const& devices = root["devices"];
+    for (auto const& id : devices.getMemberNames())
+    {
+        Json::Value const& device = devices[id];
+        if (!device.isObject())
+            continue;
+        TuningPoint point;
+        point.globalWorkMultiplier = device.get("global_work", 0).asUInt();
+        point.localWorkSize = device.get("local_work", 0).asUInt();
+        point.batchSize = device.get("batch", 0).asUInt();
+        point.enabled = device.get("enabled", true).asBool();
+        points[id] = point;
+    }
+    return points;
+}
+
+void Autotuner::workLoop()
+{
+    // Miners are ready once they hash : DAG generated and kernels built
+    cnote << "Autotuner waiting for miners to start hashing ...";
+    std::vector<std::shared_ptr<Miner>> miners;
+    while (!shouldStop())
+    {
+        miners = Farm::f().getMiners();
+        bool ready = !miners.empty();
+        for (auto const& miner : miners)
+            ready = ready && (miner->paused() || miner->hashCount());
+        if (ready)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    if (shouldStop())
+        return;
+
+    std::vector<std::vector<TuningPoint>> candidates;
+    size_t steps = 0;
+    for (auto const& miner : miners)
+    {
+        candidates.push_back(miner->paused() ? std::vector<TuningPoint>() : miner->tuningCandidates());
+        steps = std::max(steps, candidates.back().size());
+    }
+    if (!steps)
+    {
+        cwarn << "Autotuner found no device it can tune";
+        if (m_onFinished)
+            m_onFinished();
+        return;
+    }
+
+    cnote << "Autotuning " << steps << " work sizes for " << m_settings.seconds << " seconds each";
+
+    // Devices are tuned side by side, each through its own candidates
+    std::vector<std::vector<Sample>> samples(miners.size());
+    for (size_t step = 0; step < steps; step++)
+    {
+        for (size_t i = 0; i < miners.size(); i++)
+            if (step < candidates[i].size())
+                miners[i]->applyTuning(candidates[i][step]);
+
+        auto measured = measure(miners);
+        if (measured.empty())
+            return;
+
+        for (size_t i = 0; i < miners.size(); i++)
+        {
+            if (step >= candidates[i].size())
+                continue;
+            samples[i].push_back(measured[i]);
+            cnote << miners[i]->name() << " " << candidates[i][step].str() << " : "
+                  << dev::getFormattedHashes(measured[i].hashrate) << ", job switch "
+                  << boost::format("%.1f") % measured[i].latencyMs << " ms";
+        }
+    }
+
+    std::vector<TuningPoint> best(miners.size());
+    std::vector<Sample> bestSamples(miners.size());
+    std::vector<bool> tuned(miners.size(), false);
+    std::vector<size_t> cpus;
+    for (size_t i = 0; i < miners.size(); i++)
+    {
+        if (samples[i].empty())
+            continue;
+        size_t index = pick(samples[i]);
+        best[i] = candidates[i][index];
+        bestSamples[i] = samples[i][index];
+        tuned[i] = true;
+        miners[i]->applyTuning(best[i]);
+        if (miners[i]->getDescriptor().type == DeviceTypeEnum::Cpu)
+            cpus.push_back(i);
+    }
+
+    // CPU threads share caches and memory bandwidth : more of them does not
+    // always mean more hashes. Try halving them
+    if (cpus.size() > 1)
+    {
+        size_t bestThreads = cpus.size();
+        double bestRate = 0;
+        std::vector<std::pair<size_t, double>> rates;
+        for (size_t threads = cpus.size(); threads; threads /= 2)
+        {
+            for (size_t k = 0; k < cpus.size(); k++)
+            {
+                if (k < threads)
+                    miners[cpus[k]]->resume(MinerPauseEnum::PauseDueToAutotune);
+                else
+                    miners[cpus[k]]->pause(MinerPauseEnum::PauseDueToAutotune);
+            }
+
+            auto measured = measure(miners);
+            if (measured.empty())
+                return;
+
+            double rate = 0;
+            for (size_t k = 0; k < threads; k++)
+                rate += measured[cpus[k]].hashrate;
+            rates.emplace_back(threads, rate);
+            bestRate = std::max(bestRate, rate);
+            cnote << "CPU threads " << threads << " : " << dev::getFormattedHashes(rate);
+        }
+
+        for (auto const& rate : rates)
+            if (rate.second >= bestRate * c_threadsTolerance)
+                bestThreads = rate.first;
+
+        for (size_t k = 0; k < cpus.size(); k++)
+        {
+            best[cpus[k]].enabled = k < bestThreads;
+            miners[cpus[k]]->resume(MinerPauseEnum::PauseDueToAutotune);
+        }
+    }
+
+    for (size_t i = 0; i < miners.size(); i++)
+    {
+        if (!tuned[i])
+            continue;
+        cnote << "Best for " << miners[i]->name() << " (" << miners[i]->getDescriptor().uniqueId
+              << ") : " << best[i].str() << (best[i].enabled ? "" : ", not worth a thread") << " "
+              << dev::getFormattedHashes(bestSamples[i].hashrate) << ", job switch "
+              << boost::format("%.1f") % bestSamples[i].latencyMs << " ms";
+    }
+
+    save(miners, best, bestSamples, tuned);
+
+    if (m_onFinished)
+        m_onFinished();
+}
+
+std::vector<Autotuner::Sample> Autotuner::measure(std::vector<std::shared_ptr<Miner>> const& _miners)
+{
+    if (!run(c_settleTime))
+        return {};
+
+    std::vector<uint64_t> hashes;
+    std::vector<std::pair<unsigned, uint64_t>> switches;
+    for (auto const& miner : _miners)
+    {
+        hashes.push_back(miner->hashCount());
+        switches.push_back(miner->workSwitches());
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    if (!run(std::chrono::seconds(m_settings.seconds)))
+        return {};
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<Sample> samples(_miners.size());
+    for (size_t i = 0; i < _miners.size(); i++)
+    {
+        auto now = _miners[i]->workSwitches();
+        unsigned count = now.first - switches[i].first;
+        samples[i].hashrate = (_miners[i]->hashCount() - hashes[i]) / elapsed;
+
+        // A miner which never switched is as slow as the whole window
+        samples[i].latencyMs = count ? (now.second - switches[i].second) / 1000.0 / count : elapsed * 1000;
+    }
+    return samples;
+}
+
+bool Autotuner::run(std::chrono::milliseconds _duration)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto end = now + _duration;
+    auto nextJob = now;
+    while (now < end)
+    {
+        if (shouldStop())
+            return false;
+        if (now >= nextJob)
+        {
+            WorkPackage wp = Farm::f().getWork();
+            if (wp)
+            {
+                wp.header = h256::random();
+                Farm::f().setWork(wp);
+            }
+            nextJob += c_jobInterval;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        now = std::chrono::steady_clock::now();
+    }
+    return true;
+}
+
+size_t Autotuner::pick(std::vector<Sample> const& _samples) const
+{
+    // If none switches in time, the one switching the fastest
+    size_t best = 0;
+    bool inTime = false;
+    for (size_t i = 0; i < _samples.size(); i++)
+    {
+        bool ok = _samples[i].latencyMs <= m_settings.maxLatencyMs;
+        if (ok && (!inTime || _samples[i].hashrate > _samples[best].hashrate))
+            best = i;
+        else if (!ok && !inTime && _samples[i].latencyMs < _samples[best].latencyMs)
+            best = i;
+        inTime = inTime || ok;
+    }
+    return best;
+}
+
+void Autotuner::save(std::vector<std::shared_ptr<Miner>> const& _miners, std::vector<TuningPoint> const& _points,
+    std::vector<Sample> const& _samples, std::vector<bool> const& _tuned)
+{
+    std::string path = profilePath(m_settings.profile);
+
+    // Devices tuned in other runs are kept
+    Json::Value root;
+    {
+        std::ifstream file(path);
+        Json::Reader jRdr;
+        if (!file || !jRdr.parse(file, root) || !root.isObject())
+            root = Json::Value(Json::objectValue);
+    }
+    if (!root["devices"].isObject())
+        root["devices"] = Json::Value(Json::objectValue);
+
+    for (size_t i = 0; i < _miners.size(); i++)
+    {
+        if (!_tuned[i])
+            continue;
+        auto descriptor = _miners[i]->getDescriptor();
+        Json::Value device;
+        device["name"] = descriptor.name;
+        if (_points[i].localWorkSize)
+        {
+            device["global_work"] = _points[i].globalWorkMultiplier;
+            device["local_work"] = _points[i].localWorkSize;
+        }
+        if (_points[i].batchSize)
+        {
+            device["batch"] = _points[i].batchSize;
+            device["enabled"] = _points[i].enabled;
+        }
+        device["hashrate"] = _samples[i].hashrate;
+        device["switch_latency_ms"] = _samples[i].latencyMs;
+        root["devices"][descriptor.uniqueId] = device;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::ofstream file(path, std::ios::trunc);
+    file << Json::writeString(builder, root) << std::endl;
+    if (file)
+        cnote << "Tuning profile saved to " << path;
+    else
+        cwarn << "Could not save tuning profile to " << path;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,98 @@
+/*
+ This file is part of ethminer.
+
+ ethminer is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ethminer is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with ethminer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libdevcore/Worker.h>
+
+#include <libethcore/Miner.h>
+
+namespace dev
+{
+namespace eth
+{
+struct AutotunerSettings
+{
+    bool enabled = false;          // Whether or not to run the autotuner
+    std::string profile;           // Tuning profile file (empty = next to the binary)
+    unsigned seconds = 10;         // Measurement time of each work size
+    unsigned maxLatencyMs = 100;   // Slowest acceptable work switch
+};
+
+/**
+ * @brief Sweeps the work sizes of miners while they run a simulation,
+ * measuring hashrate and how long they take to switch to a new job.
+ * Best work sizes are stored per device in a tuning profile which is
+ * loaded on next runs
+ */
+class Autotuner : public Worker
+{
+public:
+    Autotuner(AutotunerSettings _settings);
+    ~Autotuner() override;
+
+    /**
+     * @brief Called once tuning is over (or given up)
+     */
+    void onFinished(std::function<void()> const& _handler) { m_onFinished = _handler; }
+
+    /**
+     * @brief Path of the tuning profile for the given setting
+     */
+    static std::string profilePath(std::string const& _profile);
+
+    /**
+     * @brief Reads the work sizes of each device (by uniqueId) from a profile.
+     * A missing or unreadable profile gives none
+     */
+    static std::map<std::string, TuningPoint> loadProfile(std::string const& _profile);
+
+private:
+    struct Sample
+    {
+        double hashrate = 0;   // Hashes per second
+        double latencyMs = 0;  // Mean work switch latency
+    };
+
+    void workLoop() override;
+
+    // Runs miners for a while, then tells their hashrate and work switch latency.
+    // Empty if asked to stop meanwhile
+    std::vector<Sample> measure(std::vector<std::shared_ptr<Miner>> const& _miners);
+
+    // Runs for the given time handing miners a new job every second, as pools do
+    bool run(std::chrono::milliseconds _duration);
+
+    // Index of the fastest sample switching jobs within the latency limit
+    size_t pick(std::vector<Sample> const& _samples) const;
+
+    void save(std::vector<std::shared_ptr<Miner>> const& _miners, std::vector<TuningPoint> const& _points,
+        std::vector<Sample> const& _samples, std::vector<bool> const& _tuned);
+
+    AutotunerSettings m_settings;
+    std::function<void()> m_onFinished;
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -38,6 +38,18 @@ namespace eth
 {
 Farm* Farm::m_this = nullptr;
 
+namespace
+{
+void storeMax(std::atomic<unsigned>& _max, unsigned _value)
+{
+    unsigned current = _max.load(std::memory_order_relaxed);
+    while (_value > current && !_max.compare_exchange_weak(current, _value, std::memory_order_relaxed))
+    {
+    }
+}
+
+}  // namespace
+
 Farm::Farm(std::map<std::string, DeviceDescriptor>& _DevicesCollection, FarmSettings _settings, CUSettings _CUSettings,
     CLSettings _CLSettings, CPSettings _CPSettings)
   : m_Settings(std::move(_settings)),
@@ -45,7 +57,7 @@ Farm::Farm(std::map<std::string, DeviceDescriptor>& _DevicesCollection, FarmSett
     m_CLSettings(std::move(_CLSettings)),
     m_CPSettings(std::move(_CPSettings)),
     m_io_strand(g_io_service),
-    m_collectTimer(g_io_service),
+    m_collectTimer(g_api_io_service),
     m_DevicesCollection(_DevicesCollection)
 {
     m_this = this;
@@ -142,6 +154,43 @@ Farm::Farm(std::map<std::string, DeviceDescriptor>& _DevicesCollection, FarmSett
         }
     }
 
+    if (m_Settings.noHugePages)
+        ethash::set_epoch_context_allocator(ethash::detail::normal_pages_allocator);
+
+    // Contexts of epochs already built are mapped from disk instead
+    ethash::set_epoch_context_disk_cache(m_Settings.dagCacheDir, m_Settings.dagCacheFull, m_Settings.dagCacheEpochs);
+
+    // Contexts of recent epochs are kept in memory to switch back to them quickly
+    ethash::set_epoch_context_cache_capacity(m_Settings.dagContexts, m_Settings.dagContextsFull);
+
+    // DAG items computed while verifying solutions may be kept for reuse
+    ethash::set_dataset_item_cache_capacity((size_t(m_Settings.verifyCacheMb) << 20) / sizeof(ethash::hash2048));
+
+    // Full DAG generation (CPU mining) is split among threads and
+    // its progress is logged every 10%
+    ethash::set_dataset_build_threads(m_CPSettings.dagThreads);
+    // Node 0 generates the DAG, other NUMA nodes copy it
+    ethash::set_dataset_progress_handler([](const ethash::dataset_build_progress& progress) {
+        if (progress.building)
+        {
+            if (progress.numa_node)
+                cnote << "Copying DAG for epoch #" << progress.epoch_number << " to NUMA node "
+                      << progress.numa_node << " : " << progress.percent() << "% ETA " << progress.eta().count()
+                      << " s";
+            else
+                cnote << "Generating DAG for epoch #" << progress.epoch_number << " : " << progress.percent()
+                      << "% ETA " << progress.eta().count() << " s";
+            return;
+        }
+        auto elapsed{std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - progress.started)};
+        if (progress.numa_node)
+            cnote << "DAG for epoch #" << progress.epoch_number << " copied to NUMA node " << progress.numa_node
+                  << " in " << elapsed.count() << " ms.";
+        else
+            cnote << "DAG for epoch #" << progress.epoch_number << " generated in " << elapsed.count() << " ms.";
+    });
+
     // Initialize nonce_scrambler
     shuffle();
 
@@ -149,8 +198,7 @@ Farm::Farm(std::map<std::string, DeviceDescriptor>& _DevicesCollection, FarmSett
     // It should work for the whole lifetime of Farm
     // regardless it's mining state
     m_collectTimer.expires_from_now(boost::posix_time::milliseconds(m_collectInterval));
-    m_collectTimer.async_wait(
-        m_io_strand.wrap(boost::bind(&Farm::collectData, this, boost::asio::placeholders::error)));
+    m_collectTimer.async_wait(boost::bind(&Farm::collectData, this, boost::asio::placeholders::error));
 }
 
 Farm::~Farm()
@@ -200,38 +248,156 @@ void Farm::setWork(WorkPackage const& _newWp)
 
     if (!m_currentEc || m_currentEc->epoch_number != _newWp.epoch.value())
     {
-        m_currentEc.reset();
-        m_currentEc = ethash::get_epoch_context(_newWp.epoch.value(), false);
-        for (auto const& miner : m_miners)
-            miner->setEpoch(m_currentEc);
+        auto ec = ethash::find_epoch_context(_newWp.epoch.value(), false);
+        if (!ec)
+        {
+            // Building the context takes a while: do it aside and let
+            // miners go on with their last job meanwhile
+            m_pendingWp = _newWp;
+            buildEpochContextAsync(_newWp.epoch.value());
+            return;
+        }
+        switchEpoch(ec);
+    }
+
+    // A job for the current epoch obsoletes any deferred one
+    m_pendingWp = WorkPackage();
+    dispatchWork(_newWp);
+}
+
+void Farm::buildEpochContextAsync(uint32_t _epoch)
+{
+    // Only one build at a time. When it completes the most recent
+    // deferred job decides what to do next
+    if (m_epochBuilding.has_value())
+        return;
+
+    cnote << "Building light cache for epoch #" << _epoch << ". Jobs deferred until done";
+    m_epochBuilding.emplace(_epoch);
+    m_epochBuilder = std::async(std::launch::async, [this, _epoch]() {
+        auto ec = ethash::get_epoch_context(_epoch, false);
+        g_io_service.post(m_io_strand.wrap(boost::bind(&Farm::onEpochContextReady, this, ec)));
+    });
+}
+
+void Farm::onEpochContextReady(std::shared_ptr<ethash::epoch_context> _ec)
+{
+    Guard l(x_minerWork);
+    m_epochBuilding.reset();
+
+    // Deferred job may have been obsoleted meanwhile
+    if (!m_pendingWp)
+        return;
+
+    if (m_pendingWp.epoch.value() != _ec->epoch_number)
+    {
+        buildEpochContextAsync(m_pendingWp.epoch.value());
+        return;
     }
 
+    switchEpoch(_ec);
+    WorkPackage wp = m_pendingWp;
+    m_pendingWp = WorkPackage();
+    dispatchWork(wp);
+}
+
+void Farm::switchEpoch(std::shared_ptr<ethash::epoch_context> const& _ec)
+{
+    m_currentEc = _ec;
+    cnote << "Epoch #" << m_currentEc->epoch_number << " light cache in "
+          << ethash::to_string(ethash::get_epoch_context_memory_type(*m_currentEc));
+    for (auto const& miner : m_miners)
+        miner->setEpoch(m_currentEc);
+}
+
+void Farm::dispatchWork(WorkPackage const& _newWp)
+{
+    // Miners account their dispatch latency from here
+    auto published = std::chrono::steady_clock::now();
     m_currentWp = _newWp;
 
+    {
+        // Shares of jobs prior to a clean one are of no use anymore
+        Guard l(x_liveJobs);
+        if (_newWp.clean)
+        {
+            m_liveJobs.clear();
+            m_liveJobsOrder.clear();
+        }
+        if (m_liveJobs.insert(_newWp.header).second)
+        {
+            m_liveJobsOrder.push_back(_newWp.header);
+            if (m_liveJobsOrder.size() > c_maxLiveJobs)
+            {
+                m_liveJobs.erase(m_liveJobsOrder.front());
+                m_liveJobsOrder.pop_front();
+            }
+        }
+    }
+
     // Check if we need to shuffle per work (ergodicity == 2)
     if (m_Settings.ergodicity == 2 && m_currentWp.exSizeBytes == 0)
         shuffle();
 
+    // Nonces are shared out in proportion to the hashrate of miners
     uint64_t _startNonce;
+    std::vector<uint64_t> sizes;
     if (m_currentWp.exSizeBytes > 0)
     {
-        // Equally divide the residual segment among miners
+        // Divide the residual segment among miners. It may be small : miners
+        // done with their slice steal from the others
         _startNonce = m_currentWp.startNonce;
-        m_nonce_segment_with = (unsigned int)log2(pow(2, 64 - (m_currentWp.exSizeBytes * 4)) / m_miners.size());
+        unsigned bits = 64 - std::min(m_currentWp.exSizeBytes * 4, 64);
+        sizes = NonceSpace::split(u128(1) << bits, minerWeights());
+        m_currentWp.nonces = std::make_shared<NonceSpace>(_startNonce, sizes);
     }
     else
     {
         // Get the randomly selected nonce
         _startNonce = m_nonce_scrambler;
+        sizes = NonceSpace::split(u128(m_miners.size()) << m_nonce_segment_with, minerWeights());
+        m_currentWp.nonces.reset();
     }
 
+    m_nonceSegments.clear();
+    uint64_t offset = 0;
     for (unsigned int i = 0; i < m_miners.size(); i++)
     {
-        m_currentWp.startNonce = _startNonce + ((uint64_t)i << m_nonce_segment_with);
-        m_miners.at(i)->setWork(m_currentWp);
+        m_currentWp.startNonce = _startNonce + offset;
+        m_nonceSegments.emplace_back(m_currentWp.startNonce, sizes[i]);
+        offset += sizes[i];
+        m_miners.at(i)->setWork(m_currentWp, published);
     }
 }
 
+std::vector<uint64_t> Farm::minerWeights()
+{
+    // Miners not measured yet (just started, generating DAG) are deemed average
+    std::vector<uint64_t> weights;
+    uint64_t measured = 0, total = 0;
+    for (auto const& miner : m_miners)
+    {
+        weights.push_back(uint64_t(miner->RetrieveHashRate()));
+        if (weights.back())
+        {
+            measured++;
+            total += weights.back();
+        }
+    }
+    for (auto& weight : weights)
+        if (!weight)
+            weight = measured ? std::max<uint64_t>(total / measured, 1) : 1;
+    return weights;
+}
+
+std::pair<uint64_t, uint64_t> Farm::getNonceSegment(unsigned _index)
+{
+    Guard l(x_minerWork);
+    if (_index >= m_nonceSegments.size())
+        return {m_nonce_scrambler + ((uint64_t)_index << m_nonce_segment_with), uint64_t(1) << m_nonce_segment_with};
+    return m_nonceSegments[_index];
+}
+
 /**
  * @brief Start a number of miners.
  */
@@ -274,7 +440,10 @@ bool Farm::start()
 #endif
             if (minerTelemetry.prefix.empty())
                 continue;
-            m_telemetry.miners.push_back(minerTelemetry);
+            {
+                Guard t(x_telemetry);
+                m_telemetry.miners.push_back(minerTelemetry);
+            }
             m_miners.back()->startWorking();
         }
 
@@ -388,6 +557,7 @@ bool Farm::reboot(const std::vector<std::string>& args)
  */
 void Farm::accountSolution(unsigned _minerIdx, SolutionAccountingEnum _accounting)
 {
+    Guard l(x_telemetry);
     if (_accounting == SolutionAccountingEnum::Accepted)
     {
         m_telemetry.farm.solutions.accepted++;
@@ -422,12 +592,20 @@ void Farm::accountSolution(unsigned _minerIdx, SolutionAccountingEnum _accountin
     }
 }
 
+void Farm::accountLatency(unsigned _minerIdx, std::chrono::milliseconds const& _findToAck)
+{
+    Guard l(x_telemetry);
+    m_telemetry.farm.solutions.latency.add(_findToAck);
+    m_telemetry.miners.at(_minerIdx).solutions.latency.add(_findToAck);
+}
+
 /**
  * @brief Gets the solutions account for the whole farm
  */
 
 SolutionAccountType Farm::getSolutions()
 {
+    Guard l(x_telemetry);
     return m_telemetry.farm.solutions;
 }
 
@@ -436,6 +614,7 @@ SolutionAccountType Farm::getSolutions()
  */
 SolutionAccountType Farm::getSolutions(unsigned _minerIdx)
 {
+    Guard l(x_telemetry);
     try
     {
         return m_telemetry.miners.at(_minerIdx).solutions;
@@ -468,17 +647,35 @@ void Farm::setTStartTStop(unsigned tstart, unsigned tstop)
 
 void Farm::submitProof(Solution const& _s)
 {
-    g_io_service.post(m_io_strand.wrap(boost::bind(&Farm::submitProofAsync, this, _s)));
+    // Verified in parallel, submitted in sequence
+    uint64_t seq = m_proofsQueued.fetch_add(1, std::memory_order_relaxed);
+    storeMax(m_verifyMaxQueued,
+        unsigned(seq + 1 - m_proofsSubmitted.load(std::memory_order_relaxed)));
+    g_verify_io_service.post(
+        boost::bind(&Farm::submitProofAsync, this, _s, seq, std::chrono::steady_clock::now()));
+}
+
+bool Farm::isLiveJob(h256 const& _header)
+{
+    Guard l(x_liveJobs);
+    return m_liveJobs.count(_header) != 0;
 }
 
-void Farm::submitProofAsync(Solution const& _s)
+void Farm::submitProofAsync(
+    Solution const& _s, uint64_t _seq, std::chrono::steady_clock::time_point _queued)
 {
+    // A clean job came in meanwhile : the pool would only reject it
+    if (!isLiveJob(_s.work.header))
+    {
+        g_io_service.post(m_io_strand.wrap(
+            boost::bind(&Farm::onProofVerified, this, _s, _seq, ProofOutcome::Stale)));
+        return;
+    }
+
     if (!m_Settings.noEval)
     {
         bool validSolution{false};
 
-        auto period{_s.work.block.value() / progpow::kPeriodLength};
-
         ethash::hash256 header_256{ethash::from_bytes(_s.work.header.data())};
         ethash::hash256 mix_256{ethash::from_bytes(_s.mixHash.data())};
         ethash::hash256 boundary_256{ethash::from_bytes(_s.work.get_boundary().data())};
@@ -497,25 +694,86 @@ void Farm::submitProofAsync(Solution const& _s)
             break;
         }
 
+        unsigned latency = unsigned(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - _queued)
+                                        .count());
+        m_verifyLatency.store(
+            (m_verifyLatency.load(std::memory_order_relaxed) * 7 + latency) / 8, std::memory_order_relaxed);
+        storeMax(m_verifyMaxLatency, latency);
+        m_verifyCount.fetch_add(1, std::memory_order_relaxed);
+
         if (!validSolution)
         {
-            accountSolution(_s.midx, SolutionAccountingEnum::Failed);
             cwarn << "GPU " << _s.midx << " gave incorrect " << _s.work.algo
                   << " header: " << _s.work.header << " block: " << _s.work.block.value() 
                   << " boundary: " << _s.work.get_boundary().hex() << " nonce: " << _s.nonce << " mix: " << _s.mixHash;
+            g_io_service.post(m_io_strand.wrap(
+                boost::bind(&Farm::onProofVerified, this, _s, _seq, ProofOutcome::Invalid)));
             return;
         }
     }
 
-    m_onSolutionFound(_s);
+    g_io_service.post(
+        m_io_strand.wrap(boost::bind(&Farm::onProofVerified, this, _s, _seq, ProofOutcome::Valid)));
+}
+
+void Farm::onProofVerified(Solution const& _s, uint64_t _seq, ProofOutcome _outcome)
+{
+    // Hold on till all the solutions found before have been handled
+    m_proofsVerified.emplace(_seq, std::make_pair(_s, _outcome));
+
+    uint64_t next = m_proofsSubmitted.load(std::memory_order_relaxed);
+    for (auto it = m_proofsVerified.begin(); it != m_proofsVerified.end() && it->first == next;
+         it = m_proofsVerified.erase(it), next++)
+    {
+        Solution const& sol = it->second.first;
+        switch (it->second.second)
+        {
+        case ProofOutcome::Invalid:
+            accountSolution(sol.midx, SolutionAccountingEnum::Failed);
+            break;
+        case ProofOutcome::Stale:
+            cnote << "Solution " << toHex(sol.nonce, dev::HexPrefix::Add)
+                  << " dropped. Its job is no longer valid";
+            m_verifyDropped.fetch_add(1, std::memory_order_relaxed);
+            accountSolution(sol.midx, SolutionAccountingEnum::Wasted);
+            break;
+        default:
+            m_onSolutionFound(sol);
 
 #ifdef DEV_BUILD
-    if (g_logOptions & LOG_SUBMIT)
-        cnote << "Submit time: "
-              << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _s.tstamp)
-                     .count()
-              << " us.";
+            if (g_logOptions & LOG_SUBMIT)
+                cnote << "Submit time: "
+                      << std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - sol.tstamp)
+                             .count()
+                      << " us.";
 #endif
+            break;
+        }
+    }
+    m_proofsSubmitted.store(next, std::memory_order_relaxed);
+}
+
+Json::Value Farm::get_verification_json()
+{
+    Json::Value jRes;
+    jRes["queued"] = unsigned(
+        m_proofsQueued.load(std::memory_order_relaxed) - m_proofsSubmitted.load(std::memory_order_relaxed));
+    jRes["max_queued"] = m_verifyMaxQueued.load(std::memory_order_relaxed);
+    jRes["verified"] = Json::UInt64(m_verifyCount.load(std::memory_order_relaxed));
+    jRes["dropped"] = m_verifyDropped.load(std::memory_order_relaxed);
+    jRes["latency"] = m_verifyLatency.load(std::memory_order_relaxed);
+    jRes["max_latency"] = m_verifyMaxLatency.load(std::memory_order_relaxed);
+
+    auto items{ethash::get_dataset_item_cache_stats()};
+    Json::Value jCache;
+    jCache["capacity"] = Json::UInt64(items.capacity);
+    jCache["size"] = Json::UInt64(items.size);
+    jCache["hits"] = Json::UInt64(items.hits);
+    jCache["misses"] = Json::UInt64(items.misses);
+    jRes["item_cache"] = jCache;
+    return jRes;
 }
 
 // Collects data about hashing and hardware status
@@ -527,14 +785,18 @@ void Farm::collectData(const boost::system::error_code& ec)
     // Reset hashrate (it will accumulate from miners)
     float farm_hr = 0.0f;
 
-    // Process miners
-    for (auto const& miner : m_miners)
+    // Process miners. This runs on the api io service : miners are copied
+    // and telemetry is only written under its lock
+    for (auto const& miner : getMiners())
     {
         int minerIdx = miner->Index();
         float hr = (miner->paused() ? 0.0f : miner->RetrieveHashRate());
         farm_hr += hr;
-        m_telemetry.miners.at(minerIdx).hashrate = hr;
-        m_telemetry.miners.at(minerIdx).paused = miner->paused();
+        {
+            Guard l(x_telemetry);
+            m_telemetry.miners.at(minerIdx).hashrate = hr;
+            m_telemetry.miners.at(minerIdx).paused = miner->paused();
+        }
 
         if (m_Settings.hwMon)
         {
@@ -639,18 +901,21 @@ void Farm::collectData(const boost::system::error_code& ec)
                     miner->resume(MinerPauseEnum::PauseDueToOverHeating);
             }
 
+            Guard l(x_telemetry);
             m_telemetry.miners.at(minerIdx).sensors.tempC = tempC;
             m_telemetry.miners.at(minerIdx).sensors.fanP = fanpcnt;
             m_telemetry.miners.at(minerIdx).sensors.powerW = powerW / ((double)1000.0);
         }
-        m_telemetry.farm.hashrate = farm_hr;
+        {
+            Guard l(x_telemetry);
+            m_telemetry.farm.hashrate = farm_hr;
+        }
         miner->TriggerHashRateUpdate();
     }
 
     // Resubmit timer for another loop
     m_collectTimer.expires_from_now(boost::posix_time::milliseconds(m_collectInterval));
-    m_collectTimer.async_wait(
-        m_io_strand.wrap(boost::bind(&Farm::collectData, this, boost::asio::placeholders::error)));
+    m_collectTimer.async_wait(boost::bind(&Farm::collectData, this, boost::asio::placeholders::error));
 }
 
 bool Farm::spawn_file_in_bin_dir(const char* filename, const std::vector<std::string>& args)
@@ -18,8 +18,12 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
+#include <future>
 #include <list>
+#include <optional>
 #include <thread>
+#include <unordered_set>
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
@@ -42,7 +46,9 @@
 #include <libhwmon/wrapadl.h>
 #endif
 
-extern boost::asio::io_service g_io_service;
+extern boost::asio::io_service g_io_service;         // Pool traffic and job dispatch
+extern boost::asio::io_service g_verify_io_service;  // Solutions verification
+extern boost::asio::io_service g_api_io_service;     // Api, hardware monitoring and telemetry
 
 namespace dev
 {
@@ -50,12 +56,19 @@ namespace eth
 {
 struct FarmSettings
 {
-    unsigned dagLoadMode = 0;  // 0 = Parallel; 1 = Serialized
-    bool noEval = false;       // Whether or not to re-evaluate solutions
-    unsigned hwMon = 0;        // 0 - No monitor; 1 - Temp and Fan; 2 - Temp Fan Power
-    unsigned ergodicity = 0;   // 0=default, 1=per session, 2=per job
-    unsigned tempStart = 40;   // Temperature threshold to restart mining (if paused)
-    unsigned tempStop = 0;     // Temperature threshold to pause mining (overheating)
+    unsigned dagLoadMode = 0;     // 0 = Parallel; 1 = Serialized
+    bool noEval = false;          // Whether or not to re-evaluate solutions
+    unsigned hwMon = 0;           // 0 - No monitor; 1 - Temp and Fan; 2 - Temp Fan Power
+    unsigned ergodicity = 0;      // 0=default, 1=per session, 2=per job
+    unsigned tempStart = 40;      // Temperature threshold to restart mining (if paused)
+    unsigned tempStop = 0;        // Temperature threshold to pause mining (overheating)
+    std::string dagCacheDir;      // Directory of the on-disk DAG cache (empty = disabled)
+    bool dagCacheFull = false;    // Whether or not full DAGs (CPU mining) are cached on disk too
+    unsigned dagCacheEpochs = 2;  // Number of epochs kept on disk
+    bool noHugePages = false;     // Whether or not to avoid huge pages for DAG contexts
+    unsigned verifyCacheMb = 0;   // MiB of DAG items kept for verification (0 = disabled)
+    unsigned dagContexts = 3;     // Number of light DAG contexts (epochs) kept in memory
+    unsigned dagContextsFull = 1; // Number of full DAG contexts (CPU mining) kept in memory
 };
 
 /**
@@ -87,6 +100,15 @@ public:
      */
     void setWork(WorkPackage const& _newWp);
 
+    /**
+     * @brief Gets the work package miners are currently given
+     */
+    WorkPackage getWork()
+    {
+        Guard l(x_minerWork);
+        return m_currentWp;
+    }
+
     /**
      * @brief Start a number of miners.
      */
@@ -136,30 +158,56 @@ public:
 
     /**
      * @brief Get information on the progress of mining this work package.
-     * @return The progress with mining so far.
+     * @return A copy of the progress with mining so far.
      */
-    TelemetryType& Telemetry() { return m_telemetry; }
+    TelemetryType Telemetry()
+    {
+        Guard l(x_telemetry);
+        return m_telemetry;
+    }
 
     /**
      * @brief Gets current hashrate
      */
-    float HashRate() { return m_telemetry.farm.hashrate; };
+    float HashRate()
+    {
+        Guard l(x_telemetry);
+        return m_telemetry.farm.hashrate;
+    };
+
+    /**
+     * @brief Gets the (light) DAG context of the current epoch
+     */
+    std::shared_ptr<ethash::epoch_context> getEpochContext()
+    {
+        Guard l(x_minerWork);
+        return m_currentEc;
+    }
 
     /**
      * @brief Gets the collection of pointers to miner instances
      */
-    std::vector<std::shared_ptr<Miner>> getMiners() { return m_miners; }
+    std::vector<std::shared_ptr<Miner>> getMiners()
+    {
+        Guard l(x_minerWork);
+        return m_miners;
+    }
 
     /**
      * @brief Gets the number of miner instances
      */
-    unsigned getMinersCount() { return (unsigned)m_miners.size(); };
+    unsigned getMinersCount()
+    {
+        Guard l(x_minerWork);
+        return (unsigned)m_miners.size();
+    };
 
     /**
      * @brief Gets the pointer to a miner instance
      */
     std::shared_ptr<Miner> getMiner(unsigned index)
     {
+        Guard l(x_minerWork);
         try
         {
             return m_miners.at(index);
@@ -176,6 +224,12 @@ public:
      */
     void accountSolution(unsigned _minerIdx, SolutionAccountingEnum _accounting) override;
 
+    /**
+     * @brief Accounts the find to acknowledge latency of a share to a
+     *  miner and to the whole farm
+     */
+    void accountLatency(unsigned _minerIdx, std::chrono::milliseconds const& _findToAck);
+
     /**
      * @brief Gets the solutions account for the whole farm
      */
@@ -229,6 +283,18 @@ public:
      */
     Json::Value get_nonce_scrambler_json();
 
+    /**
+     * @brief Gets the first nonce and the width of the segment assigned to a miner
+     * with the current job. Miners may steal from each other in bounded spaces
+     */
+    std::pair<uint64_t, uint64_t> getNonceSegment(unsigned _index);
+
+
+    /**
+     * @brief Gets stats of solutions verification
+     */
+    Json::Value get_verification_json();
+
     void setTStartTStop(unsigned tstart, unsigned tstop);
 
     unsigned get_tstart() override { return m_Settings.tempStart; }
@@ -248,11 +314,35 @@ public:
 private:
     std::atomic<bool> m_paused = {false};
 
-    // Async submits solution serializing execution
-    // in Farm's strand
-    void submitProofAsync(Solution const& _s);
+    enum class ProofOutcome
+    {
+        Valid,
+        Invalid,
+        Stale  // Its job has been superseded by a clean one
+    };
+
+    // Verifies a solution on the verification io service then hands
+    // it back to Farm's strand to be submitted in sequence
+    void submitProofAsync(
+        Solution const& _s, uint64_t _seq, std::chrono::steady_clock::time_point _queued);
+    void onProofVerified(Solution const& _s, uint64_t _seq, ProofOutcome _outcome);
+    bool isLiveJob(h256 const& _header);
+
+    // Builds the epoch context in background and, when done,
+    // dispatches the deferred job (in Farm's strand)
+    void buildEpochContextAsync(uint32_t _epoch);
+    void onEpochContextReady(std::shared_ptr<ethash::epoch_context> _ec);
+
+    // Makes miners use the given epoch context
+    void switchEpoch(std::shared_ptr<ethash::epoch_context> const& _ec);
 
-    // Collects data about hashing and hardware status
+    // Hands out work to miners giving each its own starting nonce
+    void dispatchWork(WorkPackage const& _newWp);
+
+    // Hashrate of each miner to share nonces out by
+    std::vector<uint64_t> minerWeights();
+
+    // Collects data about hashing and hardware status (api io service)
     void collectData(const boost::system::error_code& ec);
 
     /**
@@ -267,8 +357,34 @@ private:
     WorkPackage m_currentWp;
     std::shared_ptr<ethash::epoch_context> m_currentEc;
 
+    WorkPackage m_pendingWp;                  // Job deferred till its epoch context is built
+    std::optional<uint32_t> m_epochBuilding;  // Epoch which context is being built
+    std::future<void> m_epochBuilder;
+
     std::atomic<bool> m_isMining = {false};
 
+    // Jobs solutions can still be submitted for : all the ones dispatched
+    // since the last clean job. Pools never flagging jobs clean (EthereumStratum/1.0.0)
+    // expire them on their own : the cap only bounds memory, and holds hours
+    // of jobs, far older than any a pool still accepts shares for
+    static constexpr size_t c_maxLiveJobs = 4096;
+    Mutex x_liveJobs;
+    std::unordered_set<h256> m_liveJobs;
+    std::deque<h256> m_liveJobsOrder;  // Oldest first
+
+    // Solutions are verified in parallel, then submitted in the order
+    // they were found
+    std::atomic<uint64_t> m_proofsQueued = {0};     // Sequence of next solution
+    std::atomic<uint64_t> m_proofsSubmitted = {0};  // Sequence of next solution to submit
+    std::map<uint64_t, std::pair<Solution, ProofOutcome>> m_proofsVerified;  // Out of order ones
+
+    std::atomic<uint64_t> m_verifyCount = {0};
+    std::atomic<unsigned> m_verifyDropped = {0};
+    std::atomic<unsigned> m_verifyMaxQueued = {0};
+    std::atomic<unsigned> m_verifyLatency = {0};  // Smoothed, us
+    std::atomic<unsigned> m_verifyMaxLatency = {0};
+
+    mutable Mutex x_telemetry;  // Telemetry is written from the io and api io services
     TelemetryType m_telemetry;  // Holds progress and status info for farm and miners
 
     SolutionFound m_onSolutionFound;
@@ -293,6 +409,9 @@ private:
     uint64_t m_nonce_scrambler;
     unsigned int m_nonce_segment_with = 32;
 
+    // First nonce and width of the segment of each miner with current job
+    std::vector<std::pair<uint64_t, uint64_t>> m_nonceSegments;
+
     // Wrappers for hardware monitoring libraries and their mappers
     wrap_nvml_handle* nvmlh = nullptr;
     std::map<std::string, int> map_nvml_handle = {};
@@ -25,39 +25,141 @@ unsigned Miner::s_minersCount = 0;
 
 FarmFace* FarmFace::m_this = nullptr;
 
-DeviceDescriptor Miner::getDescriptor()
+NonceSpace::NonceSpace(uint64_t _start, std::vector<uint64_t> const& _sizes) : m_start(_start)
 {
-    return m_deviceDescriptor;
+    uint64_t offset = 0;
+    for (auto size : _sizes)
+    {
+        m_slices.push_back({offset, offset + size});
+        offset += size;
+    }
 }
 
-void Miner::setWork(WorkPackage const& _work)
+std::vector<uint64_t> NonceSpace::split(u128 _space, std::vector<uint64_t> const& _weights)
 {
+    // Slices can't be wider than 64 bits
+    std::vector<uint64_t> sizes(_weights.size(), 0);
+    if (_weights.empty())
+        return sizes;
+    const u128 maxSize = std::numeric_limits<uint64_t>::max();
+    if (_space > maxSize * _weights.size())
+        _space = maxSize * _weights.size();
+
+    // Floors of exact shares first
+    u128 total = 0;
+    for (auto weight : _weights)
+        total += weight;
+    u128 assigned = 0;
+    std::vector<std::pair<u128, size_t>> remainders;
+    for (size_t i = 0; i < _weights.size(); i++)
     {
-        std::scoped_lock l(x_work);
+        u128 share = _space * _weights[i];
+        u128 size = std::min<u128>(share / total, maxSize);
+        sizes[i] = uint64_t(size);
+        assigned += size;
+        remainders.emplace_back(share % total, i);
+    }
 
-        // Void work if this miner is paused
-        if (paused())
+    // Floors leave less than a nonce per slice. More is left by slices clamped
+    // to 64 bits : the others take it as far as they can
+    if (_space - assigned >= sizes.size())
+        for (auto& size : sizes)
         {
-            m_work.header = h256();
-        }
-        else
-        {
-            m_work = _work;
+            u128 more = std::min<u128>(_space - assigned, maxSize - size);
+            size += uint64_t(more);
+            assigned += more;
         }
 
+    // Then what's left goes one by one to the largest remainders
+    std::sort(remainders.begin(), remainders.end(),
+        [](auto const& _a, auto const& _b) { return _a.first > _b.first; });
+    for (size_t i = 0; assigned < _space; i = (i + 1) % remainders.size())
+    {
+        uint64_t& size = sizes[remainders[i].second];
+        if (size == std::numeric_limits<uint64_t>::max())
+            continue;
+        size++;
+        assigned++;
+    }
+    return sizes;
+}
+
+std::pair<uint64_t, uint64_t> NonceSpace::claim(unsigned _index, uint64_t _count)
+{
+    std::scoped_lock l(x_slices);
+    if (_index >= m_slices.size())
+        return {0, 0};
+
+    Slice& own = m_slices[_index];
+    if (own.next == own.end)
+    {
+        // Steal from the slice with most nonces left. What's too small to be
+        // halved is taken as a whole
+        Slice* victim = &own;
+        for (auto& slice : m_slices)
+            if (slice.end - slice.next > victim->end - victim->next)
+                victim = &slice;
+        uint64_t left = victim->end - victim->next;
+        if (!left)
+            return {0, 0};
+        uint64_t split = left <= _count ? victim->next : victim->next + left / 2;
+        own.next = split;
+        own.end = victim->end;
+        victim->end = split;
+    }
+
+    uint64_t count = std::min(_count, own.end - own.next);
+    uint64_t first = m_start + own.next;
+    own.next += count;
+    return {first, count};
+}
+
+DeviceDescriptor Miner::getDescriptor()
+{
+    return m_deviceDescriptor;
+}
+
+void Miner::setWork(WorkPackage const& _work, std::chrono::steady_clock::time_point _published)
+{
+    // Void work if this miner is paused
+    if (paused())
+    {
+        publishWork(voidedWork(), _published);
+    }
+    else
+    {
+        publishWork(_work, _published);
+    }
+
 #ifdef DEV_BUILD
-        m_workSwitchStart = std::chrono::steady_clock::now();
+    m_workSwitchStart = std::chrono::steady_clock::now();
 #endif
-    }
 
     kick_miner();
 }
 
+void Miner::publishWork(WorkPackage const& _work, std::chrono::steady_clock::time_point _published)
+{
+    auto snapshot = std::make_shared<WorkSnapshot>();
+    snapshot->work = _work;
+    snapshot->published = _published;
+    snapshot->sequence = m_workSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::atomic_store(&m_work, std::shared_ptr<const WorkSnapshot>(std::move(snapshot)));
+}
+
+WorkPackage Miner::voidedWork() const
+{
+    auto snapshot = std::atomic_load(&m_work);
+    WorkPackage voided = snapshot ? snapshot->work : WorkPackage();
+    voided.header = h256();
+    return voided;
+}
+
 void Miner::pause(MinerPauseEnum what)
 {
     std::scoped_lock l(x_pause);
     m_pauseFlags.set(what);
-    m_work.header = h256();
+    publishWork(voidedWork(), std::chrono::steady_clock::now());
     kick_miner();
 }
 
@@ -96,6 +198,8 @@ std::string Miner::pausedString()
                     retVar.append("Insufficient GPU memory");
                 else if (i == MinerPauseEnum::PauseDueToInitEpochError)
                     retVar.append("Epoch initialization error");
+                else if (i == MinerPauseEnum::PauseDueToAutotune)
+                    retVar.append("Autotuning");
             }
         }
     }
@@ -163,15 +267,38 @@ bool Miner::initEpoch()
     return result;
 }
 
-WorkPackage Miner::work() const
+std::shared_ptr<const WorkPackage> Miner::work() const
 {
-    std::scoped_lock l(x_work);
-    return m_work;
+    // Pairs with the release of the generation the caller may have seen
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto snapshot = std::atomic_load(&m_work);
+    if (!snapshot)
+    {
+        static const auto none = std::make_shared<const WorkPackage>();
+        return none;
+    }
+
+    if (snapshot->sequence != m_workObserved)
+    {
+        m_workObserved = snapshot->sequence;
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - snapshot->published)
+                      .count();
+        m_workSwitches.fetch_add(1, std::memory_order_relaxed);
+        m_workSwitchUs.fetch_add(us, std::memory_order_relaxed);
+        m_dispatchLatency.store(
+            unsigned((m_dispatchLatency.load(std::memory_order_relaxed) * 7 + us) / 8),
+            std::memory_order_relaxed);
+    }
+
+    // Shares the snapshot's ownership
+    return std::shared_ptr<const WorkPackage>(snapshot, &snapshot->work);
 }
 
 void Miner::updateHashRate(uint32_t _groupSize, uint32_t _increment) noexcept
 {
     m_groupCount += _increment;
+    m_hashCount.fetch_add(uint64_t(_groupSize) * _increment, std::memory_order_relaxed);
     bool b = true;
     if (!m_hashRateUpdate.compare_exchange_weak(b, false, std::memory_order_relaxed))
         return;
@@ -185,6 +312,12 @@ void Miner::updateHashRate(uint32_t _groupSize, uint32_t _increment) noexcept
     m_groupCount = 0;
 }
 
+void Miner::updateKernelIdleGap(unsigned _us) noexcept
+{
+    m_kernelIdleGap.store(
+        (m_kernelIdleGap.load(std::memory_order_relaxed) * 7 + _us) / 8, std::memory_order_relaxed);
+}
+
 bool Miner::dropThreadPriority()
 {
 #if defined(__linux__)
@@ -20,15 +20,23 @@
 #define LIBCRYPTO_MINER_H_
 
 
+#include <algorithm>
+#include <array>
 #include <bitset>
 #include <condition_variable>
+#include <limits>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
+#include <sstream>
 #include <string>
+#include <vector>
 
 //#include "EthashAux.h"
 #include <libdevcore/Common.h>
+#include <libdevcore/EventCounter.h>
 #include <libdevcore/Log.h>
 #include <libdevcore/Worker.h>
 
@@ -83,7 +91,8 @@ enum class ClPlatformTypeEnum
     Unknown,
     Amd,
     Clover,
-    Nvidia
+    Nvidia,
+    Pocl
 };
 
 enum class SolutionAccountingEnum
@@ -115,11 +124,58 @@ struct CLSettings : public MinerSettings
     unsigned globalWorkSize = 0;
     unsigned globalWorkSizeMultiplier = 32768;
     unsigned localWorkSize = 256;
+    unsigned pipelineDepth = 1;    // Search batches queued on the device (1 = wait on each batch)
+    bool outOfOrder = false;       // Out of order command queue, when the device supports it
+    std::string binaryCacheDir;    // Directory of the on-disk program binary cache (empty = disabled)
+    unsigned binaryCacheMb = 256;  // Disk space (MB) the binary cache may take
 };
 
 // Holds settings for CPU Miner
 struct CPSettings : public MinerSettings
 {
+    unsigned dagThreads = 0;  // Threads generating the DAG (0 = all available CPUs)
+    unsigned batchSize = 64;  // Nonces searched between two checks for new work
+};
+
+// Work sizes a device is tuned with (see Autotuner). Zero fields keep the settings
+struct TuningPoint
+{
+    unsigned globalWorkMultiplier = 0;  // OpenCL
+    unsigned localWorkSize = 0;         // OpenCL
+    unsigned batchSize = 0;             // CPU
+    bool enabled = true;                // CPU : whether this thread is worth mining with
+
+    std::string str() const
+    {
+        std::ostringstream s;
+        if (localWorkSize)
+            s << "global " << globalWorkMultiplier << " x local " << localWorkSize;
+        if (batchSize)
+            s << "batch " << batchSize;
+        return s.str();
+    }
+};
+
+// Histogram of the time from a share being found to its acknowledge by the pool
+struct ShareLatencyType
+{
+    // Upper bounds (ms) of the buckets. A last bucket holds the slower ones
+    static constexpr std::array<unsigned, 7> bounds = {50, 100, 250, 500, 1000, 2500, 5000};
+
+    std::array<unsigned, bounds.size() + 1> counts = {};
+    unsigned samples = 0;
+    uint64_t totalMs = 0;
+    unsigned maxMs = 0;
+
+    void add(std::chrono::milliseconds const& _latency)
+    {
+        unsigned ms = unsigned(std::max<std::chrono::milliseconds::rep>(_latency.count(), 0));
+        counts[std::lower_bound(bounds.begin(), bounds.end(), ms) - bounds.begin()]++;
+        samples++;
+        totalMs += ms;
+        maxMs = std::max(maxMs, ms);
+    }
+    unsigned meanMs() const { return samples ? unsigned(totalMs / samples) : 0; }
 };
 
 struct SolutionAccountType
@@ -129,6 +185,7 @@ struct SolutionAccountType
     unsigned wasted = 0;
     unsigned failed = 0;
     std::chrono::steady_clock::time_point tstamp = std::chrono::steady_clock::now();
+    ShareLatencyType latency;
     std::string str()
     {
         std::string _ret = "A" + std::to_string(accepted);
@@ -204,7 +261,10 @@ struct DeviceDescriptor
     unsigned int cuComputeMajor;
     unsigned int cuComputeMinor;
 
-    int cpCpuNumer;  // For CPU
+    int cpCpuNumer;           // For CPU
+    unsigned cpNumaNode = 0;  // NUMA node of the CPU
+
+    TuningPoint tuning;  // From the tuning profile, if any
 };
 
 struct HwMonitorInfo
@@ -222,6 +282,7 @@ enum MinerPauseEnum
     PauseDueToFarmPaused,
     PauseDueToInsufficientMemory,
     PauseDueToInitEpochError,
+    PauseDueToAutotune,
     Pause_MAX  // Must always be last as a placeholder of max count
 };
 
@@ -312,6 +373,42 @@ struct TelemetryType
     };
 };
 
+/**
+ * @brief Nonces of a job left by the pool's extranonce, shared out among miners
+ * in consecutive slices. Each miner claims batches from its own slice. One done
+ * with its slice steals the upper half of what's left of the largest other one
+ */
+class NonceSpace
+{
+public:
+    NonceSpace(uint64_t _start, std::vector<uint64_t> const& _sizes);
+
+    /**
+     * @brief Splits a nonce space in as many slices as weights, each in proportion
+     * to its weight. Slices add up to the space exactly, but for a space wider than
+     * the slices can hold : each one holds 2^64-1 nonces at most
+     */
+    static std::vector<uint64_t> split(u128 _space, std::vector<uint64_t> const& _weights);
+
+    /**
+     * @brief Claims up to _count nonces for miner _index
+     * @return First nonce and how many. None once the whole space is searched
+     */
+    std::pair<uint64_t, uint64_t> claim(unsigned _index, uint64_t _count);
+
+private:
+    // Offsets from the start of the space
+    struct Slice
+    {
+        uint64_t next = 0;
+        uint64_t end = 0;
+    };
+
+    const uint64_t m_start;
+    std::mutex x_slices;
+    std::vector<Slice> m_slices;
+};
+
 struct WorkPackage
 {
     WorkPackage() = default;
@@ -339,6 +436,9 @@ struct WorkPackage
 
     uint64_t startNonce = 0;
     uint16_t exSizeBytes = 0;
+    std::shared_ptr<NonceSpace> nonces;  // Set when the space is bounded : search claims from it
+
+    bool clean = false;  // Obsoletes previous jobs : their shares are stale
 
     std::string algo = "meowpow";
 };
@@ -410,8 +510,10 @@ public:
 
     /**
      * @brief Assigns hashing work to this instance
+     * @param _published When the farm published the work, dispatch latency is measured from
      */
-    void setWork(WorkPackage const& _work);
+    void setWork(WorkPackage const& _work,
+        std::chrono::steady_clock::time_point _published = std::chrono::steady_clock::now());
 
     /**
      * @brief Assigns Epoch context to this instance
@@ -462,6 +564,41 @@ public:
 
     void TriggerHashRateUpdate() noexcept;
 
+    /**
+     * @brief Smoothed idle time of the device between two search kernels (us)
+     * @note Only measured by miners queueing kernels ahead, 0 otherwise
+     */
+    unsigned kernelIdleGap() const noexcept { return m_kernelIdleGap.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Smoothed time from the farm publishing a work to this miner picking it (us)
+     */
+    unsigned dispatchLatency() const noexcept { return m_dispatchLatency.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Hashes computed since the miner started
+     */
+    uint64_t hashCount() const noexcept { return m_hashCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of work switches and their total latency (us), from a new
+     * work being published to the miner fetching it
+     */
+    std::pair<unsigned, uint64_t> workSwitches() const noexcept
+    {
+        return {m_workSwitches.load(std::memory_order_relaxed), m_workSwitchUs.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief Work sizes the autotuner may try on this miner. Empty if it can't be tuned
+     */
+    virtual std::vector<TuningPoint> tuningCandidates() { return {}; }
+
+    /**
+     * @brief Makes the miner use the given work sizes as soon as possible
+     */
+    virtual void applyTuning(TuningPoint const& _point) { (void)_point; }
+
 protected:
     /**
      * @brief Initializes miner's device.
@@ -479,12 +616,42 @@ protected:
     virtual bool initEpoch_internal() = 0;
 
     /**
-     * @brief Returns current workpackage this miner is working on
+     * @brief Returns current workpackage this miner is working on. Never null.
+     * The package is shared and immutable : it's not copied
      */
-    WorkPackage work() const;
+    std::shared_ptr<const WorkPackage> work() const;
+
+    /**
+     * @brief Sequence of the work last returned by work(), telling snapshots apart
+     * even when their header is the same. Miner thread only
+     */
+    uint64_t workSequence() const noexcept { return m_workObserved; }
+
+    /**
+     * @brief Sequence of the last work published. Safe from any thread
+     */
+    uint64_t latestWorkSequence() const noexcept { return m_workSequence.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Generation of the work, moves each time a work is published or the
+     * miner is kicked. A single relaxed load : check it as often as needed
+     */
+    uint32_t workGeneration() const noexcept { return m_workEvents.value(); }
+
+    /**
+     * @brief Sleeps till the work generation moves from _seen
+     */
+    void waitWork(uint32_t _seen) const noexcept { m_workEvents.wait(_seen, c_workWaitTimeout); }
+
+    /**
+     * @brief Moves the work generation waking the miner. To be called by kick_miner()
+     */
+    void notifyWork() noexcept { m_workEvents.notify(); }
 
     void updateHashRate(uint32_t _groupSize, uint32_t _increment) noexcept;
 
+    void updateKernelIdleGap(unsigned _us) noexcept;
+
     bool dropThreadPriority();
 
     static unsigned s_minersCount;   // Total Number of Miners
@@ -504,20 +671,45 @@ protected:
     HwMonitorInfo m_hwmoninfo;
     mutable std::mutex x_work;
     mutable std::mutex x_pause;
-    std::condition_variable m_new_work_signal;
     std::condition_variable m_dag_loaded_signal;
     uint64_t m_nextProgpowPeriod = 0;
     std::unique_ptr<std::thread> m_compileThread = nullptr;
 
 private:
+    // Work as published, replaced as a whole and never modified
+    struct WorkSnapshot
+    {
+        WorkPackage work;
+        std::chrono::steady_clock::time_point published;
+        uint64_t sequence = 0;  // Tells snapshots apart
+    };
+
+    // Sleeping miners wake up at least this often, should a stop come without a kick
+    static constexpr std::chrono::milliseconds c_workWaitTimeout{1000};
+
+    void publishWork(WorkPackage const& _work, std::chrono::steady_clock::time_point _published);
+
+    // Last published work with a void header : keeps a paused miner idle
+    WorkPackage voidedWork() const;
+
     std::bitset<MinerPauseEnum::Pause_MAX> m_pauseFlags;
 
-    WorkPackage m_work;
+    std::shared_ptr<const WorkSnapshot> m_work;  // Only accessed through std::atomic_load/store
+    std::atomic<uint64_t> m_workSequence = {0};
+    EventCounter m_workEvents;
 
     std::chrono::steady_clock::time_point m_hashTime = std::chrono::steady_clock::now();
     std::atomic<float> m_hashRate = {0.0};
     uint64_t m_groupCount = 0;
     std::atomic<bool> m_hashRateUpdate = {false};
+    std::atomic<unsigned> m_kernelIdleGap = {0};
+    std::atomic<uint64_t> m_hashCount = {0};
+
+    // Work dispatch latency, accounted by the miner thread picking new snapshots
+    mutable uint64_t m_workObserved = 0;
+    mutable std::atomic<unsigned> m_workSwitches = {0};
+    mutable std::atomic<uint64_t> m_workSwitchUs = {0};
+    mutable std::atomic<unsigned> m_dispatchLatency = {0};
 };
 
 }  // namespace dev::eth
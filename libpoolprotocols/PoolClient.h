@@ -1,10 +1,12 @@
 #pragma once
 
+#include <map>
 #include <queue>
 
 #include <boost/asio/ip/address.hpp>
 #include <boost/bind.hpp>
 
+#include <libdevcore/Guards.h>
 #include <libethcore/Miner.h>
 #include <libpoolprotocols/PoolURI.h>
 
@@ -49,6 +51,74 @@ struct Session
     chrono::steady_clock::time_point lastTxStamp = chrono::steady_clock::now();
 };
 
+// A share submitted to the pool and awaiting its response
+struct SubmittedShare
+{
+    std::string job;
+    unsigned midx = 0;                       // Originating miner Id
+    chrono::steady_clock::time_point found;  // When the miner found it
+    chrono::steady_clock::time_point sent;   // When it was submitted
+
+    chrono::milliseconds responseDelay() const
+    {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - sent);
+    }
+    chrono::milliseconds findToAck() const
+    {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - found);
+    }
+};
+
+// Shares in flight keyed by the json id of their submission. Ids are
+// unique and increasing so responses are matched exactly even when a
+// miner has several shares pending
+class SubmissionTable
+{
+public:
+    // Ids below are used by other requests
+    static constexpr unsigned kFirstId = 1000;
+
+    unsigned add(Solution const& _s)
+    {
+        Guard l(x_shares);
+        unsigned id = m_nextId++;
+        if (m_nextId < kFirstId)
+            m_nextId = kFirstId;
+        m_shares[id] = {_s.work.job, _s.midx, _s.tstamp, chrono::steady_clock::now()};
+        return id;
+    }
+
+    bool contains(unsigned _id)
+    {
+        Guard l(x_shares);
+        return m_shares.count(_id) != 0;
+    }
+
+    bool take(unsigned _id, SubmittedShare& _share)
+    {
+        Guard l(x_shares);
+        auto it = m_shares.find(_id);
+        if (it == m_shares.end())
+            return false;
+        _share = std::move(it->second);
+        m_shares.erase(it);
+        return true;
+    }
+
+    // Responses to shares of a previous connection are not expected
+    // anymore. Ids keep increasing
+    void clear()
+    {
+        Guard l(x_shares);
+        m_shares.clear();
+    }
+
+private:
+    Mutex x_shares;
+    std::map<unsigned, SubmittedShare> m_shares;
+    unsigned m_nextId = kFirstId;
+};
+
 class PoolClient
 {
 public:
@@ -82,8 +152,8 @@ public:
         return (m_connected.load(memory_order_relaxed) ? " [" + toString(m_endpoint) + "]" : "");
     }
 
-    using SolutionAccepted = function<void(chrono::milliseconds const&, unsigned const&, bool)>;
-    using SolutionRejected = function<void(chrono::milliseconds const&, unsigned const&)>;
+    using SolutionAccepted = function<void(SubmittedShare const&, bool)>;
+    using SolutionRejected = function<void(SubmittedShare const&)>;
     using Disconnected = function<void()>;
     using Connected = function<void()>;
     using WorkReceived = function<void(WorkPackage&)>;
@@ -103,6 +173,8 @@ protected:
 
     std::shared_ptr<URI> m_conn = nullptr;
 
+    SubmissionTable m_submissions;
+
     SolutionAccepted m_onSolutionAccepted;
     SolutionRejected m_onSolutionRejected;
     Disconnected m_onDisconnected;
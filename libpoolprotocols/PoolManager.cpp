@@ -1,4 +1,5 @@
 #include <chrono>
+#include <climits>
 
 #include "PoolManager.h"
 
@@ -12,7 +13,8 @@ PoolManager::PoolManager(PoolSettings _settings)
   : m_Settings(std::move(_settings)),
     m_io_strand(g_io_service),
     m_failovertimer(g_io_service),
-    m_submithrtimer(g_io_service)
+    m_submithrtimer(g_io_service),
+    m_latencytimer(g_io_service)
 {
     m_this = this;
 
@@ -52,75 +54,20 @@ PoolManager::PoolManager(PoolSettings _settings)
 
 void PoolManager::setClientHandlers()
 {
-    p_client->onConnected([&]() {
-        {
-            // If HostName is already an IP address no need to append the
-            // effective ip address.
-            if (p_client->getConnection()->HostNameType() == dev::UriHostNameType::Dns ||
-                p_client->getConnection()->HostNameType() == dev::UriHostNameType::Basic)
-            {
-                string ep = p_client->ActiveEndPoint();
-                if (!ep.empty())
-                    m_selectedHost = p_client->getConnection()->Host() + ep;
-            }
-
-            cnote << "Established connection to " << m_selectedHost;
-
-            // Reset current WorkPackage
-            m_currentWp.job.clear();
-            m_currentWp.header = h256();
-
-            // Shuffle if needed
-            if (Farm::f().get_ergodicity() == 1U)
-                Farm::f().shuffle();
-
-            // Rough implementation to return to primary pool
-            // after specified amount of time
-            if (m_activeConnectionIdx != 0 && m_Settings.poolFailoverTimeout)
-            {
-                m_failovertimer.expires_from_now(boost::posix_time::minutes(m_Settings.poolFailoverTimeout));
-                m_failovertimer.async_wait(m_io_strand.wrap(
-                    boost::bind(&PoolManager::failovertimer_elapsed, this, boost::asio::placeholders::error)));
-            }
-            else
-            {
-                m_failovertimer.cancel();
-            }
-        }
-
-        if (!Farm::f().isMining())
-        {
-            cnote << "Spinning up miners...";
-            Farm::f().start();
-        }
-        else if (Farm::f().paused())
-        {
-            cnote << "Resume mining ...";
-            Farm::f().resume();
-        }
-
-        // Activate timing for HR submission
-        if (m_Settings.reportHashrate)
-        {
-            m_submithrtimer.expires_from_now(boost::posix_time::seconds(m_Settings.hashRateInterval));
-            m_submithrtimer.async_wait(m_io_strand.wrap(
-                boost::bind(&PoolManager::submithrtimer_elapsed, this, boost::asio::placeholders::error)));
-        }
-
-        // Signal async operations have completed
-        m_async_pending.store(false, std::memory_order_relaxed);
-    });
+    p_client->onConnected([&]() { clientConnected(); });
 
     p_client->onDisconnected([&]() {
         cnote << "Disconnected from " << m_selectedHost;
 
         // Clear current connection
+        m_failedConnection = p_client->getConnection();
         p_client->unsetConnection();
         m_currentWp.header = h256();
 
         // Stop timing actors
         m_failovertimer.cancel();
         m_submithrtimer.cancel();
+        m_latencytimer.cancel();
 
         if (m_stopping.load(std::memory_order_relaxed))
         {
@@ -143,69 +90,180 @@ void PoolManager::setClientHandlers()
         }
     });
 
-    p_client->onWorkReceived([&](WorkPackage& wp) {
-        // Should not happen !
-        if (!wp || !wp.block.has_value())
-        {
-            cwarn << "Invalid work package received";
-            return;
-        }
+    p_client->onWorkReceived([&](WorkPackage& wp) { clientWorkReceived(wp); });
 
-        if (!wp.epoch.has_value())
-        {
-            wp.epoch.emplace(static_cast<uint32_t>(wp.block.value() / ethash::kEpoch_length));
-        }
+    p_client->onSolutionAccepted([&](SubmittedShare const& _share, bool _asStale) {
+        std::stringstream ss;
+        ss << std::setw(4) << std::setfill(' ') << _share.responseDelay().count() << " ms. " << m_selectedHost;
+        cnote << EthLime "**Accepted" << (_asStale ? " stale" : "") << EthReset << ss.str();
+        Farm::f().accountSolution(_share.midx, SolutionAccountingEnum::Accepted);
+        accountLatency(_share);
+    });
 
-        bool newEpoch{false};  // Whether or not the epoch has changed
-        bool newDiff{false};   // Whether or not difficulty has changed
+    p_client->onSolutionRejected([&](SubmittedShare const& _share) {
+        std::stringstream ss;
+        ss << std::setw(4) << std::setfill(' ') << _share.responseDelay().count() << " ms. " << m_selectedHost;
+        cwarn << EthRed "**Rejected" EthReset << ss.str();
+        Farm::f().accountSolution(_share.midx, SolutionAccountingEnum::Rejected);
+        accountLatency(_share);
+    });
+}
 
-        if (!m_currentWp)
-        {
-            newEpoch = true;
-            newDiff = true;
-        }
-        else
-        {
-            newEpoch = (m_currentWp.epoch.value() != wp.epoch.value());
-            newDiff = (m_currentWp.get_boundary() != wp.get_boundary());
-        }
+void PoolManager::clientConnected()
+{
+    // If HostName is already an IP address no need to append the
+    // effective ip address.
+    if (p_client->getConnection()->HostNameType() == dev::UriHostNameType::Dns ||
+        p_client->getConnection()->HostNameType() == dev::UriHostNameType::Basic)
+    {
+        string ep = p_client->ActiveEndPoint();
+        if (!ep.empty())
+            m_selectedHost = p_client->getConnection()->Host() + ep;
+    }
 
-        // Save package
-        m_currentWp = wp;
+    cnote << "Established connection to " << m_selectedHost;
 
-        // Increment epoch changes
-        if (newEpoch)
-        {
-            m_epochChanges.fetch_add(1, std::memory_order_relaxed);
-        }
+    // Reset current WorkPackage
+    m_currentWp.job.clear();
+    m_currentWp.header = h256();
 
-        // Show changes of epoch/diff
-        if (newDiff || newEpoch)
-        {
-            showMiningAt();
-        }
+    // Shuffle if needed
+    if (Farm::f().get_ergodicity() == 1U)
+        Farm::f().shuffle();
 
-        cnote << "Job: " EthWhite << m_currentWp.header.abridged()
-              << (m_currentWp.block.has_value() ? (" block " + to_string(m_currentWp.block.value())) : "") << EthReset
-              << " " << m_selectedHost;
+    // Rough implementation to return to primary pool
+    // after specified amount of time
+    if (m_activeConnectionIdx != 0 && m_Settings.poolFailoverTimeout)
+    {
+        m_failovertimer.expires_from_now(boost::posix_time::minutes(m_Settings.poolFailoverTimeout));
+        m_failovertimer.async_wait(m_io_strand.wrap(
+            boost::bind(&PoolManager::failovertimer_elapsed, this, boost::asio::placeholders::error)));
+    }
+    else
+    {
+        m_failovertimer.cancel();
+    }
 
-        Farm::f().setWork(m_currentWp);
-    });
+    if (!Farm::f().isMining())
+    {
+        cnote << "Spinning up miners...";
+        Farm::f().start();
+    }
+    else if (Farm::f().paused())
+    {
+        cnote << "Resume mining ...";
+        Farm::f().resume();
+    }
 
-    p_client->onSolutionAccepted(
-        [&](std::chrono::milliseconds const& _responseDelay, unsigned const& _minerIdx, bool _asStale) {
-            std::stringstream ss;
-            ss << std::setw(4) << std::setfill(' ') << _responseDelay.count() << " ms. " << m_selectedHost;
-            cnote << EthLime "**Accepted" << (_asStale ? " stale" : "") << EthReset << ss.str();
-            Farm::f().accountSolution(_minerIdx, SolutionAccountingEnum::Accepted);
-        });
+    // Activate timing for HR submission
+    if (m_Settings.reportHashrate)
+    {
+        m_submithrtimer.expires_from_now(boost::posix_time::seconds(m_Settings.hashRateInterval));
+        m_submithrtimer.async_wait(m_io_strand.wrap(
+            boost::bind(&PoolManager::submithrtimer_elapsed, this, boost::asio::placeholders::error)));
+    }
 
-    p_client->onSolutionRejected([&](std::chrono::milliseconds const& _responseDelay, unsigned const& _minerIdx) {
-        std::stringstream ss;
-        ss << std::setw(4) << std::setfill(' ') << _responseDelay.count() << " ms. " << m_selectedHost;
-        cwarn << EthRed "**Rejected" EthReset << ss.str();
-        Farm::f().accountSolution(_minerIdx, SolutionAccountingEnum::Rejected);
-    });
+    // Periodically look for a closer equivalent pool
+    if (m_Settings.preferLowLatency)
+    {
+        m_latencytimer.expires_from_now(boost::posix_time::seconds(60));
+        m_latencytimer.async_wait(m_io_strand.wrap(
+            boost::bind(&PoolManager::latencytimer_elapsed, this, boost::asio::placeholders::error)));
+    }
+
+    // Keep the following connections ready for failover
+    g_io_service.post(m_io_strand.wrap(boost::bind(&PoolManager::refreshStandbys, this)));
+
+    // Signal async operations have completed
+    m_async_pending.store(false, std::memory_order_relaxed);
+}
+
+void PoolManager::clientWorkReceived(WorkPackage& wp)
+{
+    // Should not happen !
+    if (!wp || !wp.block.has_value())
+    {
+        cwarn << "Invalid work package received";
+        return;
+    }
+
+    if (!wp.epoch.has_value())
+    {
+        wp.epoch.emplace(static_cast<uint32_t>(wp.block.value() / ethash::kEpoch_length));
+    }
+
+    bool newEpoch{false};  // Whether or not the epoch has changed
+    bool newDiff{false};   // Whether or not difficulty has changed
+
+    if (!m_currentWp)
+    {
+        newEpoch = true;
+        newDiff = true;
+    }
+    else
+    {
+        newEpoch = (m_currentWp.epoch.value() != wp.epoch.value());
+        newDiff = (m_currentWp.get_boundary() != wp.get_boundary());
+    }
+
+    // Save package. Shares of jobs from other connections are useless
+    // thus the first job of a connection is a clean one
+    bool firstJob = !m_currentWp;
+    m_currentWp = wp;
+    if (firstJob)
+        m_currentWp.clean = true;
+
+    // Increment epoch changes
+    if (newEpoch)
+    {
+        m_epochChanges.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Show changes of epoch/diff
+    if (newDiff || newEpoch)
+    {
+        showMiningAt();
+    }
+
+    cnote << "Job: " EthWhite << m_currentWp.header.abridged()
+          << (m_currentWp.block.has_value() ? (" block " + to_string(m_currentWp.block.value())) : "") << EthReset
+          << " " << m_selectedHost;
+
+    Farm::f().setWork(m_currentWp);
+}
+
+void PoolManager::accountLatency(SubmittedShare const& _share)
+{
+    auto findToAck = _share.findToAck();
+    Farm::f().accountLatency(_share.midx, findToAck);
+
+    // Accounted to the connection the share was submitted through
+    auto connection = p_client->getConnection();
+    if (!connection)
+        return;
+    Guard l(x_shareLatency);
+    m_shareLatency[connection->str()].add(findToAck);
+}
+
+Json::Value PoolManager::getShareLatencyJson(ShareLatencyType const& _latency)
+{
+    Json::Value jRes;
+    Json::Value jBuckets = Json::Value(Json::arrayValue);
+    for (size_t i = 0; i < _latency.counts.size(); i++)
+    {
+        Json::Value jBucket = Json::Value(Json::arrayValue);
+        if (i < ShareLatencyType::bounds.size())
+            jBucket.append(ShareLatencyType::bounds[i]);
+        else
+            jBucket.append(Json::Value::null);
+        jBucket.append(_latency.counts[i]);
+        jBuckets.append(jBucket);
+    }
+    jRes["samples"] = _latency.samples;
+    jRes["mean"] = _latency.meanMs();
+    jRes["max"] = _latency.maxMs;
+    jRes["buckets"] = jBuckets;
+    return jRes;
 }
 
 void PoolManager::stop()
@@ -215,6 +273,9 @@ void PoolManager::stop()
         m_async_pending.store(true, std::memory_order_relaxed);
         m_stopping.store(true, std::memory_order_relaxed);
 
+        // Drop standbys
+        g_io_service.post(m_io_strand.wrap(boost::bind(&PoolManager::refreshStandbys, this)));
+
         if (p_client && p_client->isConnected())
         {
             p_client->disconnect();
@@ -229,6 +290,7 @@ void PoolManager::stop()
             // Stop timing actors
             m_failovertimer.cancel();
             m_submithrtimer.cancel();
+            m_latencytimer.cancel();
 
             if (Farm::f().isMining())
             {
@@ -273,6 +335,8 @@ void PoolManager::removeConnection(unsigned int idx)
     m_Settings.connections.erase(m_Settings.connections.begin() + idx);
     if (m_activeConnectionIdx > idx)
         m_activeConnectionIdx--;
+
+    g_io_service.post(m_io_strand.wrap(boost::bind(&PoolManager::refreshStandbys, this)));
 }
 
 void PoolManager::setActiveConnectionCommon(unsigned int idx)
@@ -344,6 +408,15 @@ Json::Value PoolManager::getConnectionsJson()
         JConn["index"] = (unsigned)i;
         JConn["active"] = (i == m_activeConnectionIdx ? true : false);
         JConn["uri"] = m_Settings.connections[i]->str();
+        if (!m_Settings.connections[i]->Group().empty())
+            JConn["group"] = m_Settings.connections[i]->Group();
+        if (m_Settings.connections[i]->Rtt())
+            JConn["rtt"] = m_Settings.connections[i]->Rtt();
+
+        Guard l(x_shareLatency);
+        auto latency = m_shareLatency.find(m_Settings.connections[i]->str());
+        if (latency != m_shareLatency.end())
+            JConn["share_latency"] = getShareLatencyJson(latency->second);
         jRes.append(JConn);
     }
     return jRes;
@@ -400,21 +473,30 @@ void PoolManager::rotateConnect()
         }
     }
 
+    // Equivalent pools : go for the closest one
+    if (!m_Settings.connections.empty())
+    {
+        unsigned idx = lowLatencyConnection(m_activeConnectionIdx);
+        if (idx != m_activeConnectionIdx)
+        {
+            auto conn = m_Settings.connections.at(idx);
+            cnote << "Lowest latency pool of group " << conn->Group() << " is " << conn->Host() << ":"
+                  << conn->Port() << " (" << conn->Rtt() << " ms)";
+            m_activeConnectionIdx = idx;
+            m_connectionSwitches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // A standby already logged in spares the whole connection sequence
+    if (promoteStandby())
+        return;
+
     if (!m_Settings.connections.empty() && m_Settings.connections.at(m_activeConnectionIdx)->Host() != "exit")
     {
         if (p_client)
             p_client = nullptr;
 
-        if (m_Settings.connections.at(m_activeConnectionIdx)->Family() == ProtocolFamily::GETWORK)
-            p_client = std::unique_ptr<PoolClient>(
-//                new EthGetworkClient(m_Settings.noWorkTimeout, m_Settings.getWorkPollInterval, m_Settings.rewardAddress));
-                new EthGetworkClient(m_Settings.noWorkTimeout, m_Settings.getWorkPollInterval));
-        if (m_Settings.connections.at(m_activeConnectionIdx)->Family() == ProtocolFamily::STRATUM)
-            p_client = std::unique_ptr<PoolClient>(
-                new EthStratumClient(m_Settings.noWorkTimeout, m_Settings.noResponseTimeout));
-        if (m_Settings.connections.at(m_activeConnectionIdx)->Family() == ProtocolFamily::SIMULATION)
-            p_client =
-                std::unique_ptr<PoolClient>(new SimulateClient(m_Settings.benchmarkBlock, m_Settings.benchmarkDiff));
+        p_client = createClient(m_Settings.connections.at(m_activeConnectionIdx));
 
         if (p_client)
             setClientHandlers();
@@ -429,6 +511,9 @@ void PoolManager::rotateConnect()
         cnote << "Selected pool " << m_selectedHost;
 
         p_client->connect();
+
+        // A standby of the selected connection is of no use anymore
+        refreshStandbys();
     }
     else
     {
@@ -449,6 +534,254 @@ void PoolManager::rotateConnect()
     }
 }
 
+std::unique_ptr<PoolClient> PoolManager::createClient(std::shared_ptr<URI> const& _conn)
+{
+    if (_conn->Family() == ProtocolFamily::GETWORK)
+        return std::unique_ptr<PoolClient>(
+//            new EthGetworkClient(m_Settings.noWorkTimeout, m_Settings.getWorkPollInterval, m_Settings.rewardAddress));
+            new EthGetworkClient(m_Settings.noWorkTimeout, m_Settings.getWorkPollInterval));
+    if (_conn->Family() == ProtocolFamily::STRATUM)
+        // Latency of equivalent pools is kept measured with a ping every 30 seconds
+        return std::unique_ptr<PoolClient>(new EthStratumClient(
+            m_Settings.noWorkTimeout, m_Settings.noResponseTimeout, m_Settings.preferLowLatency ? 30 : 0));
+    if (_conn->Family() == ProtocolFamily::SIMULATION)
+        return std::unique_ptr<PoolClient>(new SimulateClient(m_Settings.benchmarkBlock, m_Settings.benchmarkDiff));
+    return nullptr;
+}
+
+void PoolManager::refreshStandbys()
+{
+    // Standbys are the stratum connections following the active one, up
+    // to an 'exit' one which ends the failover loop
+    std::vector<std::shared_ptr<URI>> wanted;
+    if (m_Settings.standbyConnections && m_running.load(std::memory_order_relaxed) &&
+        !m_stopping.load(std::memory_order_relaxed) && m_activeConnectionIdx < m_Settings.connections.size())
+    {
+        // When preferring low latency the equivalents of the active
+        // connection come first so their latency gets measured
+        std::vector<std::shared_ptr<URI>> following;
+        auto active = m_Settings.connections.at(m_activeConnectionIdx);
+        if (m_Settings.preferLowLatency && !active->Group().empty())
+        {
+            for (size_t i = 1; i < m_Settings.connections.size(); i++)
+            {
+                auto conn = m_Settings.connections.at((m_activeConnectionIdx + i) % m_Settings.connections.size());
+                if (conn->Group() == active->Group() && conn->Host() != "exit")
+                    following.push_back(conn);
+            }
+        }
+        for (size_t i = 1; i < m_Settings.connections.size(); i++)
+        {
+            auto conn = m_Settings.connections.at((m_activeConnectionIdx + i) % m_Settings.connections.size());
+            if (conn->Host() == "exit")
+                break;
+            if (std::find(following.begin(), following.end(), conn) == following.end())
+                following.push_back(conn);
+        }
+
+        for (auto& conn : following)
+        {
+            if (wanted.size() == m_Settings.standbyConnections)
+                break;
+            if (conn->Family() == ProtocolFamily::STRATUM && !conn->IsUnrecoverable())
+                wanted.push_back(conn);
+        }
+    }
+
+    // Copy as retiring may discard immediately
+    auto standbys = m_standbys;
+    for (auto& sb : standbys)
+    {
+        auto it = std::find(wanted.begin(), wanted.end(), sb->conn);
+        if (it == wanted.end())
+        {
+            if (!sb->retiring)
+                retireStandby(sb);
+        }
+        else if (!sb->retiring)
+        {
+            wanted.erase(it);
+        }
+    }
+
+    for (auto& conn : wanted)
+    {
+        auto sb = std::make_shared<StandbyConnection>();
+        sb->conn = conn;
+        m_standbys.push_back(sb);
+        connectStandby(sb);
+    }
+}
+
+bool PoolManager::promoteStandby()
+{
+    if (m_standbys.empty() || m_stopping.load(std::memory_order_relaxed) || m_Settings.connections.empty())
+        return false;
+
+    // When the active connection dropped by itself any following standby
+    // will do. When a specific connection has been selected (api, return
+    // to primary) only its own standby is of use
+    auto target = m_Settings.connections.at(m_activeConnectionIdx);
+    size_t candidates = (target == m_failedConnection ? m_Settings.connections.size() : 1);
+
+    for (size_t i = 0; i < candidates; i++)
+    {
+        unsigned idx = unsigned((m_activeConnectionIdx + i) % m_Settings.connections.size());
+        auto conn = m_Settings.connections.at(idx);
+        if (conn->Host() == "exit")
+            break;
+
+        for (auto& sb : m_standbys)
+        {
+            if (sb->conn != conn || !standbyReady(*sb))
+                continue;
+
+            auto promoted = sb;
+            m_standbys.remove(promoted);
+            promoted->retrytimer.cancel();
+
+            if (idx != m_activeConnectionIdx)
+                m_connectionSwitches.fetch_add(1, std::memory_order_relaxed);
+            m_activeConnectionIdx = idx;
+            m_connectionAttempt = 0;
+            m_failedConnection = nullptr;
+
+            p_client = std::move(promoted->client);
+            setClientHandlers();
+
+            m_selectedHost = conn->Host() + ":" + to_string(conn->Port());
+            cnote << "Switching to standby pool " << m_selectedHost;
+
+            clientConnected();
+            clientWorkReceived(promoted->wp);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PoolManager::connectStandby(std::shared_ptr<StandbyConnection> _sb)
+{
+    _sb->client = createClient(_sb->conn);
+
+    // Handlers are invoked in the client's strand: hop to ours
+    std::weak_ptr<StandbyConnection> wsb = _sb;
+    _sb->client->onConnected([this, wsb]() {
+        g_io_service.post(m_io_strand.wrap(boost::bind(&PoolManager::standbyConnected, this, wsb.lock())));
+    });
+    _sb->client->onDisconnected([this, wsb]() {
+        g_io_service.post(m_io_strand.wrap(boost::bind(&PoolManager::standbyDisconnected, this, wsb.lock())));
+    });
+    _sb->client->onWorkReceived([this, wsb](WorkPackage& wp) {
+        g_io_service.post(m_io_strand.wrap(boost::bind(&PoolManager::standbyWorkReceived, this, wsb.lock(), wp)));
+    });
+
+    _sb->client->setConnection(_sb->conn);
+    _sb->client->connect();
+}
+
+void PoolManager::retireStandby(std::shared_ptr<StandbyConnection> _sb)
+{
+    _sb->retiring = true;
+    _sb->retrytimer.cancel();
+
+    // Clients must be disconnected before being discarded. The ones in
+    // the middle of connecting are handled when that completes
+    if (_sb->client && _sb->client->isConnected())
+        _sb->client->disconnect();
+    else if (!_sb->client || !_sb->client->isPendingState())
+        m_standbys.remove(_sb);
+}
+
+void PoolManager::standbyConnected(std::shared_ptr<StandbyConnection> _sb)
+{
+    if (!_sb || !_sb->client)
+        return;
+
+    if (_sb->retiring)
+    {
+        _sb->client->disconnect();
+        return;
+    }
+
+    cnote << "Standby connection to " << _sb->conn->Host() << ":" << _sb->conn->Port() << " established";
+}
+
+void PoolManager::standbyDisconnected(std::shared_ptr<StandbyConnection> _sb)
+{
+    // Promoted meanwhile
+    if (!_sb || !_sb->client)
+        return;
+
+    _sb->client->unsetConnection();
+    _sb->client = nullptr;
+    _sb->wp = WorkPackage();
+
+    if (_sb->retiring || _sb->conn->IsUnrecoverable() || m_stopping.load(std::memory_order_relaxed))
+    {
+        m_standbys.remove(_sb);
+        return;
+    }
+
+    // Retry with exponential backoff : 1, 2, 4 ... up to 64 seconds
+    unsigned delay = 1U << std::min(_sb->failures++, 6U);
+    cnote << "Standby connection to " << _sb->conn->Host() << ":" << _sb->conn->Port() << " lost. Retry in "
+          << delay << " s";
+    _sb->retrytimer.expires_from_now(boost::posix_time::seconds(delay));
+    _sb->retrytimer.async_wait(m_io_strand.wrap(
+        boost::bind(&PoolManager::standbytimer_elapsed, this, _sb, boost::asio::placeholders::error)));
+}
+
+void PoolManager::standbyWorkReceived(std::shared_ptr<StandbyConnection> _sb, WorkPackage _wp)
+{
+    if (!_sb || !_sb->client || _sb->retiring)
+        return;
+
+    // A pool sending jobs is healthy
+    _sb->wp = _wp;
+    _sb->wpTstamp = std::chrono::steady_clock::now();
+    _sb->failures = 0;
+}
+
+void PoolManager::standbytimer_elapsed(std::shared_ptr<StandbyConnection> _sb, const boost::system::error_code& ec)
+{
+    if (!ec && !_sb->retiring && m_running.load(std::memory_order_relaxed))
+        connectStandby(_sb);
+}
+
+bool PoolManager::standbyReady(StandbyConnection const& _sb)
+{
+    // Logged in and receiving jobs
+    return !_sb.retiring && _sb.client && _sb.client->isConnected() && _sb.client->isAuthorized() && _sb.wp &&
+           std::chrono::steady_clock::now() - _sb.wpTstamp <= std::chrono::seconds(m_Settings.noWorkTimeout);
+}
+
+unsigned PoolManager::lowLatencyConnection(unsigned _idx)
+{
+    auto selected = m_Settings.connections.at(_idx);
+    if (!m_Settings.preferLowLatency || selected->Group().empty())
+        return _idx;
+
+    // Pools never measured (thus never reached) and the one which just
+    // dropped us are no candidates
+    unsigned best = _idx;
+    unsigned bestRtt = (selected == m_failedConnection || !selected->Rtt()) ? UINT_MAX : selected->Rtt();
+    for (unsigned i = 0; i < m_Settings.connections.size(); i++)
+    {
+        auto conn = m_Settings.connections.at(i);
+        if (i == _idx || conn->Group() != selected->Group() || conn == m_failedConnection ||
+            conn->IsUnrecoverable() || !conn->Rtt())
+            continue;
+        if (conn->Rtt() < bestRtt)
+        {
+            best = i;
+            bestRtt = conn->Rtt();
+        }
+    }
+    return best;
+}
+
 void PoolManager::showMiningAt()
 {
     // Should not happen
@@ -480,6 +813,46 @@ void PoolManager::failovertimer_elapsed(const boost::system::error_code& ec)
     }
 }
 
+void PoolManager::latencytimer_elapsed(const boost::system::error_code& ec)
+{
+    if (ec || !m_running.load(std::memory_order_relaxed) || m_stopping.load(std::memory_order_relaxed))
+        return;
+
+    // Switch to an equivalent standby at least 20% closer than the active
+    // connection. Promotion takes care of it after the disconnection
+    auto active = getActiveConnection();
+    if (active && !active->Group().empty() && active->Rtt() && p_client && p_client->isConnected())
+    {
+        std::shared_ptr<URI> best;
+        for (auto& sb : m_standbys)
+        {
+            if (sb->conn->Group() != active->Group() || !sb->conn->Rtt() || !standbyReady(*sb))
+                continue;
+            if (sb->conn->Rtt() * 5 < active->Rtt() * 4 && (!best || sb->conn->Rtt() < best->Rtt()))
+                best = sb->conn;
+        }
+
+        if (best)
+        {
+            auto it = std::find(m_Settings.connections.begin(), m_Settings.connections.end(), best);
+            if (it != m_Settings.connections.end())
+            {
+                cnote << "Switching to lower latency pool " << best->Host() << ":" << best->Port() << " ("
+                      << best->Rtt() << " ms vs " << active->Rtt() << " ms)";
+                m_activeConnectionIdx = unsigned(it - m_Settings.connections.begin());
+                m_connectionAttempt = 0;
+                m_connectionSwitches.fetch_add(1, std::memory_order_relaxed);
+                p_client->disconnect();
+                return;
+            }
+        }
+    }
+
+    m_latencytimer.expires_from_now(boost::posix_time::seconds(60));
+    m_latencytimer.async_wait(m_io_strand.wrap(
+        boost::bind(&PoolManager::latencytimer_elapsed, this, boost::asio::placeholders::error)));
+}
+
 void PoolManager::submithrtimer_elapsed(const boost::system::error_code& ec)
 {
     if (!ec)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <list>
 
 #include <json/json.h>
 
@@ -30,11 +31,27 @@ struct PoolSettings
     unsigned hashRateInterval = 60;                 // Interval in seconds among hashrate submissions
     std::string hashRateId = h256::random().hex(HexPrefix::Add);  // Unique identifier for HashRate submission
     unsigned connectionMaxRetries = 9000;                         // Max number of connection retries
+    unsigned standbyConnections = 0;  // Following connections kept established for instant failover
+    bool preferLowLatency = false;    // Mine the lowest rtt one among connections of a same group
     unsigned benchmarkBlock = 0;  // Block number used by SimulateClient to test performances
     float benchmarkDiff = 1.0;    // Difficulty used by SimulateClient to test performances
 //    std::string rewardAddress;    // Reward address in case of solo mining
 };
 
+// A connection kept established, subscribed and authorized while another
+// one is mined. Its jobs are tracked but not mined so failing over to it
+// only takes a setWork
+struct StandbyConnection
+{
+    std::shared_ptr<URI> conn;
+    std::unique_ptr<PoolClient> client;
+    WorkPackage wp;                                     // Last job received
+    std::chrono::steady_clock::time_point wpTstamp;     // When it was received
+    unsigned failures = 0;                              // Consecutive failed sessions (backoff)
+    bool retiring = false;                              // Being disconnected to be discarded
+    boost::asio::deadline_timer retrytimer{g_io_service};
+};
+
 class PoolManager
 {
 public:
@@ -56,19 +73,42 @@ public:
     unsigned getConnectionSwitches();
     unsigned getEpochChanges();
 
+    // Find to acknowledge latency of shares as reported through the api
+    static Json::Value getShareLatencyJson(ShareLatencyType const& _latency);
+
 private:
     void rotateConnect();
 
     void setClientHandlers();
+    void clientConnected();
+    void clientWorkReceived(WorkPackage& wp);
+    std::unique_ptr<PoolClient> createClient(std::shared_ptr<URI> const& _conn);
+
+    // Standby connections. All run in PoolManager's strand
+    void refreshStandbys();
+    bool promoteStandby();
+    void connectStandby(std::shared_ptr<StandbyConnection> _sb);
+    void retireStandby(std::shared_ptr<StandbyConnection> _sb);
+    void standbyConnected(std::shared_ptr<StandbyConnection> _sb);
+    void standbyDisconnected(std::shared_ptr<StandbyConnection> _sb);
+    void standbyWorkReceived(std::shared_ptr<StandbyConnection> _sb, WorkPackage _wp);
+    void standbytimer_elapsed(
+        std::shared_ptr<StandbyConnection> _sb, const boost::system::error_code& ec);
+    bool standbyReady(StandbyConnection const& _sb);
+
+    unsigned lowLatencyConnection(unsigned _idx);
 
     void showMiningAt();
 
     void setActiveConnectionCommon(unsigned int idx);
 
+    void accountLatency(SubmittedShare const& _share);
+
     PoolSettings m_Settings;
 
     void failovertimer_elapsed(const boost::system::error_code& ec);
     void submithrtimer_elapsed(const boost::system::error_code& ec);
+    void latencytimer_elapsed(const boost::system::error_code& ec);
 
     std::atomic<bool> m_running = {false};
     std::atomic<bool> m_stopping = {false};
@@ -86,11 +126,18 @@ private:
     boost::asio::io_service::strand m_io_strand;
     boost::asio::deadline_timer m_failovertimer;
     boost::asio::deadline_timer m_submithrtimer;
+    boost::asio::deadline_timer m_latencytimer;
 
     std::unique_ptr<PoolClient> p_client = nullptr;
 
+    std::list<std::shared_ptr<StandbyConnection>> m_standbys;
+    std::shared_ptr<URI> m_failedConnection;  // Last active connection dropped by the pool side
+
     std::atomic<unsigned> m_epochChanges = {0};
 
+    Mutex x_shareLatency;
+    std::map<std::string, ShareLatencyType> m_shareLatency;  // Per connection uri
+
     static PoolManager* m_this;
 };
 
@@ -254,8 +254,9 @@ URI::URI(std::string uri, bool _sim) : m_uri{std::move(uri)}
       - host/path
       - host:port
       - host:port/path
+      - host:port?query (e.g. ?group=name)
     */
-    size_t offset = m_urlinfo.find('/');
+    size_t offset = m_urlinfo.find_first_of("/?#");
     if (offset != std::string::npos)
     {
         m_hostinfo = m_urlinfo.substr(0, offset);
@@ -289,9 +290,9 @@ URI::URI(std::string uri, bool _sim) : m_uri{std::move(uri)}
         // Url Decode Path
 
         std::vector<std::regex> path_patterns;
-        path_patterns.push_back(std::regex("(\\/.*)\\?(.*)\\#(.*)$"));
-        path_patterns.push_back(std::regex("(\\/.*)\\#(.*)$"));
-        path_patterns.push_back(std::regex("(\\/.*)\\?(.*)$"));
+        path_patterns.push_back(std::regex("^([^?#]*)\\?([^#]*)\\#(.*)$"));
+        path_patterns.push_back(std::regex("^([^?#]*)\\#(.*)$"));
+        path_patterns.push_back(std::regex("^([^?#]*)\\?(.*)$"));
         bool pathMatchFound = false;
         for (size_t i = 0; i < path_patterns.size() && !pathMatchFound; i++)
         {
@@ -381,6 +382,27 @@ URI::URI(std::string uri, bool _sim) : m_uri{std::move(uri)}
         m_password = tmpStr;
     if (url_decode(m_worker, tmpStr))
         m_worker = tmpStr;
+
+    // Query holds options of the connection : key=value pairs separated by &
+    std::vector<std::string> options;
+    boost::split(options, m_query, boost::is_any_of("&"), boost::token_compress_on);
+    for (auto const& option : options)
+    {
+        size_t eq = option.find('=');
+        if (eq != std::string::npos && option.substr(0, eq) == "group")
+            m_group = option.substr(eq + 1);
+    }
+}
+
+void URI::addRtt(unsigned _ms)
+{
+    // Exponentially weighted (1/8) as TCP smoothes its rtt. Probes may
+    // complete concurrently so no sample is lost on a race
+    unsigned rtt = m_rtt.load(std::memory_order_relaxed);
+    unsigned smoothed;
+    do
+        smoothed = rtt ? std::max((rtt * 7 + _ms) / 8, 1U) : std::max(_ms, 1U);
+    while (!m_rtt.compare_exchange_weak(rtt, smoothed, std::memory_order_relaxed));
 }
 
 ProtocolFamily URI::Family() const
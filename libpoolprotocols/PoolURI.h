@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <regex>
 #include <string>
 
@@ -90,6 +91,13 @@ public:
     void addDuration(unsigned long _minutes) { m_totalDuration += _minutes; }
     unsigned long getDuration() { return m_totalDuration; }
 
+    // Connections sharing a group (?group=name) are equivalent pools
+    std::string Group() const { return m_group; }
+
+    // Smoothed round trip time to the pool in ms. 0 means not measured yet
+    void addRtt(unsigned _ms);
+    unsigned Rtt() const { return m_rtt.load(std::memory_order_relaxed); }
+
 private:
     std::string m_scheme;
     std::string m_authority;  // Contains all text after scheme
@@ -102,6 +110,7 @@ private:
     std::string m_path;
     std::string m_query;
     std::string m_fragment;
+    std::string m_group;
     std::string m_user;
     std::string m_password = "X";
     std::string m_worker;
@@ -117,6 +126,7 @@ private:
     bool m_isLoopBack;
 
     unsigned long m_totalDuration; // Total duration on this connection in minutes
+    std::atomic<unsigned> m_rtt = {0};  // Smoothed (ms), probed and read from different threads
 
 };
 }  // namespace dev
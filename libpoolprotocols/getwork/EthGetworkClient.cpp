@@ -480,24 +480,23 @@ void EthGetworkClient::processResponse(Json::Value& JRes)
         // Response to hashrate submission
         // Actually don't do anything
     }
-    else if (_id >= 40 && _id <= m_solution_submitted_max_id)
+    else if (m_submissions.contains(_id))
     {
+        SubmittedShare share;
+        m_submissions.take(_id, share);
+
         if (_isSuccess && JRes["result"].isConvertibleTo(Json::ValueType::booleanValue))
             _isSuccess = JRes["result"].asBool();
 
-        std::chrono::milliseconds _delay =
-            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_pending_tstamp);
-
-        const unsigned miner_index = _id - 40;
         if (_isSuccess)
         {
             if (m_onSolutionAccepted)
-                m_onSolutionAccepted(_delay, miner_index, false);
+                m_onSolutionAccepted(share, false);
         }
         else
         {
             if (m_onSolutionRejected)
-                m_onSolutionRejected(_delay, miner_index);
+                m_onSolutionRejected(share);
         }
     }
 }
@@ -580,10 +579,8 @@ void EthGetworkClient::submitSolution(const Solution& solution)
         Json::Value jReq;
         string nonceHex = toHex(solution.nonce, dev::HexPrefix::Add);
 
-        unsigned id = 40 + solution.midx;
-        jReq["id"] = id;
+        jReq["id"] = m_submissions.add(solution);
         jReq["jsonrpc"] = "2.0";
-        m_solution_submitted_max_id = max(m_solution_submitted_max_id, id);
         jReq["method"] = "pprpcsb";
         jReq["params"] = Json::Value(Json::arrayValue);
         jReq["params"].append(solution.work.header.hex());  // Don't prepend 0x (evrprogpow has a dictionary of hashes)
@@ -68,7 +68,6 @@ private:
     int m_worktimeout;
     std::chrono::time_point<std::chrono::steady_clock> m_current_tstamp;
 
-    unsigned m_solution_submitted_max_id;  // maximum json id we used to send a solution
 
     std::string m_base64_auth{};  // Used by evrprogpow for http authentication;
 };
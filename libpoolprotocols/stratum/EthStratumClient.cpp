@@ -1,6 +1,7 @@
 #include <meowpowminer/buildinfo.h>
 #include <libdevcore/Log.h>
 #include <libpoolprotocols/stratum/arith_uint256.h>
+#include <libpoolprotocols/stratum/uint256.h>
 #include <libcrypto/ethash.hpp>
 
 
@@ -13,10 +14,11 @@
 
 using boost::asio::ip::tcp;
 
-EthStratumClient::EthStratumClient(int worktimeout, int responsetimeout)
+EthStratumClient::EthStratumClient(int worktimeout, int responsetimeout, unsigned pinginterval)
   : PoolClient(),
     m_worktimeout(worktimeout),
     m_responsetimeout(responsetimeout),
+    m_pinginterval(pinginterval),
     m_io_service(g_io_service),
     m_io_strand(g_io_service),
     m_socket(nullptr),
@@ -227,6 +229,7 @@ void EthStratumClient::disconnect_finalize()
     }
     m_socket = nullptr;
     m_nonsecuresocket = nullptr;
+    close_race();
 
     // Release locking flag and set connection status
 #ifdef DEV_BUILD
@@ -270,7 +273,7 @@ void EthStratumClient::disconnect_finalize()
 
     // Clear plea queue and stop timing
     clear_response_pleas();
-    m_solution_submitted_max_id = 0;
+    m_submissions.clear();
 
     // Put the actor back to sleep
     m_workloop_timer.expires_at(boost::posix_time::pos_infin);
@@ -317,24 +320,50 @@ void EthStratumClient::start_connect()
 
     if (!m_endpoints.empty())
     {
-        // Pick the first endpoint in list.
-        // Eventually endpoints get discarded on connection errors
-        m_endpoint = m_endpoints.front();
-
         // Re-init socket if we need to
         if (m_socket == nullptr)
             init_socket();
 
+        clear_response_pleas();
+        m_connecting.store(true, std::memory_order::memory_order_relaxed);
+        enqueue_response_plea();
+        m_submissions.clear();
+
+        // Host resolves to many addresses : race the first ones and keep
+        // the first to connect. Secure streams get their socket swapped in
+        // before the handshake
+        if (m_endpoints.size() > 1)
+        {
+            close_race();
+            while (!m_endpoints.empty() && m_raceSockets.size() < kRaceWidth)
+            {
+                boost::asio::ip::tcp::endpoint endpoint = m_endpoints.front();
+                m_endpoints.pop();
+
+#ifdef DEV_BUILD
+                if (g_logOptions & LOG_CONNECT)
+                    cnote << ("Trying " + toString(endpoint) + " ...");
+#endif
+
+                auto socket = std::make_shared<boost::asio::ip::tcp::socket>(m_io_service);
+                m_raceSockets.push_back(socket);
+                m_racePending++;
+                socket->async_connect(endpoint,
+                    m_io_strand.wrap(boost::bind(&EthStratumClient::race_handler, this, _1, socket,
+                        endpoint, m_raceId)));
+            }
+            return;
+        }
+
+        // Pick the first endpoint in list.
+        // Eventually endpoints get discarded on connection errors
+        m_endpoint = m_endpoints.front();
+
 #ifdef DEV_BUILD
         if (g_logOptions & LOG_CONNECT)
             cnote << ("Trying " + toString(m_endpoint) + " ...");
 #endif
 
-        clear_response_pleas();
-        m_connecting.store(true, std::memory_order::memory_order_relaxed);
-        enqueue_response_plea();
-        m_solution_submitted_max_id = 0;
-
         // Start connecting async
         if (m_conn->SecLevel() != SecureLevel::NONE)
         {
@@ -357,6 +386,73 @@ void EthStratumClient::start_connect()
     }
 }
 
+void EthStratumClient::race_handler(const boost::system::error_code& ec,
+    std::shared_ptr<boost::asio::ip::tcp::socket> socket, boost::asio::ip::tcp::endpoint endpoint,
+    unsigned race)
+{
+    // Late completion of a race already decided. The socket goes with us
+    if (race != m_raceId)
+        return;
+    m_racePending--;
+
+    if (!ec && socket->is_open())
+    {
+        close_race();
+
+        // Winner leads the list of endpoints so a reconnection (stratum
+        // autodetection) goes straight to it
+        m_endpoint = endpoint;
+        std::queue<boost::asio::ip::basic_endpoint<boost::asio::ip::tcp>> endpoints;
+        endpoints.push(endpoint);
+        while (!m_endpoints.empty())
+        {
+            endpoints.push(m_endpoints.front());
+            m_endpoints.pop();
+        }
+        m_endpoints.swap(endpoints);
+
+        *m_socket = std::move(*socket);
+        connect_handler(ec);
+        return;
+    }
+
+    cwarn << ("Error  " + toString(endpoint) + " [ " + (ec ? ec.message() : "Timeout") + " ]");
+
+    if (m_racePending == 0)
+    {
+        // Every raced endpoint failed. Go on with the remaining ones
+        close_race();
+        m_connecting.store(false, std::memory_order_relaxed);
+        m_io_service.post(m_io_strand.wrap(boost::bind(&EthStratumClient::start_connect, this)));
+    }
+}
+
+void EthStratumClient::close_race()
+{
+    // Handlers still pending see a different race id and bail out
+    m_raceId++;
+    m_racePending = 0;
+    for (auto& socket : m_raceSockets)
+    {
+        boost::system::error_code ec;
+        socket->close(ec);
+    }
+    m_raceSockets.clear();
+}
+
+void EthStratumClient::sendPing()
+{
+    Json::Value jReq;
+    jReq["id"] = unsigned(7);
+    jReq["method"] = "mining.noop";
+    if (m_conn->StratumMode() != ETHEREUMSTRATUM2)
+        jReq["params"] = Json::Value(Json::arrayValue);
+
+    m_pingSent = std::chrono::steady_clock::now();
+    m_pingPending = true;
+    send(jReq);
+}
+
 void EthStratumClient::workloop_timer_elapsed(const boost::system::error_code& ec)
 {
     using namespace std::chrono;
@@ -374,13 +470,15 @@ void EthStratumClient::workloop_timer_elapsed(const boost::system::error_code& e
         if (s > ((int)m_session->timeout - 5))
         {
             // Send a message 5 seconds before expiration
-            Json::Value jReq;
-            jReq["id"] = unsigned(7);
-            jReq["method"] = "mining.noop";
-            send(jReq);
+            sendPing();
         }
     }
 
+    // Keep measuring the round trip time to the pool
+    if (m_pinginterval && isConnected() && m_conn->StratumModeConfirmed() &&
+        steady_clock::now() - m_pingSent >= seconds(m_pinginterval))
+        sendPing();
+
 
     if (m_response_pleas_count.load(std::memory_order_relaxed))
     {
@@ -401,6 +499,11 @@ void EthStratumClient::workloop_timer_elapsed(const boost::system::error_code& e
                     // The socket is closed so that any outstanding
                     // asynchronous connection operations are cancelled.
                     m_socket->close();
+                    for (auto& socket : m_raceSockets)
+                    {
+                        boost::system::error_code cec;
+                        socket->close(cec);
+                    }
                     return;
                 }
 
@@ -501,6 +604,8 @@ void EthStratumClient::connect_handler(const boost::system::error_code& ec)
     m_connected.store(true, memory_order_relaxed);
 
     m_message.clear();
+    m_submitTemplate.clear();
+    m_pingPending = false;
 
     // Clear txqueue
     m_txQueue.consume_all([](std::string* l) { delete l; });
@@ -759,6 +864,200 @@ bool EthStratumClient::processExtranonce(std::string& enonce)
     return false;
 }
 
+void EthStratumClient::processLine(const char* _data, std::size_t _size)
+{
+    // Trim
+    while (_size && isspace(static_cast<unsigned char>(*_data)))
+    {
+        _data++;
+        _size--;
+    }
+    while (_size && isspace(static_cast<unsigned char>(_data[_size - 1])))
+        _size--;
+    if (!_size)
+        return;
+
+    // Out received message only for debug purpouses
+    if (g_logOptions & LOG_JSON)
+        cnote << " << " << std::string(_data, _size);
+
+    // Hot messages are handled without building a json document
+    dev::stratum::StratumMessage msg;
+    if (dev::stratum::scanStratumMessage(_data, _size, msg) && processFastResponse(msg))
+        return;
+
+    // Test validity of chunk and process
+    Json::Value jMsg;
+    Json::Reader jRdr;
+    if (jRdr.parse(_data, _data + _size, jMsg))
+    {
+        try
+        {
+            // Run in sync so no 2 different async reads may overlap
+            processResponse(jMsg);
+        }
+        catch (const std::exception& _ex)
+        {
+            cwarn << "Stratum got invalid Json message : " << _ex.what();
+        }
+    }
+    else
+    {
+        string what = jRdr.getFormattedErrorMessages();
+        boost::replace_all(what, "\n", " ");
+        cwarn << "Stratum got invalid Json message : " << what;
+    }
+}
+
+bool EthStratumClient::processFastResponse(dev::stratum::StratumMessage const& _msg)
+{
+    using dev::stratum::JsonToken;
+
+    // Anything processResponse would complain about or needs the
+    // full document for is left to it
+    if ((_msg.jsonrpc.kind != JsonToken::Kind::None &&
+            (!_msg.jsonrpc.isString() || _msg.jsonrpc.text != "2.0")) ||
+        (_msg.error.kind != JsonToken::Kind::None && _msg.error.kind != JsonToken::Kind::Null))
+        return false;
+
+    if (_msg.method.empty() && _msg.id != 0)
+    {
+        // Responses to mining.submit
+        if (m_conn->StratumMode() == ETHEREUMSTRATUM2 || !m_submissions.contains(_msg.id))
+            return false;
+
+        bool isSuccess = _msg.result.kind == JsonToken::Kind::Bool ? _msg.result.isTrue() : true;
+        processSubmitResponse(_msg.id, isSuccess, "", false);
+        return true;
+    }
+
+    if (!m_conn->StratumModeConfirmed() || !_msg.paramsCount)
+        return false;
+
+    if (_msg.method == "mining.notify" && m_conn->StratumMode() != ETHEREUMSTRATUM2)
+    {
+        // Nanopool sends jobs in "result"
+        if (_msg.result.kind != JsonToken::Kind::None)
+            return false;
+
+        // Discard jobs if not properly subscribed
+        // or if a job for this transmission has already
+        // been processed
+        if (!isSubscribed() || m_newjobprocessed)
+            return true;
+
+        if (!decodeNotify(_msg, m_current))
+            return false;
+
+        m_current_timestamp = std::chrono::steady_clock::now();
+
+        // This will signal to dispatch the job
+        // at the end of the transmission.
+        m_newjobprocessed = true;
+        return true;
+    }
+
+    if (_msg.method == "mining.set_target")
+    {
+        h256 boundary;
+        if (!_msg.params[0].isString() || !dev::stratum::hexToHash(_msg.params[0].text, boundary))
+            return false;
+
+        m_current.boundary = boundary;
+        cnote << "New target set to: " << _msg.params[0].text;
+        return true;
+    }
+
+    if (_msg.method == "mining.set_difficulty" && m_conn->StratumMode() == ETHEREUMSTRATUM)
+    {
+        if (_msg.params[0].kind != JsonToken::Kind::Number || _msg.params[0].text.size() > 31)
+            return false;
+
+        char buffer[32];
+        _msg.params[0].text.copy(buffer, _msg.params[0].text.size());
+        buffer[_msg.params[0].text.size()] = '\0';
+        double nextWorkDifficulty = max(strtod(buffer, nullptr), 0.0001);
+
+        m_session->nextWorkBoundary = h256(dev::getTargetFromDiff(nextWorkDifficulty));
+        return true;
+    }
+
+    return false;
+}
+
+bool EthStratumClient::decodeNotify(dev::stratum::StratumMessage const& _msg, WorkPackage& _wp)
+{
+    using dev::stratum::JsonToken;
+    using dev::stratum::hexToHash;
+    using dev::stratum::parseUnsigned;
+
+    JsonToken const* prm = _msg.params;
+    if (!prm[0].isString())
+        return false;
+
+    uint64_t height;
+    if (m_conn->StratumMode() == EthStratumClient::ETHEREUMSTRATUM)
+    {
+        // [job, seed, header, height]
+        if (_msg.paramsCount < 4 || !prm[1].isString() || !prm[2].isString() ||
+            !prm[3].isString() || !hexToHash(prm[1].text, _wp.seed) ||
+            !hexToHash(prm[2].text, _wp.header) || !parseUnsigned(prm[3].text, height, 0))
+            return false;
+
+        _wp.boundary = m_session->nextWorkBoundary;
+        _wp.clean = false;
+    }
+    else
+    {
+        // [job, header, seed, target, clean, height, bits]
+        uint64_t bits;
+        if (_msg.paramsCount < 7 || !prm[1].isString() || !prm[2].isString() ||
+            !prm[3].isString() || prm[5].kind != JsonToken::Kind::Number || !prm[6].isString() ||
+            !hexToHash(prm[1].text, _wp.header) || !hexToHash(prm[2].text, _wp.seed) ||
+            !hexToHash(prm[3].text, _wp.boundary, true) || !parseUnsigned(prm[5].text, height) ||
+            !parseUnsigned(prm[6].text, bits, 16) || height > 0x9660180 || bits > UINT32_MAX)
+            return false;
+
+        // Block target comes in compact form. uint256 is little endian
+        uint256 blockTarget = ArithToUint256(arith_uint256().SetCompact(uint32_t(bits)));
+        std::reverse_copy(blockTarget.begin(), blockTarget.end(), _wp.block_boundary.data());
+        _wp.clean = prm[4].isTrue();
+    }
+
+    _wp.job.assign(prm[0].text);
+    _wp.startNonce = m_session->extraNonce;
+    _wp.exSizeBytes = m_session->extraNonceSizeBytes;
+    _wp.block.emplace(height);
+    return true;
+}
+
+void EthStratumClient::processSubmitResponse(
+    unsigned _id, bool _isSuccess, std::string const& _errReason, bool _isStale)
+{
+    // Response timeouts are still watched through pleas
+    dequeue_response_plea();
+
+    SubmittedShare share;
+    if (!m_submissions.take(_id, share))
+        return;
+
+    m_conn->addRtt(unsigned(share.responseDelay().count()));
+
+    if (_isSuccess)
+    {
+        if (m_onSolutionAccepted)
+            m_onSolutionAccepted(share, _isStale);
+    }
+    else
+    {
+        if (m_onSolutionRejected)
+        {
+            cwarn << "Reject reason : " << (_errReason.empty() ? "Unspecified" : _errReason);
+            m_onSolutionRejected(share);
+        }
+    }
+}
+
 void EthStratumClient::processResponse(Json::Value& responseObject)
 {
     // Store jsonrpc version to test against
@@ -1166,11 +1465,8 @@ void EthStratumClient::processResponse(Json::Value& responseObject)
             // Nothing else to here. Wait for notifications from pool
         }
 
-        else if ((_id >= 40 && _id <= m_solution_submitted_max_id) &&
-                 m_conn->StratumMode() != ETHEREUMSTRATUM2)
+        else if (m_submissions.contains(_id) && m_conn->StratumMode() != ETHEREUMSTRATUM2)
         {
-            response_delay_ms = dequeue_response_plea();
-
             // Response to solution submission mining.submit
             // (https://en.bitcoin.it/wiki/Stratum_mining_protocol#mining.submit) Result should be
             // boolean, some pools also throw an error, so _isSuccess can be false Due to this
@@ -1179,28 +1475,11 @@ void EthStratumClient::processResponse(Json::Value& responseObject)
             if (_isSuccess && jResult.isBool())
                 _isSuccess = jResult.asBool();
 
-            const unsigned miner_index = _id - 40;
-            if (_isSuccess)
-            {
-                if (m_onSolutionAccepted)
-                    m_onSolutionAccepted(response_delay_ms, miner_index, false);
-            }
-            else
-            {
-                if (m_onSolutionRejected)
-                {
-                    cwarn << "Reject reason : "
-                          << (_errReason.empty() ? "Unspecified" : _errReason);
-                    m_onSolutionRejected(response_delay_ms, miner_index);
-                }
-            }
+            processSubmitResponse(_id, _isSuccess, _errReason, false);
         }
 
-        else if ((_id >= 40 && _id <= m_solution_submitted_max_id) &&
-                 m_conn->StratumMode() == ETHEREUMSTRATUM2)
+        else if (m_submissions.contains(_id) && m_conn->StratumMode() == ETHEREUMSTRATUM2)
         {
-            response_delay_ms = dequeue_response_plea();
-
             // In EthereumStratum/2.0.0 we can evaluate the severity of the
             // error. An 2xx error means the solution have been accepted but is
             // likely stale
@@ -1212,22 +1491,7 @@ void EthStratumClient::processResponse(Json::Value& responseObject)
                     _isSuccess = isStale = true;
             }
 
-
-            const unsigned miner_index = _id - 40;
-            if (_isSuccess)
-            {
-                if (m_onSolutionAccepted)
-                    m_onSolutionAccepted(response_delay_ms, miner_index, isStale);
-            }
-            else
-            {
-                if (m_onSolutionRejected)
-                {
-                    cwarn << "Reject reason : "
-                          << (_errReason.empty() ? "Unspecified" : _errReason);
-                    m_onSolutionRejected(response_delay_ms, miner_index);
-                }
-            }
+            processSubmitResponse(_id, _isSuccess, _errReason, isStale);
         }
 
         else if (_id == 5)
@@ -1243,6 +1507,18 @@ void EthStratumClient::processResponse(Json::Value& responseObject)
             }
         }
 
+        else if (_id == 7)
+        {
+            // Response to mining.noop. Whatever the outcome it went round trip
+            if (m_pingPending)
+            {
+                m_pingPending = false;
+                m_conn->addRtt(unsigned(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - m_pingSent)
+                                            .count()));
+            }
+        }
+
         else if (_id == 9)
         {
             // Response to hashrate submit
@@ -1377,6 +1653,7 @@ void EthStratumClient::processResponse(Json::Value& responseObject)
                         m_current.seed = h256(sSeedHash);
                         m_current.header = h256(sHeaderHash);
                         m_current.boundary = m_session->nextWorkBoundary;
+                        m_current.clean = false;
                         m_current.startNonce = m_session->extraNonce;
                         m_current.exSizeBytes = m_session->extraNonceSizeBytes;
                         m_current_timestamp = std::chrono::steady_clock::now();
@@ -1431,6 +1708,7 @@ void EthStratumClient::processResponse(Json::Value& responseObject)
                     m_current.header = h256(sHeaderHash);
                     m_current.boundary = h256(sShareTarget);
                     m_current.block_boundary = h256(sBlockTarget);
+                    m_current.clean = fCancelJob;
                     m_current_timestamp = std::chrono::steady_clock::now();
                     m_current.startNonce = m_session->extraNonce;
                     m_current.exSizeBytes = m_session->extraNonceSizeBytes;
@@ -1676,58 +1954,16 @@ void EthStratumClient::submitSolution(const Solution& solution)
         return;
     }
 
-    Json::Value jReq;
-
-    unsigned id = 40 + solution.midx;
-    jReq["id"] = id;
-    m_solution_submitted_max_id = max(m_solution_submitted_max_id, id);
-    jReq["method"] = "mining.submit";
-    jReq["params"] = Json::Value(Json::arrayValue);
-
-    switch (m_conn->StratumMode())
-    {
-    case EthStratumClient::STRATUM:
-        jReq["jsonrpc"] = "2.0";
-        jReq["params"].append(m_conn->UserDotWorker());
-        jReq["params"].append(solution.work.job);
-        jReq["params"].append(toHex(solution.nonce, HexPrefix::Add));
-        jReq["params"].append(solution.work.header.hex(HexPrefix::Add));
-        jReq["params"].append(solution.mixHash.hex(HexPrefix::Add));
-        if (!m_conn->Workername().empty())
-            jReq["worker"] = m_conn->Workername();
-
-        break;
-
-    case EthStratumClient::ETHPROXY:
-
-        jReq["method"] = "eth_submitWork";
-        jReq["params"].append(toHex(solution.nonce, HexPrefix::Add));
-        jReq["params"].append(solution.work.header.hex(HexPrefix::Add));
-        jReq["params"].append(solution.mixHash.hex(HexPrefix::Add));
-        if (!m_conn->Workername().empty())
-            jReq["worker"] = m_conn->Workername();
-
-        break;
-
-    case EthStratumClient::ETHEREUMSTRATUM:
-
-        jReq["params"].append(m_conn->UserDotWorker());
-        jReq["params"].append(solution.work.job);
-        jReq["params"].append(
-            toHex(solution.nonce, HexPrefix::DontAdd).substr(solution.work.exSizeBytes));
-        break;
-
-    case EthStratumClient::ETHEREUMSTRATUM2:
+    unsigned id = m_submissions.add(solution);
 
-        jReq["params"].append(solution.work.job);
-        jReq["params"].append(
-            toHex(solution.nonce, HexPrefix::DontAdd).substr(solution.work.exSizeBytes));
-        jReq["params"].append(m_session->workerId);
-        break;
-    }
+    const int mode = m_conn->StratumMode();
+    const unsigned nonceDigits = dev::stratum::SubmitTemplate::nonceDigits(mode, solution.work.exSizeBytes);
+    if (!m_submitTemplate.matches(mode, solution.work.job, solution.work.header, nonceDigits))
+        m_submitTemplate.build(mode, solution.work.job, solution.work.header, nonceDigits, m_conn->UserDotWorker(),
+            m_conn->Workername(), m_session ? m_session->workerId : std::string());
 
     enqueue_response_plea();
-    send(jReq);
+    send(m_submitTemplate.fill(id, solution.nonce, solution.mixHash));
 }
 
 void EthStratumClient::recvSocketData()
@@ -1774,58 +2010,32 @@ void EthStratumClient::onRecvSocketDataCompleted(
             thus invalidating the previous point 2
         */
 
-        // Extract received message and free the buffer
-        std::string rx_message(
-            boost::asio::buffer_cast<const char*>(m_recvBuffer.data()), bytes_transferred);
-        m_recvBuffer.consume(bytes_transferred);
-        m_message.append(rx_message);
+        // Lines are framed straight in the receive buffer. Only a line
+        // split across reads is copied aside till its remainder arrives
+        const char* data = boost::asio::buffer_cast<const char*>(m_recvBuffer.data());
+        const char* end = data + bytes_transferred;
 
         // Process each line in the transmission
         // NOTE : as multiple jobs may come in with
         // a single transmission only the last will be dispatched
         m_newjobprocessed = false;
-        std::string line;
-        size_t offset = m_message.find("\n");
-        while (offset != string::npos)
+        const char* eol;
+        while ((eol = static_cast<const char*>(memchr(data, '\n', end - data))) != nullptr)
         {
-            if (offset > 0)
+            if (m_message.empty())
             {
-                line = m_message.substr(0, offset);
-                boost::trim(line);
-
-                if (!line.empty())
-                {
-                    // Out received message only for debug purpouses
-                    if (g_logOptions & LOG_JSON)
-                        cnote << " << " << line;
-
-                    // Test validity of chunk and process
-                    Json::Value jMsg;
-                    Json::Reader jRdr;
-                    if (jRdr.parse(line, jMsg))
-                    {
-                        try
-                        {
-                            // Run in sync so no 2 different async reads may overlap
-                            processResponse(jMsg);
-                        }
-                        catch (const std::exception& _ex)
-                        {
-                            cwarn << "Stratum got invalid Json message : " << _ex.what();
-                        }
-                    }
-                    else
-                    {
-                        string what = jRdr.getFormattedErrorMessages();
-                        boost::replace_all(what, "\n", " ");
-                        cwarn << "Stratum got invalid Json message : " << what;
-                    }
-                }
+                processLine(data, eol - data);
             }
-
-            m_message.erase(0, offset + 1);
-            offset = m_message.find("\n");
+            else
+            {
+                m_message.append(data, eol - data);
+                processLine(m_message.data(), m_message.size());
+                m_message.clear();
+            }
+            data = eol + 1;
         }
+        m_message.append(data, end - data);
+        m_recvBuffer.consume(bytes_transferred);
 
         // There is a new job - dispatch it
         if (m_newjobprocessed)
@@ -1867,7 +2077,11 @@ void EthStratumClient::onRecvSocketDataCompleted(
 
 void EthStratumClient::send(Json::Value const& jReq)
 {
-    std::string* line = new std::string(Json::writeString(m_jSwBuilder, jReq));
+    send(new std::string(Json::writeString(m_jSwBuilder, jReq)));
+}
+
+void EthStratumClient::send(std::string* line)
+{
     m_txQueue.push(line);
 
     bool ex = false;
@@ -1885,11 +2099,13 @@ void EthStratumClient::sendSocketData()
         return;
     }
 
+    // Lines go straight into the send buffer which keeps its storage
+    // across transmissions
     std::string* line;
-    std::ostream os(&m_sendBuffer);
     while (m_txQueue.pop(line))
     {
-        os << *line << std::endl;
+        m_sendBuffer.sputn(line->data(), line->size());
+        m_sendBuffer.sputc('\n');
         // Out received message only for debug purpouses
         if (g_logOptions & LOG_JSON)
             cnote << " >> " << *line;
@@ -16,6 +16,8 @@
 #include <libethcore/Miner.h>
 
 #include "../PoolClient.h"
+#include "StratumParser.h"
+#include "SubmitTemplate.h"
 
 using namespace std;
 using namespace dev;
@@ -58,7 +60,7 @@ public:
         ETHEREUMSTRATUM2
     };
 
-    EthStratumClient(int worktimeout, int responsetimeout);
+    EthStratumClient(int worktimeout, int responsetimeout, unsigned pinginterval = 0);
 
     void init_socket();
     void connect() override;
@@ -91,10 +93,20 @@ private:
     void resolve_handler(
         const boost::system::error_code& ec, boost::asio::ip::tcp::resolver::iterator i);
     void start_connect();
+    void race_handler(const boost::system::error_code& ec,
+        std::shared_ptr<boost::asio::ip::tcp::socket> socket,
+        boost::asio::ip::tcp::endpoint endpoint, unsigned race);
+    void close_race();
     void connect_handler(const boost::system::error_code& ec);
     void workloop_timer_elapsed(const boost::system::error_code& ec);
 
+    void processLine(const char* _data, std::size_t _size);
+    bool processFastResponse(dev::stratum::StratumMessage const& _msg);
+    bool decodeNotify(dev::stratum::StratumMessage const& _msg, WorkPackage& _wp);
+    void processSubmitResponse(
+        unsigned _id, bool _isSuccess, std::string const& _errReason, bool _isStale);
     void processResponse(Json::Value& responseObject);
+    void sendPing();
     std::string processError(Json::Value& erroresponseObject);
     bool processExtranonce(std::string& enonce);
 
@@ -102,6 +114,7 @@ private:
     void onRecvSocketDataCompleted(
         const boost::system::error_code& ec, std::size_t bytes_transferred);
     void send(Json::Value const& jReq);
+    void send(std::string* line);
     void sendSocketData();
     void onSendSocketDataCompleted(const boost::system::error_code& ec);
     void onSSLShutdownCompleted(const boost::system::error_code& ec);
@@ -119,13 +132,18 @@ private:
     // default interval for workloop timer (milliseconds)
     int m_workloop_interval = 1000;
 
+    // seconds among mining.noop pings measuring rtt. 0 disables them
+    unsigned m_pinginterval;
+    std::chrono::steady_clock::time_point m_pingSent;
+    bool m_pingPending = false;
+
     WorkPackage m_current;
     std::chrono::time_point<std::chrono::steady_clock> m_current_timestamp;
 
     boost::asio::io_service& m_io_service;  // The IO service reference passed in the constructor
     boost::asio::io_service::strand m_io_strand;
     boost::asio::ip::tcp::socket* m_socket;
-    std::string m_message;  // The internal message string buffer
+    std::string m_message;  // Holds a line split across reads
     bool m_newjobprocessed = false;
 
     // Use shared ptrs to avoid crashes due to async_writes
@@ -150,7 +168,13 @@ private:
     boost::asio::ip::tcp::resolver m_resolver;
     std::queue<boost::asio::ip::basic_endpoint<boost::asio::ip::tcp>> m_endpoints;
 
-    unsigned m_solution_submitted_max_id;  // maximum json id we used to send a solution
+    // Endpoints raced concurrently (happy eyeballs). First one to connect wins
+    static constexpr unsigned kRaceWidth = 4;
+    std::vector<std::shared_ptr<boost::asio::ip::tcp::socket>> m_raceSockets;
+    unsigned m_raceId = 0;
+    unsigned m_racePending = 0;
+
+    dev::stratum::SubmitTemplate m_submitTemplate;
 
     ///@brief Auxiliary function to make verbose_verification objects.
     template <typename Verifier>
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <charconv>
+
+#include "StratumParser.h"
+
+namespace dev
+{
+namespace stratum
+{
+namespace
+{
+class Scanner
+{
+public:
+    Scanner(const char* _data, std::size_t _size) : m_pos(_data), m_end(_data + _size) {}
+
+    bool atEnd()
+    {
+        skipSpaces();
+        return m_pos == m_end;
+    }
+
+    bool consume(char _c)
+    {
+        skipSpaces();
+        if (m_pos == m_end || *m_pos != _c)
+            return false;
+        m_pos++;
+        return true;
+    }
+
+    // Reads a string with no escape sequences
+    bool string(std::string_view& _text)
+    {
+        if (!consume('"'))
+            return false;
+        const char* begin = m_pos;
+        while (m_pos != m_end && *m_pos != '"')
+        {
+            if (*m_pos == '\\')
+                return false;
+            m_pos++;
+        }
+        if (m_pos == m_end)
+            return false;
+        _text = std::string_view(begin, m_pos - begin);
+        m_pos++;
+        return true;
+    }
+
+    bool value(JsonToken& _token)
+    {
+        skipSpaces();
+        if (m_pos == m_end)
+            return false;
+
+        switch (*m_pos)
+        {
+        case '"':
+            _token.kind = JsonToken::Kind::String;
+            if (string(_token.text))
+                return true;
+            // Escaped strings are stepped over but not decoded
+            _token.kind = JsonToken::Kind::Other;
+            return skipString();
+        case '{':
+        case '[':
+            _token.kind = JsonToken::Kind::Other;
+            return skipCompound();
+        case 't':
+            _token.kind = JsonToken::Kind::Bool;
+            return keyword("true", _token.text);
+        case 'f':
+            _token.kind = JsonToken::Kind::Bool;
+            return keyword("false", _token.text);
+        case 'n':
+            _token.kind = JsonToken::Kind::Null;
+            return keyword("null", _token.text);
+        default:
+            _token.kind = JsonToken::Kind::Number;
+            return number(_token.text);
+        }
+    }
+
+private:
+    void skipSpaces()
+    {
+        while (m_pos != m_end &&
+               (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n'))
+            m_pos++;
+    }
+
+    // Whether a value ends here : anything else glued to it makes the line invalid
+    bool delimited() const
+    {
+        return m_pos == m_end || *m_pos == ',' || *m_pos == ']' || *m_pos == '}' || *m_pos == ' ' ||
+               *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n';
+    }
+
+    bool keyword(std::string_view _word, std::string_view& _text)
+    {
+        if (std::size_t(m_end - m_pos) < _word.size() || std::string_view(m_pos, _word.size()) != _word)
+            return false;
+        _text = std::string_view(m_pos, _word.size());
+        m_pos += _word.size();
+        return delimited();
+    }
+
+    // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool number(std::string_view& _text)
+    {
+        const char* begin = m_pos;
+        auto digits = [this]() {
+            const char* first = m_pos;
+            while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+                m_pos++;
+            return m_pos != first;
+        };
+
+        if (m_pos != m_end && *m_pos == '-')
+            m_pos++;
+        if (m_pos != m_end && *m_pos == '0')
+            m_pos++;
+        else if (!digits())
+            return false;
+        if (m_pos != m_end && *m_pos == '.')
+        {
+            m_pos++;
+            if (!digits())
+                return false;
+        }
+        if (m_pos != m_end && (*m_pos == 'e' || *m_pos == 'E'))
+        {
+            m_pos++;
+            if (m_pos != m_end && (*m_pos == '+' || *m_pos == '-'))
+                m_pos++;
+            if (!digits())
+                return false;
+        }
+        _text = std::string_view(begin, m_pos - begin);
+        return delimited();
+    }
+
+    bool skipString()
+    {
+        while (m_pos != m_end && *m_pos != '"')
+        {
+            // An escape takes two characters, the line may end before the second
+            if (*m_pos == '\\')
+            {
+                if (m_end - m_pos < 2)
+                    return false;
+                m_pos++;
+            }
+            m_pos++;
+        }
+        if (m_pos == m_end)
+            return false;
+        m_pos++;
+        return true;
+    }
+
+    bool skipCompound()
+    {
+        unsigned depth = 0;
+        while (m_pos != m_end)
+        {
+            char c = *m_pos++;
+            if (c == '"')
+            {
+                if (!skipString())
+                    return false;
+            }
+            else if (c == '{' || c == '[')
+            {
+                depth++;
+            }
+            else if (c == '}' || c == ']')
+            {
+                if (--depth == 0)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+};
+
+int hexDigit(char _c) noexcept
+{
+    if (_c >= '0' && _c <= '9')
+        return _c - '0';
+    if (_c >= 'a' && _c <= 'f')
+        return _c - 'a' + 10;
+    if (_c >= 'A' && _c <= 'F')
+        return _c - 'A' + 10;
+    return -1;
+}
+
+}  // namespace
+
+bool scanStratumMessage(const char* _data, std::size_t _size, StratumMessage& _msg) noexcept
+{
+    Scanner s(_data, _size);
+    _msg = StratumMessage();
+
+    if (!s.consume('{'))
+        return false;
+    if (s.consume('}'))
+        return s.atEnd();
+
+    do
+    {
+        std::string_view key;
+        if (!s.string(key) || !s.consume(':'))
+            return false;
+
+        if (key == "params")
+        {
+            if (s.consume('['))
+            {
+                _msg.paramsValue.kind = JsonToken::Kind::Other;
+                if (!s.consume(']'))
+                {
+                    do
+                    {
+                        if (_msg.paramsCount == StratumMessage::kMaxParams ||
+                            !s.value(_msg.params[_msg.paramsCount++]))
+                            return false;
+                    } while (s.consume(','));
+                    if (!s.consume(']'))
+                        return false;
+                }
+                continue;
+            }
+            if (!s.value(_msg.paramsValue))
+                return false;
+            continue;
+        }
+
+        JsonToken token;
+        if (!s.value(token))
+            return false;
+
+        if (key == "id")
+        {
+            uint64_t id = 0;
+            if (token.kind == JsonToken::Kind::Number)
+            {
+                if (!parseUnsigned(token.text, id) || id > UINT32_MAX)
+                    return false;
+            }
+            else if (token.kind != JsonToken::Kind::Null)
+            {
+                return false;
+            }
+            _msg.id = static_cast<unsigned>(id);
+        }
+        else if (key == "method")
+        {
+            if (token.kind == JsonToken::Kind::String)
+                _msg.method = token.text;
+            else if (token.kind != JsonToken::Kind::Null)
+                return false;
+        }
+        else if (key == "jsonrpc")
+            _msg.jsonrpc = token;
+        else if (key == "result")
+            _msg.result = token;
+        else if (key == "error")
+            _msg.error = token;
+
+    } while (s.consume(','));
+
+    return s.consume('}') && s.atEnd();
+}
+
+bool hexToHash(std::string_view _hex, h256& _hash, bool _padLeft) noexcept
+{
+    if (_hex.size() >= 2 && _hex[0] == '0' && (_hex[1] == 'x' || _hex[1] == 'X'))
+        _hex.remove_prefix(2);
+
+    constexpr std::size_t digits = h256::size * 2;
+    if (_hex.size() > digits || (!_padLeft && _hex.size() != digits))
+        return false;
+
+    // Right align the digits : a leading odd digit fills a byte by itself
+    uint8_t* out = _hash.data();
+    std::size_t pad = digits - _hex.size();
+    std::fill(out, out + pad / 2, uint8_t(0));
+    out += pad / 2;
+
+    std::size_t i = 0;
+    if (pad & 1)
+    {
+        int lo = hexDigit(_hex[i++]);
+        if (lo < 0)
+            return false;
+        *out++ = uint8_t(lo);
+    }
+    for (; i < _hex.size(); i += 2)
+    {
+        int hi = hexDigit(_hex[i]);
+        int lo = hexDigit(_hex[i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        *out++ = uint8_t((hi << 4) | lo);
+    }
+    return true;
+}
+
+bool parseUnsigned(std::string_view _text, uint64_t& _value, int _base) noexcept
+{
+    if (_base == 0)
+    {
+        _base = 10;
+        if (_text.size() > 2 && _text[0] == '0' && (_text[1] == 'x' || _text[1] == 'X'))
+        {
+            _text.remove_prefix(2);
+            _base = 16;
+        }
+    }
+    auto r = std::from_chars(_text.data(), _text.data() + _text.size(), _value, _base);
+    return r.ec == std::errc() && r.ptr == _text.data() + _text.size();
+}
+
+}  // namespace stratum
+}  // namespace dev
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <libdevcore/FixedHash.h>
+
+namespace dev
+{
+namespace stratum
+{
+/// A value spotted by the scanner. Only scalars carry their text: arrays and
+/// objects are skipped and reported as Other
+struct JsonToken
+{
+    enum class Kind
+    {
+        None,  // Member not present
+        Null,
+        Bool,
+        Number,
+        String,
+        Other
+    };
+
+    Kind kind = Kind::None;
+    std::string_view text;  // Content of strings without quotes, literal otherwise
+
+    bool isString() const { return kind == Kind::String; }
+    bool isTrue() const { return kind == Kind::Bool && text == "true"; }
+};
+
+/// The members of a JSON-RPC message the hot paths look at. All views
+/// point into the scanned line which must outlive the message
+struct StratumMessage
+{
+    static constexpr unsigned kMaxParams = 8;
+
+    unsigned id = 0;
+    std::string_view method;
+    JsonToken jsonrpc;
+    JsonToken result;
+    JsonToken error;
+    JsonToken paramsValue;  // Other if an array, in which case see params
+    JsonToken params[kMaxParams];
+    unsigned paramsCount = 0;
+};
+
+/// Scans a single line holding a JSON-RPC message without allocating.
+/// Returns false when the line is not something the scanner handles
+/// (top level is not an object, escaped keys, non numeric id, too many
+/// params ...): callers are expected to fall back to a full json parser
+bool scanStratumMessage(const char* _data, std::size_t _size, StratumMessage& _msg) noexcept;
+
+/// Decodes a hex string, with or without 0x prefix, straight into a hash.
+/// With _padLeft shorter strings are right aligned, otherwise the string
+/// must hold exactly 64 digits
+bool hexToHash(std::string_view _hex, h256& _hash, bool _padLeft = false) noexcept;
+
+/// Parses an unsigned integer. Base 0 detects a 0x prefix as strtoul does
+bool parseUnsigned(std::string_view _text, uint64_t& _value, int _base = 10) noexcept;
+
+}  // namespace stratum
+}  // namespace dev
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include <json/json.h>
+
+#include "EthStratumClient.h"
+#include "SubmitTemplate.h"
+
+namespace dev
+{
+namespace stratum
+{
+namespace
+{
+// Every byte value maps to its two lower case digits
+struct HexTable
+{
+    char digits[256][2];
+
+    HexTable()
+    {
+        const char* hex = "0123456789abcdef";
+        for (unsigned i = 0; i < 256; i++)
+        {
+            digits[i][0] = hex[i >> 4];
+            digits[i][1] = hex[i & 0xf];
+        }
+    }
+};
+
+const HexTable c_hexTable;
+
+}  // namespace
+
+void toHexInPlace(const uint8_t* _data, std::size_t _size, char* _out) noexcept
+{
+    for (std::size_t i = 0; i < _size; i++)
+        memcpy(_out + i * 2, c_hexTable.digits[_data[i]], 2);
+}
+
+void SubmitTemplate::build(int _mode, std::string const& _job, h256 const& _header, unsigned _nonceDigits,
+    std::string const& _userDotWorker, std::string const& _worker, std::string const& _workerId)
+{
+    m_mode = _mode;
+    m_job = _job;
+    m_header = _header;
+    m_body.clear();
+    m_nonceDigits = _nonceDigits;
+    m_mixOffset = std::string::npos;
+
+    // Members go in the same order jsoncpp writes them (alphabetical)
+    switch (_mode)
+    {
+    case EthStratumClient::STRATUM:
+        raw(",\"jsonrpc\":\"2.0\",\"method\":\"mining.submit\",\"params\":[");
+        string(_userDotWorker);
+        raw(",");
+        string(_job);
+        raw(",");
+        nonce(true);
+        raw(",");
+        hash(_header);
+        raw(",");
+        mixHash();
+        raw("]");
+        if (!_worker.empty())
+        {
+            raw(",\"worker\":");
+            string(_worker);
+        }
+        raw("}");
+        break;
+
+    case EthStratumClient::ETHPROXY:
+        raw(",\"method\":\"eth_submitWork\",\"params\":[");
+        nonce(true);
+        raw(",");
+        hash(_header);
+        raw(",");
+        mixHash();
+        raw("]");
+        if (!_worker.empty())
+        {
+            raw(",\"worker\":");
+            string(_worker);
+        }
+        raw("}");
+        break;
+
+    case EthStratumClient::ETHEREUMSTRATUM:
+        raw(",\"method\":\"mining.submit\",\"params\":[");
+        string(_userDotWorker);
+        raw(",");
+        string(_job);
+        raw(",");
+        nonce(false);
+        raw("]}");
+        break;
+
+    case EthStratumClient::ETHEREUMSTRATUM2:
+        raw(",\"method\":\"mining.submit\",\"params\":[");
+        string(_job);
+        raw(",");
+        nonce(false);
+        raw(",");
+        string(_workerId);
+        raw("]}");
+        break;
+    }
+}
+
+unsigned SubmitTemplate::nonceDigits(int _mode, unsigned _exSizeBytes)
+{
+    // Pools owning part of the nonce only get the remaining digits
+    if (_mode == EthStratumClient::ETHEREUMSTRATUM || _mode == EthStratumClient::ETHEREUMSTRATUM2)
+        return 16 - std::min(_exSizeBytes, 16U);
+    return 16;
+}
+
+void SubmitTemplate::string(std::string const& _text)
+{
+    m_body.append(Json::valueToQuotedString(_text.c_str()));
+}
+
+void SubmitTemplate::hash(h256 const& _hash)
+{
+    m_body.append("\"0x");
+    std::size_t offset = m_body.size();
+    m_body.append(h256::size * 2, '0');
+    toHexInPlace(_hash.data(), h256::size, &m_body[offset]);
+    m_body.push_back('"');
+}
+
+void SubmitTemplate::nonce(bool _prefix)
+{
+    m_body.append(_prefix ? "\"0x" : "\"");
+    m_nonceOffset = m_body.size();
+    m_body.append(m_nonceDigits, '0');
+    m_body.push_back('"');
+}
+
+void SubmitTemplate::mixHash()
+{
+    m_body.append("\"0x");
+    m_mixOffset = m_body.size();
+    m_body.append(h256::size * 2, '0');
+    m_body.push_back('"');
+}
+
+std::string* SubmitTemplate::fill(unsigned _id, uint64_t _nonce, h256 const& _mixHash) const
+{
+    static const char c_head[] = "{\"id\":";
+    char id[16];
+    auto idEnd = std::to_chars(id, id + sizeof(id), _id).ptr;
+
+    std::string* line = new std::string();
+    line->reserve(sizeof(c_head) + (idEnd - id) + m_body.size());
+    line->append(c_head, sizeof(c_head) - 1);
+    line->append(id, idEnd);
+    std::size_t base = line->size();
+    line->append(m_body);
+
+    // Nonce goes big endian. Only its low digits are sent when the pool
+    // owns the leading ones (extranonce)
+    uint8_t nonce[8];
+    for (unsigned i = 0; i < 8; i++)
+        nonce[i] = uint8_t(_nonce >> (56 - i * 8));
+    char digits[16];
+    toHexInPlace(nonce, sizeof(nonce), digits);
+    memcpy(&(*line)[base + m_nonceOffset], digits + 16 - m_nonceDigits, m_nonceDigits);
+
+    if (m_mixOffset != std::string::npos)
+        toHexInPlace(_mixHash.data(), h256::size, &(*line)[base + m_mixOffset]);
+
+    return line;
+}
+
+}  // namespace stratum
+}  // namespace dev
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <libdevcore/FixedHash.h>
+
+namespace dev
+{
+namespace stratum
+{
+/// A serialised share submission for a given job. The request is laid out
+/// once, leaving room for the nonce and mix hash digits, then every
+/// solution only copies it and patches the digits in place.
+/// Output is byte for byte what jsoncpp's compact writer would produce
+/// (checked by test/submittemplate_test)
+class SubmitTemplate
+{
+public:
+    /// Lays out the request of stratum mode _mode (EthStratumClient::StratumProtocol).
+    /// _id is not part of it as it changes with every submission. _nonceDigits are
+    /// the nonce digits sent to the pool (see nonceDigits()). _worker is sent along
+    /// when not empty and _workerId only by EthereumStratum/2.0.0
+    void build(int _mode, std::string const& _job, h256 const& _header, unsigned _nonceDigits,
+        std::string const& _userDotWorker, std::string const& _worker, std::string const& _workerId);
+    void clear() { m_body.clear(); }
+
+    /// Nonce digits sent to a pool of stratum mode _mode owning the leading
+    /// ones (extranonce)
+    static unsigned nonceDigits(int _mode, unsigned _exSizeBytes);
+
+    bool matches(
+        int _mode, std::string const& _job, h256 const& _header, unsigned _nonceDigits) const
+    {
+        return !m_body.empty() && m_mode == _mode && m_nonceDigits == _nonceDigits &&
+               m_header == _header && m_job == _job;
+    }
+
+    /// Allocates the request for a solution. Caller takes ownership
+    std::string* fill(unsigned _id, uint64_t _nonce, h256 const& _mixHash) const;
+
+private:
+    // Builders. Strings are quoted and escaped
+    void raw(const char* _text) { m_body.append(_text); }
+    void string(std::string const& _text);
+    void hash(h256 const& _hash);
+    void nonce(bool _prefix);
+    void mixHash();
+
+    int m_mode = -1;
+    std::string m_job;
+    h256 m_header;
+
+    std::string m_body;  // Everything after "id":
+    std::size_t m_nonceOffset = 0;
+    unsigned m_nonceDigits = 0;
+    std::size_t m_mixOffset = std::string::npos;
+};
+
+/// Table driven hex encoding with no branch on digit values
+void toHexInPlace(const uint8_t* _data, std::size_t _size, char* _out) noexcept;
+
+}  // namespace stratum
+}  // namespace dev
@@ -54,25 +54,23 @@ void SimulateClient::submitSolution(const Solution& solution)
 {
     // This is a fake submission only evaluated locally
     solution_arrived.store(true);
-    std::chrono::steady_clock::time_point submit_start = std::chrono::steady_clock::now();
+    SubmittedShare share{solution.work.job, solution.midx, solution.tstamp, std::chrono::steady_clock::now()};
     ethash::VerificationResult result;
     result = progpow::verify_full(solution.work.block.value(), ethash::from_bytes(solution.work.header.data()),
         ethash::from_bytes(solution.mixHash.data()), solution.nonce,
         ethash::from_bytes(solution.work.get_boundary().data()));
 
     bool accepted = (result == ethash::VerificationResult::kOk);
-    std::chrono::milliseconds response_delay_ms =
-        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - submit_start);
 
     if (accepted)
     {
         if (m_onSolutionAccepted)
-            m_onSolutionAccepted(response_delay_ms, solution.midx, false);
+            m_onSolutionAccepted(share, false);
     }
     else
     {
         if (m_onSolutionRejected)
-            m_onSolutionRejected(response_delay_ms, solution.midx);
+            m_onSolutionRejected(share);
     }
 }
 
@@ -24,6 +24,8 @@
 #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
 #endif
 
+#include <libdevcore/Executor.h>
+#include <libethcore/Autotuner.h>
 #include <libethcore/Farm.h>
 #if ETH_ETHASHCL
 #include <libethash-cl/CLMiner.h>
@@ -57,7 +59,9 @@ bool g_running = false;
 bool g_exitOnError = false;  // Whether or not meowpowminer should exit on mining threads errors
 
 condition_variable g_shouldstop;
-boost::asio::io_service g_io_service;  // The IO service itself
+boost::asio::io_service g_io_service;         // Pool traffic and job dispatch
+boost::asio::io_service g_verify_io_service;  // Solutions verification
+boost::asio::io_service g_api_io_service;     // Api, hardware monitoring and telemetry
 
 struct MiningChannel : public LogChannel
 {
@@ -81,26 +85,37 @@ public:
         Mining
     };
 
-    MinerCLI() : m_cliDisplayTimer(g_io_service), m_io_strand(g_io_service)
+    MinerCLI()
+      : m_netExecutor("net", g_io_service, 1, Executor::Priority::High),
+        m_verifyExecutor("verify", g_verify_io_service,
+            std::max(1U, std::min(4U, std::thread::hardware_concurrency() / 2))),
+        m_apiExecutor("api", g_api_io_service),
+        m_cliDisplayTimer(g_io_service),
+        m_io_strand(g_io_service)
     {
         // Initialize display timer as sleeper
         m_cliDisplayTimer.expires_from_now(boost::posix_time::pos_infin);
         m_cliDisplayTimer.async_wait(m_io_strand.wrap(boost::bind(
             &MinerCLI::cliDisplayInterval_elapsed, this, boost::asio::placeholders::error)));
 
-        // Start io_service in it's own thread
-        m_io_thread = std::thread{boost::bind(&boost::asio::io_service::run, &g_io_service)};
+        // Start io_services in their own threads. Pool traffic gets one of
+        // its own so neither solutions verification nor api and hardware
+        // polling delay jobs
+        m_netExecutor.start();
+        m_verifyExecutor.start();
+        m_apiExecutor.start();
 
-        // Io service is now live and running
-        // All components using io_service should post to reference of g_io_service
+        // Io services are now live and running
+        // All components using io_service should post to reference of the global ones
         // and should not start/stop or even join threads (which heavily time consuming)
     }
 
     virtual ~MinerCLI()
     {
         m_cliDisplayTimer.cancel();
-        g_io_service.stop();
-        m_io_thread.join();
+        m_apiExecutor.stop();
+        m_verifyExecutor.stop();
+        m_netExecutor.stop();
     }
 
     void cliDisplayInterval_elapsed(const boost::system::error_code& ec)
@@ -278,6 +293,11 @@ public:
         app.add_option("--failover-timeout", m_PoolSettings.poolFailoverTimeout, "", true)
             ->check(CLI::Range(0, 999));
 
+        app.add_option("--standby-pools", m_PoolSettings.standbyConnections, "", true)
+            ->check(CLI::Range(0, 9));
+
+        app.add_flag("--prefer-low-latency", m_PoolSettings.preferLowLatency, "");
+
         app.add_flag("--nocolor", g_logNoColor, "");
 
         app.add_flag("--syslog", g_logSyslog, "");
@@ -317,9 +337,17 @@ public:
 
         app.add_option("--opencl-device,--opencl-devices,--cl-devices", m_CLSettings.devices, "");
 
-        app.add_option("--cl-global-work", m_CLSettings.globalWorkSize, "", true);
+        auto cl_global_opt = app.add_option("--cl-global-work", m_CLSettings.globalWorkSize, "", true);
+
+        auto cl_local_opt = app.add_set("--cl-local-work", m_CLSettings.localWorkSize, {64, 128, 256}, "", true);
+
+        app.add_option("--cl-pipeline", m_CLSettings.pipelineDepth, "", true)->check(CLI::Range(1, 4));
+
+        app.add_flag("--cl-out-of-order", m_CLSettings.outOfOrder, "");
 
-        app.add_set("--cl-local-work", m_CLSettings.localWorkSize, {64, 128, 256}, "", true);
+        app.add_option("--cl-cache-dir", m_CLSettings.binaryCacheDir, "");
+
+        app.add_option("--cl-cache-size", m_CLSettings.binaryCacheMb, "", true)->check(CLI::Range(1, 65536));
 
 #endif
 
@@ -349,12 +377,31 @@ public:
 
         app.add_option("--cpu-devices,--cp-devices", m_CPSettings.devices, "");
 
+        app.add_option("--cpu-dag-threads,--cp-dag-threads", m_CPSettings.dagThreads, "", true);
+
+        auto cp_batch_opt =
+            app.add_option("--cpu-batch,--cp-batch", m_CPSettings.batchSize, "", true)->check(CLI::Range(1, 65536));
+
 #endif
 
         app.add_flag("--noeval", m_FarmSettings.noEval, "");
 
         app.add_option("-L,--dag-load-mode", m_FarmSettings.dagLoadMode, "", true)->check(CLI::Range(1));
 
+        app.add_option("--dag-cache-dir", m_FarmSettings.dagCacheDir, "");
+
+        app.add_flag("--dag-cache-full", m_FarmSettings.dagCacheFull, "");
+
+        app.add_option("--dag-cache-epochs", m_FarmSettings.dagCacheEpochs, "", true)->check(CLI::Range(1, 99));
+
+        app.add_flag("--no-huge-pages", m_FarmSettings.noHugePages, "");
+
+        app.add_option("--verify-cache", m_FarmSettings.verifyCacheMb, "", true)->check(CLI::Range(0, 4096));
+
+        app.add_option("--dag-contexts", m_FarmSettings.dagContexts, "", true)->check(CLI::Range(1, 16));
+
+        app.add_option("--dag-contexts-full", m_FarmSettings.dagContextsFull, "", true)->check(CLI::Range(1, 4));
+
         bool cl_miner = false;
         app.add_flag("-G,--opencl", cl_miner, "");
 
@@ -370,6 +417,15 @@ public:
         app.add_option("--diff", m_PoolSettings.benchmarkDiff, "")
             ->check(CLI::Range(0.00000001, 10000.0));
 
+        app.add_flag("--autotune", m_AutotunerSettings.enabled, "");
+
+        app.add_option("--autotune-time", m_AutotunerSettings.seconds, "", true)->check(CLI::Range(2, 600));
+
+        app.add_option("--autotune-latency", m_AutotunerSettings.maxLatencyMs, "", true)
+            ->check(CLI::Range(1, 10000));
+
+        app.add_option("--tuning-profile", m_AutotunerSettings.profile, "");
+
         app.add_option("--tstop", m_FarmSettings.tempStop, "", true)->check(CLI::Range(30, 100));
         app.add_option("--tstart", m_FarmSettings.tempStart, "", true)->check(CLI::Range(30, 100));
 
@@ -394,6 +450,14 @@ public:
         }
 
 
+        // Work sizes given on command line are not overridden by the tuning profile
+#if ETH_ETHASHCL
+        m_clWorkSizeSet = cl_global_opt->count() || cl_local_opt->count();
+#endif
+#if ETH_ETHASHCPU
+        m_cpBatchSet = cp_batch_opt->count();
+#endif
+
         if (cl_miner)
             m_minerType = MinerType::CL;
         else if (cuda_miner)
@@ -408,7 +472,8 @@ public:
             Operation mode Stratum or GetWork do need at least one
         */
 
-        if (sim_opt->count())
+        // Autotuning runs on simulated jobs
+        if (sim_opt->count() || m_AutotunerSettings.enabled)
         {
             m_mode = OperationMode::Simulation;
             pools.clear();
@@ -681,6 +746,26 @@ public:
 #endif
 
 
+        // Work sizes found by a previous autotuning
+        if (!m_AutotunerSettings.enabled)
+        {
+            auto profile = Autotuner::loadProfile(m_AutotunerSettings.profile);
+            for (auto it = m_DevicesCollection.begin(); it != m_DevicesCollection.end(); it++)
+            {
+                auto point = profile.find(it->first);
+                if (point == profile.end())
+                    continue;
+                it->second.tuning = point->second;
+                if (m_clWorkSizeSet)
+                {
+                    it->second.tuning.globalWorkMultiplier = 0;
+                    it->second.tuning.localWorkSize = 0;
+                }
+                if (m_cpBatchSet)
+                    it->second.tuning.batchSize = 0;
+            }
+        }
+
         // Subscribe all detected devices
 #if ETH_ETHASHCUDA
         if (!m_CUSettings.devices.size() &&
@@ -714,6 +799,9 @@ public:
         {
             for (auto it = m_DevicesCollection.begin(); it != m_DevicesCollection.end(); it++)
             {
+                // Threads the autotuner found of no use
+                if (!it->second.tuning.enabled)
+                    continue;
                 it->second.subscriptionType = DeviceSubscriptionTypeEnum::Cpu;
             }
         }
@@ -840,6 +928,21 @@ public:
                  << "    -Z,--simulation     UINT [0 ..] Default not set" << endl
                  << "                        Mining test. Used to test hashing speed." << endl
                  << "                        Specify the block number to test on." << endl
+                 << endl
+                 << "    --autotune          FLAG Sweep the work sizes of devices on a simulation" << endl
+                 << "                        (OpenCL global/local work, CPU batch and threads)" << endl
+                 << "                        measuring hashrate and job switch latency, store" << endl
+                 << "                        the best ones in the tuning profile, then exit." << endl
+                 << "                        The profile is loaded on next runs. Work sizes" << endl
+                 << "                        given on command line take precedence over it" << endl
+                 << "    --autotune-time     UINT [2 .. 600] Default = " << m_AutotunerSettings.seconds << endl
+                 << "                        Seconds each work size is measured for" << endl
+                 << "    --autotune-latency  UINT [1 .. 10000] Default = " << m_AutotunerSettings.maxLatencyMs
+                 << endl
+                 << "                        Slowest acceptable job switch in ms. Work sizes" << endl
+                 << "                        switching slower are not picked" << endl
+                 << "    --tuning-profile    TEXT Default tuning.json in the directory of" << endl
+                 << "                        meowpowminer binary. Tuning profile file" << endl
                  << endl;
         }
 
@@ -892,7 +995,20 @@ public:
                  << "                        Set the global work size multiplier" << endl
                  << "                        Value will be adjusted to nearest power of 2" << endl
                  << "    --cl-local-work     UINT {64,128,256} Default = " << m_CLSettings.localWorkSize << endl
-                 << "                        Set the local work size multiplier" << endl;
+                 << "                        Set the local work size multiplier" << endl
+                 << "    --cl-pipeline       UINT {1..4} Default = " << m_CLSettings.pipelineDepth << endl
+                 << "                        Search batches queued ahead on the device" << endl
+                 << "                        Next batch is queued before the results of the" << endl
+                 << "                        previous one are read. 1 waits on each batch" << endl
+                 << "                        Deeper pipelines are experimental" << endl
+                 << "    --cl-out-of-order   FLAG Use an out of order command queue if the" << endl
+                 << "                        device supports it" << endl
+                 << "    --cl-cache-dir      TEXT Default not set" << endl
+                 << "                        Directory where built kernel binaries are stored" << endl
+                 << "                        and loaded back on next periods or runs instead of" << endl
+                 << "                        being rebuilt. If not set nothing is stored on disk" << endl
+                 << "    --cl-cache-size     UINT[1 .. 65536] Default = " << m_CLSettings.binaryCacheMb << endl
+                 << "                        Disk space (MB) the kernel binaries may take" << endl;
         }
 
         if (ctx == "cu")
@@ -955,6 +1071,11 @@ public:
                  << "                        Space separated list of device indexes to use" << endl
                  << "                        eg --cp-devices 0 2 3" << endl
                  << "                        If not set all available CPUs will be used" << endl
+                 << "    --cp-dag-threads    UINT {0} Default = 0" << endl
+                 << "                        Number of threads generating the DAG" << endl
+                 << "                        0 uses all available CPUs" << endl
+                 << "    --cp-batch          UINT [1 .. 65536] Default = " << m_CPSettings.batchSize << endl
+                 << "                        Nonces searched between two checks for new work" << endl
                  << endl;
         }
 
@@ -981,6 +1102,18 @@ public:
                  << "                        reconnect to the primary (the first) connection."
                  << endl
                  << "                        before switching to a fail-over connection" << endl
+                 << "    --standby-pools     INT[0 .. 9] Default = 0" << endl
+                 << "                        Number of fail-over connections (following the" << endl
+                 << "                        active one) kept connected and logged in while" << endl
+                 << "                        mining. On failure of the active connection" << endl
+                 << "                        mining switches to a standby's job at once." << endl
+                 << "                        Stratum connections only." << endl
+                 << "    --prefer-low-latency FLAG Among connections of a same group" << endl
+                 << "                        (?group=name appended to their URI) mine the" << endl
+                 << "                        one with the lowest measured round trip time." << endl
+                 << "                        Stratum connections are pinged every 30 seconds" << endl
+                 << "                        and standbys (see --standby-pools) of the group" << endl
+                 << "                        get measured as well." << endl
                  << "    --work-timeout      INT[180 .. 99999] Default = 180" << endl
                  << "                        If no new work received from pool after this" << endl
                  << "                        amount of time the connection is dropped" << endl
@@ -1026,6 +1159,28 @@ public:
                  << "                        Set DAG load mode. Can be one of:" << endl
                  << "                        0 Parallel load mode (each GPU independently)" << endl
                  << "                        1 Sequential load mode (one GPU after another)" << endl
+                 << "    --dag-cache-dir     TEXT Default not set" << endl
+                 << "                        Directory where light caches of epochs are stored" << endl
+                 << "                        and mapped back from on restart instead of being" << endl
+                 << "                        rebuilt. If not set nothing is stored on disk" << endl
+                 << "    --dag-cache-full    FLAG Store full DAGs (CPU mining) too. Needs some GB" << endl
+                 << "                        of disk space per epoch" << endl
+                 << "    --dag-cache-epochs  UINT[1 .. 99] Default = 2" << endl
+                 << "                        Number of epochs kept in the DAG cache directory" << endl
+                 << "    --no-huge-pages     FLAG Do not use huge pages for DAGs kept in host" << endl
+                 << "                        memory (light caches and CPU mining DAGs)" << endl
+                 << "    --verify-cache      UINT[0 .. 4096] Default = 0" << endl
+                 << "                        MiB of DAG items kept once computed to verify" << endl
+                 << "                        solutions without a full DAG. Only solutions" << endl
+                 << "                        verified more than once gain from it. 0 disables" << endl
+                 << "    --dag-contexts      UINT[1 .. 16] Default = 3" << endl
+                 << "                        Number of epochs which light caches are kept in" << endl
+                 << "                        memory. Switching back to one of them (e.g. when" << endl
+                 << "                        failing over to a pool on another epoch) needs no" << endl
+                 << "                        rebuild" << endl
+                 << "    --dag-contexts-full UINT[1 .. 4] Default = 1" << endl
+                 << "                        Same as --dag-contexts for full DAGs (CPU mining)." << endl
+                 << "                        Each one needs some GB of host memory" << endl
                  << endl
                  << "    --tstart            UINT[30 .. 100] Default = 0" << endl
                  << "                        Suspend mining on GPU which temperature is above"
@@ -1216,6 +1371,17 @@ private:
         // Start PoolManager
         PoolManager::p().start();
 
+        // Autotuning stops the miner when done
+        Autotuner tuner(m_AutotunerSettings);
+        if (m_AutotunerSettings.enabled)
+        {
+            tuner.onFinished([]() {
+                g_running = false;
+                g_shouldstop.notify_all();
+            });
+            tuner.startWorking();
+        }
+
         // Initialize display timer as sleeper with proper interval
         m_cliDisplayTimer.expires_from_now(boost::posix_time::seconds(m_cliDisplayInterval));
         m_cliDisplayTimer.async_wait(m_io_strand.wrap(boost::bind(
@@ -1226,6 +1392,8 @@ private:
         while (g_running)
             g_shouldstop.wait(clilock);
 
+        tuner.stopWorking();
+
 #if API_CORE
 
         // Stop Api server
@@ -1241,7 +1409,9 @@ private:
     }
 
     // Global boost's io_service
-    std::thread m_io_thread;                        // The IO service thread
+    Executor m_netExecutor;                         // Runs g_io_service
+    Executor m_verifyExecutor;                      // Runs g_verify_io_service
+    Executor m_apiExecutor;                         // Runs g_api_io_service
     boost::asio::deadline_timer m_cliDisplayTimer;  // The timer which ticks display lines
     boost::asio::io_service::strand m_io_strand;    // A strand to serialize posts in
                                                     // multithreaded environment
@@ -1259,6 +1429,9 @@ private:
     CLSettings m_CLSettings;          // Operating settings for CL Miners
     CUSettings m_CUSettings;          // Operating settings for CUDA Miners
     CPSettings m_CPSettings;          // Operating settings for CPU Miners
+    AutotunerSettings m_AutotunerSettings;  // Operating settings for the autotuner
+    bool m_clWorkSizeSet = false;           // Whether OpenCL work sizes were given on command line
+    bool m_cpBatchSet = false;              // Whether CPU batch size was given on command line
 
     //// -- Pool manager related params
     //std::vector<std::shared_ptr<URI>> m_poolConns;
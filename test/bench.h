@@ -0,0 +1,27 @@
+// Timing helpers of the benchmarks
+
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+
+namespace bench
+{
+// Operations per second of _count calls of _op(i)
+template <class Op>
+double rate(size_t _count, Op&& _op)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < _count; i++)
+        _op(i);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() > 0 ? double(_count) / elapsed.count() : 0.0;
+}
+
+// Positional argument _index of the command line, _default when missing
+inline size_t arg(int _argc, char** _argv, int _index, size_t _default)
+{
+    return _index < _argc ? std::strtoull(_argv[_index], nullptr, 0) : _default;
+}
+
+}  // namespace bench
@@ -0,0 +1,74 @@
+// Dataset items generated per second and per core, one item at a time and
+// several at a time (SIMD lanes when the CPU has them), as the full dataset
+// build does.
+//
+// Usage: bench_dataset [items per thread] [threads]
+
+#include <libcrypto/ethash.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+namespace
+{
+// Items per call of the batched path, as a dataset build thread takes them
+constexpr uint32_t c_chunk = 256;
+
+// Items per second of each of _threads threads running at once
+double perThread(unsigned _threads, uint32_t _items, bool _batched, const ethash::epoch_context& _ctx)
+{
+    std::vector<double> rates(_threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < _threads; t++)
+        workers.emplace_back([&, t]() {
+            std::vector<ethash::hash1024> items(c_chunk);
+            const uint32_t first = t * _items;
+            if (_batched)
+                rates[t] = bench::rate(_items / c_chunk, [&](size_t i) {
+                    ethash::detail::calculate_dataset_items_1024(
+                        _ctx, first + uint32_t(i) * c_chunk, c_chunk, items.data());
+                }) * c_chunk;
+            else
+                rates[t] = bench::rate(_items, [&](size_t i) {
+                    items[i % c_chunk] = ethash::detail::calculate_dataset_item_1024(_ctx, first + uint32_t(i));
+                });
+        });
+    for (auto& worker : workers)
+        worker.join();
+
+    double sum = 0;
+    for (double rate : rates)
+        sum += rate;
+    return sum / _threads;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t items = std::max<uint32_t>(uint32_t(bench::arg(argc, argv, 1, 16384)) / c_chunk, 1) * c_chunk;
+    const unsigned threads =
+        std::max<unsigned>(unsigned(bench::arg(argc, argv, 2, std::thread::hardware_concurrency())), 1);
+
+    const auto ctx = ethash::get_epoch_context(0, false);
+    if (!ctx)
+        return 1;
+
+    std::printf("%u items per thread\n", items);
+    std::printf("%-8s %-10s %16s %16s\n", "threads", "path", "items/s/core", "items/s");
+    for (const unsigned n : {1U, threads})
+    {
+        for (const bool batched : {false, true})
+        {
+            const double rate = perThread(n, items, batched, *ctx);
+            std::printf("%-8u %-10s %16.0f %16.0f\n", n, batched ? "batched" : "single", rate, rate * n);
+        }
+        if (threads == 1)
+            break;
+    }
+    return 0;
+}
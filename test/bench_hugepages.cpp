@@ -0,0 +1,66 @@
+// progpow::hash throughput on a full epoch context with its dataset in
+// normal pages, then in huge pages (as allocated unless --no-huge-pages).
+// The dataset is built once per kind of pages.
+//
+// Usage: bench_hugepages [hashes] [epoch] [threads]
+
+#include <libcrypto/progpow.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+namespace
+{
+// Hashes per second of all threads together
+double hashRate(const ethash::epoch_context& _ctx, const progpow::program& _prog, size_t _hashes, unsigned _threads)
+{
+    ethash::hash256 header{};
+    header.bytes[0] = 0x24;
+
+    std::vector<double> rates(_threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < _threads; t++)
+        workers.emplace_back([&, t]() {
+            volatile uint8_t sink = 0;  // Keeps the hashes from being optimized out
+            rates[t] = bench::rate(_hashes / _threads, [&](size_t i) {
+                sink = progpow::hash(_ctx, _prog, header, (uint64_t(t) << 40) + i).final_hash.bytes[0];
+            });
+        });
+    for (auto& worker : workers)
+        worker.join();
+
+    double sum = 0;
+    for (double rate : rates)
+        sum += rate;
+    return sum;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t hashes = bench::arg(argc, argv, 1, 20000);
+    const uint32_t epoch = uint32_t(bench::arg(argc, argv, 2, 0));
+    const unsigned threads =
+        std::max<unsigned>(unsigned(bench::arg(argc, argv, 3, std::thread::hardware_concurrency())), 1);
+
+    const auto prog = progpow::get_program(epoch * ethash::kEpoch_length / progpow::kPeriodLength);
+
+    std::printf("%zu hashes on epoch %u, %u threads\n", hashes, epoch, threads);
+    std::printf("%-26s %14s\n", "dataset memory", "hashes/s");
+    for (const auto* allocator : {&ethash::detail::normal_pages_allocator, &ethash::detail::huge_pages_allocator})
+    {
+        ethash::set_epoch_context_allocator(*allocator);
+        ethash::epoch_context_ptr ctx{
+            ethash::detail::create_epoch_context(epoch, true), ethash::detail::destroy_epoch_context};
+        if (!ctx)
+            return 1;
+        std::printf("%-26s %14.1f\n", ethash::to_string(ethash::get_epoch_context_memory_type(*ctx)),
+            hashRate(*ctx, *prog, hashes, threads));
+    }
+    return 0;
+}
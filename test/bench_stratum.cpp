@@ -0,0 +1,122 @@
+// Nanoseconds per mining.notify decoded the way EthStratumClient does, with
+// jsoncpp (the fallback, and the only path before the scanner) and with the
+// scanner.
+//
+// Usage: bench_stratum [notifies]
+
+#include <libpoolprotocols/stratum/StratumParser.h>
+#include <libpoolprotocols/stratum/arith_uint256.h>
+#include <libpoolprotocols/stratum/uint256.h>
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "bench.h"
+
+using namespace dev;
+
+namespace
+{
+struct Job
+{
+    std::string job;
+    h256 header;
+    h256 seed;
+    h256 boundary;
+    h256 blockBoundary;
+    bool clean = false;
+    uint64_t height = 0;
+};
+
+// As processResponse : [job, header, seed, target, clean, height, bits]
+bool decodeJson(std::string const& _line, Job& _job)
+{
+    Json::Value msg;
+    Json::Reader reader;
+    if (!reader.parse(_line.data(), _line.data() + _line.size(), msg))
+        return false;
+    if (msg.get("method", "").asString() != "mining.notify")
+        return false;
+
+    Json::Value prm = msg.get("params", Json::Value::null);
+    if (!prm.isArray() || prm.empty())
+        return false;
+
+    _job.job = prm.get(Json::Value::ArrayIndex(0), "").asString();
+    std::string header = prm.get(Json::Value::ArrayIndex(1), "").asString();
+    std::string seed = prm.get(Json::Value::ArrayIndex(2), "").asString();
+    std::string target = prm.get(Json::Value::ArrayIndex(3), "").asString();
+    _job.clean = prm.get(Json::Value::ArrayIndex(4), "").asBool();
+    _job.height = prm.get(Json::Value::ArrayIndex(5), "").asInt64();
+    uint32_t bits = strtoul(prm.get(Json::Value::ArrayIndex(6), "").asString().c_str(), nullptr, 16);
+
+    std::string blockTarget = arith_uint256().SetCompact(bits).GetHex();
+    if (target.length() < 66)
+        target = "0x" + std::string(66 - target.length(), '0') + target.substr(2);
+
+    _job.seed = h256(seed);
+    _job.header = h256(header);
+    _job.boundary = h256(target);
+    _job.blockBoundary = h256(blockTarget);
+    return true;
+}
+
+// As processFastResponse and decodeNotify
+bool decodeScan(std::string const& _line, Job& _job)
+{
+    using namespace dev::stratum;
+
+    StratumMessage msg;
+    if (!scanStratumMessage(_line.data(), _line.size(), msg) || msg.method != "mining.notify" ||
+        msg.paramsCount < 7)
+        return false;
+
+    JsonToken const* prm = msg.params;
+    uint64_t bits;
+    if (!prm[0].isString() || !hexToHash(prm[1].text, _job.header) || !hexToHash(prm[2].text, _job.seed) ||
+        !hexToHash(prm[3].text, _job.boundary, true) || !parseUnsigned(prm[5].text, _job.height) ||
+        !parseUnsigned(prm[6].text, bits, 16))
+        return false;
+
+    uint256 blockTarget = ArithToUint256(arith_uint256().SetCompact(uint32_t(bits)));
+    std::reverse_copy(blockTarget.begin(), blockTarget.end(), _job.blockBoundary.data());
+    _job.clean = prm[4].isTrue();
+    _job.job.assign(prm[0].text);
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = bench::arg(argc, argv, 1, 200000);
+
+    const std::string line =
+        "{\"id\":null,\"method\":\"mining.notify\",\"params\":[\"6f3a1b\","
+        "\"0x9a1c0d6ab6e8a4df1c2fbd8b1d49a0b7e3e6d28c1e8a5a1cdd40f0e2ab7d3c11\","
+        "\"0x2f1d0e3c4b5a69788796a5b4c3d2e1f00f1e2d3c4b5a69788796a5b4c3d2e1f0\","
+        "\"0x00000000ffff0000000000000000000000000000000000000000000000000000\",true,3145728,\"1b00f1e1\"]}";
+
+    // Both paths must agree before being timed
+    Job json, scan;
+    if (!decodeJson(line, json) || !decodeScan(line, scan) || json.header != scan.header ||
+        json.seed != scan.seed || json.boundary != scan.boundary || json.blockBoundary != scan.blockBoundary ||
+        json.height != scan.height || json.clean != scan.clean || json.job != scan.job)
+    {
+        std::fprintf(stderr, "decoders disagree\n");
+        return 1;
+    }
+
+    std::printf("%zu notifies\n", count);
+    std::printf("%-10s %12s\n", "decoder", "ns/notify");
+    bool ok = true;
+    Job job;
+    const double jsonRate = bench::rate(count, [&](size_t) { ok &= decodeJson(line, job); });
+    std::printf("%-10s %12.0f\n", "jsoncpp", 1e9 / jsonRate);
+    const double scanRate = bench::rate(count, [&](size_t) { ok &= decodeScan(line, job); });
+    std::printf("%-10s %12.0f\n", "scanner", 1e9 / scanRate);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Nanoseconds per share submission serialised the way EthStratumClient did
+// with jsoncpp, and from a per job template.
+//
+// Usage: bench_submit [shares]
+
+#include <libpoolprotocols/stratum/SubmitTemplate.h>
+
+#include <libdevcore/CommonData.h>
+
+#include <json/json.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "bench.h"
+
+using namespace dev;
+using namespace dev::stratum;
+
+namespace
+{
+const char* c_userDotWorker = "0xabcdef0123456789abcdef0123456789abcdef01.rig1";
+const char* c_job = "6f3a1b";
+
+// Stratum mode 0, as submitSolution wrote it with jsoncpp
+std::string* jsoncppRequest(
+    Json::StreamWriterBuilder const& _builder, h256 const& _header, unsigned _id, uint64_t _nonce, h256 const& _mix)
+{
+    Json::Value jReq;
+    jReq["id"] = _id;
+    jReq["method"] = "mining.submit";
+    jReq["params"] = Json::Value(Json::arrayValue);
+    jReq["jsonrpc"] = "2.0";
+    jReq["params"].append(c_userDotWorker);
+    jReq["params"].append(c_job);
+    jReq["params"].append(toHex(_nonce, HexPrefix::Add));
+    jReq["params"].append(_header.hex(HexPrefix::Add));
+    jReq["params"].append(_mix.hex(HexPrefix::Add));
+    jReq["worker"] = "rig1";
+    return new std::string(Json::writeString(_builder, jReq));
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = bench::arg(argc, argv, 1, 200000);
+
+    const h256 header("0x9a1c0d6ab6e8a4df1c2fbd8b1d49a0b7e3e6d28c1e8a5a1cdd40f0e2ab7d3c11");
+    const h256 mix("0x0f1e2d3c4b5a69788796a5b4c3d2e1f00123456789abcdef0fedcba987654321");
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+
+    // The template is built once per job, lines are released as once sent
+    SubmitTemplate t;
+    t.build(0, c_job, header, 16, c_userDotWorker, "rig1", "");
+
+    // Both paths must agree before being timed
+    std::unique_ptr<std::string> json{jsoncppRequest(builder, header, 1001, 0x0123456789abcdefULL, mix)};
+    std::unique_ptr<std::string> filled{t.fill(1001, 0x0123456789abcdefULL, mix)};
+    if (*json != *filled)
+    {
+        std::fprintf(stderr, "serialisers disagree\n");
+        return 1;
+    }
+
+    std::printf("%zu shares\n", count);
+    std::printf("%-10s %12s\n", "writer", "ns/share");
+    size_t bytes = 0;
+    const double jsonRate = bench::rate(count, [&](size_t i) {
+        std::unique_ptr<std::string> line{jsoncppRequest(builder, header, unsigned(i), i, mix)};
+        bytes += line->size();
+    });
+    std::printf("%-10s %12.0f\n", "jsoncpp", 1e9 / jsonRate);
+    const double templateRate = bench::rate(count, [&](size_t i) {
+        std::unique_ptr<std::string> line{t.fill(unsigned(i), i, mix)};
+        bytes += line->size();
+    });
+    std::printf("%-10s %12.0f\n", "template", 1e9 / templateRate);
+    return bytes ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+// Share verifications per second on a light epoch context, with the cache
+// of dataset items (--verify-cache) disabled and enabled.
+//
+// Usage: bench_verify [shares] [verifications per share] [cache MiB]
+
+#include <libcrypto/progpow.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "bench.h"
+
+namespace
+{
+struct Share
+{
+    uint64_t nonce;
+    ethash::hash256 mix;
+};
+
+double verify(const ethash::epoch_context& _ctx, const ethash::hash256& _header, const ethash::hash256& _boundary,
+    std::vector<Share> const& _shares, size_t _repeat, bool& _ok)
+{
+    return bench::rate(_shares.size() * _repeat, [&](size_t i) {
+        const Share& share = _shares[i / _repeat];
+        _ok &= progpow::verify_full(_ctx, 0, _header, share.mix, share.nonce, _boundary) ==
+               ethash::VerificationResult::kOk;
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = bench::arg(argc, argv, 1, 200);
+    const size_t repeat = bench::arg(argc, argv, 2, 4);
+    const size_t cacheMb = bench::arg(argc, argv, 3, 64);
+
+    const auto ctx = ethash::get_epoch_context(0, false);
+    const auto prog = progpow::get_program(0);
+    if (!ctx || !prog)
+        return 1;
+
+    ethash::hash256 header{};
+    header.bytes[0] = 0x42;
+    ethash::hash256 boundary;
+    std::memset(boundary.bytes, 0xff, sizeof(boundary.bytes));
+
+    // Mix hashes are computed with the cache off so it starts cold
+    ethash::set_dataset_item_cache_capacity(0);
+    std::vector<Share> shares(count);
+    for (size_t i = 0; i < count; i++)
+        shares[i] = {i * 0x9e3779b97f4a7c15ULL, progpow::hash(*ctx, *prog, header, i * 0x9e3779b97f4a7c15ULL).mix_hash};
+
+    std::printf("%zu shares, each verified %zu times, cache %zu MiB\n", count, repeat, cacheMb);
+    std::printf("%-10s %16s %10s\n", "cache", "verifications/s", "hit rate");
+
+    bool ok = true;
+    for (const size_t mb : {size_t(0), cacheMb})
+    {
+        ethash::set_dataset_item_cache_capacity((mb << 20) / sizeof(ethash::hash2048));
+        const double perSecond = verify(*ctx, header, boundary, shares, repeat, ok);
+        const auto stats = ethash::get_dataset_item_cache_stats();
+        std::printf("%-10s %16.1f %9.1f%%\n", mb ? "on" : "off", perSecond, stats.hit_rate() * 100.0);
+    }
+
+    if (!ok)
+        std::fprintf(stderr, "verification failed\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+// Minimal checks for the tests : failures are reported and counted, a test
+// returns checkResult() from main
+
+#pragma once
+
+#include <cstdio>
+
+namespace test
+{
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline int checkResult()
+{
+    if (failures())
+        std::fprintf(stderr, "%d check(s) failed\n", failures());
+    return failures() ? 1 : 0;
+}
+
+}  // namespace test
+
+#define CHECK(_cond)                                                           \
+    do                                                                         \
+    {                                                                          \
+        if (!(_cond))                                                          \
+        {                                                                      \
+            std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #_cond);   \
+            ++test::failures();                                                \
+        }                                                                      \
+    } while (false)
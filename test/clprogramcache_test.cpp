@@ -0,0 +1,90 @@
+// Checks the disk store of CLProgramCache : binaries are stored, reloaded
+// without building, rebuilt once dropped or damaged, and evicted by size
+
+#include <libethash-cl/CLProgramCache.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "check.h"
+
+using namespace dev::eth;
+
+namespace
+{
+unsigned builds = 0;
+
+CLProgramCache::Binary get(std::string const& _key, CLProgramCache::Binary const& _binary)
+{
+    return CLProgramCache::get(_key, [&]() {
+        builds++;
+        return _binary;
+    });
+}
+
+std::filesystem::path cached(std::filesystem::path const& _directory, std::string const& _key)
+{
+    return _directory / ("meowpow-cl-" + _key + ".bin");
+}
+
+}  // namespace
+
+int main()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "meowpow-clprogramcache-test";
+    std::filesystem::remove_all(directory);
+    CLProgramCache::setDirectory(directory.string(), 1 << 20);
+
+    const CLProgramCache::Binary binary(1000, 0x5a);
+    const std::string key = CLProgramCache::key("source", "platform/device", "driver", "-options");
+
+    // Keys depend on every part, and parts can't be shifted into each other
+    CHECK(key != CLProgramCache::key("source", "platform/device", "driver", "-other"));
+    CHECK(CLProgramCache::key("ab", "c", "", "") != CLProgramCache::key("a", "bc", "", ""));
+
+    // Built once, then reloaded from disk
+    CHECK(get(key, binary) == binary);
+    CHECK(builds == 1);
+    CHECK(std::filesystem::exists(cached(directory, key)));
+    CHECK(get(key, CLProgramCache::Binary(1000, 0)) == binary);
+    CHECK(builds == 1);
+
+    // A rejected binary is dropped and the next lookup builds again
+    CLProgramCache::drop(key);
+    CHECK(!std::filesystem::exists(cached(directory, key)));
+    CHECK(get(key, binary) == binary);
+    CHECK(builds == 2);
+
+    // A damaged file is not loaded
+    {
+        std::fstream file(cached(directory, key), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put(0);
+    }
+    CHECK(get(key, binary) == binary);
+    CHECK(builds == 3);
+    CHECK(get(key, binary) == binary);
+    CHECK(builds == 3);
+
+    // Failed builds are not cached
+    const std::string failing = CLProgramCache::key("broken", "platform/device", "driver", "");
+    CHECK(get(failing, {}).empty());
+    CHECK(!std::filesystem::exists(cached(directory, failing)));
+    CHECK(builds == 4);
+
+    // Room for one binary only : the least recently stored goes
+    CLProgramCache::setDirectory(directory.string(), 1500);
+    const std::string other = CLProgramCache::key("other", "platform/device", "driver", "");
+    CHECK(get(other, binary) == binary);
+    CHECK(std::filesystem::exists(cached(directory, other)));
+    CHECK(!std::filesystem::exists(cached(directory, key)));
+
+    // Binaries larger than the store are never written
+    CLProgramCache::setDirectory(directory.string(), 100);
+    const std::string large = CLProgramCache::key("large", "platform/device", "driver", "");
+    CHECK(get(large, binary) == binary);
+    CHECK(!std::filesystem::exists(cached(directory, large)));
+
+    std::filesystem::remove_all(directory);
+    return test::checkResult();
+}
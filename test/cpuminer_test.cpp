@@ -0,0 +1,82 @@
+// Checks a CPU miner submits a solution found for a job once only, even when
+// no new job comes and its wait for work times out, and searches new jobs
+
+#include <libethash-cpu/CPUMiner.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "check.h"
+
+using namespace dev;
+using namespace dev::eth;
+
+bool g_exitOnError = false;  // Defined by the application, see Worker.h
+
+namespace
+{
+// Counts the solutions submitted by miners
+class CountingFarm : public FarmFace
+{
+public:
+    unsigned get_tstart() override { return 0; }
+    unsigned get_tstop() override { return 0; }
+    unsigned get_ergodicity() override { return 0; }
+    void submitProof(Solution const&) override { m_submits.fetch_add(1); }
+    void accountSolution(unsigned, SolutionAccountingEnum) override {}
+    uint64_t get_nonce_scrambler() override { return 0; }
+    unsigned get_segment_width() override { return 32; }
+
+    unsigned submits() const { return m_submits.load(); }
+
+    // Waits for at least _count submits, the first search builds the DAG
+    bool waitSubmits(unsigned _count) const
+    {
+        for (unsigned i = 0; i < 3000 && submits() < _count; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return submits() >= _count;
+    }
+
+private:
+    std::atomic<unsigned> m_submits = {0};
+};
+
+WorkPackage easyJob(unsigned _header)
+{
+    // Any hash meets the boundary : the first nonce searched is a solution
+    WorkPackage w;
+    w.job = std::to_string(_header);
+    w.header = h256(_header);
+    w.boundary = ~h256();
+    w.epoch = 0;
+    w.block = 0;
+    return w;
+}
+
+}  // namespace
+
+int main()
+{
+    CountingFarm farm;
+
+    DeviceDescriptor device;
+    device.cpCpuNumer = 0;
+    device.totalMemory = 0;
+    CPUMiner miner(0, CPSettings(), device);
+    miner.startWorking();
+
+    miner.setWork(easyJob(1));
+    CHECK(farm.waitSubmits(1));
+
+    // Outlasts a few wait timeouts of the miner
+    std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+    CHECK(farm.submits() == 1);
+
+    miner.setWork(easyJob(2));
+    CHECK(farm.waitSubmits(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    CHECK(farm.submits() == 2);
+
+    return test::checkResult();
+}
@@ -0,0 +1,47 @@
+// Checks the dataset items computed several at a time (SIMD lanes when the
+// CPU has them) are bit for bit the ones computed one by one
+
+#include <libcrypto/ethash.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+
+namespace
+{
+void check_items(const ethash::epoch_context& _ctx, uint32_t _index, uint32_t _count)
+{
+    std::vector<ethash::hash1024> items(_count);
+    ethash::detail::calculate_dataset_items_1024(_ctx, _index, _count, items.data());
+    for (uint32_t i = 0; i < _count; i++)
+    {
+        const auto item = ethash::detail::calculate_dataset_item_1024(_ctx, _index + i);
+        CHECK(std::memcmp(items[i].bytes, item.bytes, sizeof(item.bytes)) == 0);
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    for (const uint32_t epoch : {0, 7})
+    {
+        const auto ctx = ethash::get_epoch_context(epoch, false);
+        CHECK(ctx);
+        if (!ctx)
+            return test::checkResult();
+
+        // Whole groups of lanes, partial groups and single items
+        check_items(*ctx, 0, 1024);
+        for (const uint32_t count : {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33})
+            check_items(*ctx, 12345, count);
+        for (const uint32_t index : {1, 3, 5, 7})
+            check_items(*ctx, index, 40);
+
+        // Last items of the dataset
+        check_items(*ctx, ctx->full_dataset_num_items - 37, 37);
+    }
+
+    return test::checkResult();
+}
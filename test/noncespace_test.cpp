@@ -0,0 +1,126 @@
+// Checks nonce spaces are split among miners exactly, in proportion to their
+// hashrates, and that claims hand out every nonce once : miners done with
+// their slice steal the upper half of the largest one left
+
+#include <libethcore/Miner.h>
+
+#include <limits>
+#include <vector>
+
+#include "check.h"
+
+using namespace dev;
+using namespace dev::eth;
+
+bool g_exitOnError = false;  // Defined by the application, see Worker.h
+
+namespace
+{
+const uint64_t c_max = std::numeric_limits<uint64_t>::max();
+
+u128 sum(std::vector<uint64_t> const& _sizes)
+{
+    u128 total = 0;
+    for (auto size : _sizes)
+        total += size;
+    return total;
+}
+
+void checkSplit(u128 _space, std::vector<uint64_t> const& _weights, std::vector<uint64_t> const& _expected)
+{
+    const auto sizes = NonceSpace::split(_space, _weights);
+    CHECK(sizes == _expected);
+    CHECK(sum(sizes) == std::min<u128>(_space, u128(c_max) * _weights.size()));
+}
+
+// Claims the whole space in turns, each miner by batches of its own size.
+// Every nonce is claimed once and claims fail only once all are
+void checkClaims(std::vector<uint64_t> const& _sizes, std::vector<uint64_t> const& _batches)
+{
+    const uint64_t start = 1000;
+    const uint64_t space = uint64_t(sum(_sizes));
+    NonceSpace nonces(start, _sizes);
+
+    std::vector<unsigned> claimed(space, 0);
+    uint64_t searched = 0;
+    std::vector<bool> done(_batches.size(), false);
+    for (unsigned turn = 0, left = unsigned(_batches.size()); left; turn = (turn + 1) % _batches.size())
+    {
+        if (done[turn])
+            continue;
+        auto claim = nonces.claim(turn, _batches[turn]);
+        if (!claim.second)
+        {
+            CHECK(searched == space);
+            done[turn] = true;
+            left--;
+            continue;
+        }
+        CHECK(claim.second <= _batches[turn]);
+        CHECK(claim.first >= start && claim.first + claim.second <= start + space);
+        for (uint64_t n = claim.first; n < claim.first + claim.second && n - start < space; n++)
+            claimed[n - start]++;
+        searched += claim.second;
+    }
+
+    for (auto count : claimed)
+        CHECK(count == 1);
+}
+
+}  // namespace
+
+int main()
+{
+    // Floors, then remainders to the largest fractions : 10/7, 20/7, 40/7
+    checkSplit(10, {1, 2, 4}, {1, 3, 6});
+    // 300/7, 300/7, 100/7
+    checkSplit(100, {3, 3, 1}, {43, 43, 14});
+    checkSplit(u128(1) << 32, {5}, {uint64_t(1) << 32});
+    checkSplit(7, {1, 1000000}, {0, 7});
+    checkSplit(0, {1, 2}, {0, 0});
+    CHECK(NonceSpace::split(10, {}).empty());
+
+    // Hashrates as measured, the space split among four miners
+    const auto sizes = NonceSpace::split(u128(4) << 40, {1520000, 1480000, 990000, 12000});
+    CHECK(sum(sizes) == u128(4) << 40);
+    CHECK(sizes[0] > sizes[1] && sizes[1] > sizes[2] && sizes[2] > sizes[3]);
+
+    // Slices are 64 bits wide at most, a wider space is clamped
+    checkSplit(u128(1) << 64, {1}, {c_max});
+    checkSplit(u128(1) << 65, {1, 1}, {c_max, c_max});
+    checkSplit(u128(1) << 66, {1, 3}, {c_max, c_max});
+    // A slice clamped leaves the others what it can't hold
+    checkSplit(u128(3) << 63, {1, 3}, {(uint64_t(1) << 63) + 1, c_max});
+    checkSplit(u128(1) << 64, {1, 1}, {uint64_t(1) << 63, uint64_t(1) << 63});
+
+    // A miner claims from its own slice first
+    {
+        NonceSpace nonces(1000, {10, 20});
+        CHECK((nonces.claim(0, 4) == std::pair<uint64_t, uint64_t>{1000, 4}));
+        CHECK((nonces.claim(0, 4) == std::pair<uint64_t, uint64_t>{1004, 4}));
+        CHECK((nonces.claim(0, 4) == std::pair<uint64_t, uint64_t>{1008, 2}));
+        CHECK((nonces.claim(1, 4) == std::pair<uint64_t, uint64_t>{1010, 4}));
+
+        // Then steals the upper half of what's left of the largest slice
+        CHECK((nonces.claim(0, 4) == std::pair<uint64_t, uint64_t>{1022, 4}));
+        CHECK((nonces.claim(1, 100) == std::pair<uint64_t, uint64_t>{1014, 8}));
+
+        // What's too small to be halved is taken whole
+        CHECK((nonces.claim(1, 4) == std::pair<uint64_t, uint64_t>{1026, 4}));
+        CHECK((nonces.claim(0, 4) == std::pair<uint64_t, uint64_t>{0, 0}));
+        CHECK((nonces.claim(1, 4) == std::pair<uint64_t, uint64_t>{0, 0}));
+
+        // Unknown miners get nothing
+        CHECK((nonces.claim(2, 4) == std::pair<uint64_t, uint64_t>{0, 0}));
+    }
+
+    // Whole spaces claimed in turns, with slices and batches of all sizes
+    checkClaims({10, 20}, {4, 4});
+    checkClaims({100, 0, 3}, {7, 1, 64});
+    checkClaims({1, 1, 1, 1}, {3, 2, 1, 5});
+    checkClaims({1000, 0}, {1, 16});
+    checkClaims({0, 0, 0}, {4, 4, 4});
+    checkClaims(NonceSpace::split(4096, {3, 1, 7}), {64, 256, 16});
+
+    return test::checkResult();
+}
@@ -0,0 +1,177 @@
+// Checks progpow::hash against known answers of the original (one lane at a
+// time) implementation, and progpow::search against per nonce progpow::hash,
+// mostly at the edges of the nonce range. Both with every round implementation
+// the CPU supports
+
+#include <libcrypto/progpow.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "check.h"
+
+namespace
+{
+bool operator==(const ethash::hash256& a, const ethash::hash256& b)
+{
+    return std::memcmp(a.bytes, b.bytes, sizeof(a.bytes)) == 0;
+}
+
+// First solution by hashing nonces one at a time, wrapping like a uint64_t does
+ethash::search_result naive_search(const ethash::epoch_context& ctx, const progpow::program& prog,
+    const ethash::hash256& header, const ethash::hash256& boundary, uint64_t start_nonce, size_t count)
+{
+    for (uint64_t nonce{start_nonce}; count; --count, ++nonce)
+    {
+        const auto r{progpow::hash(ctx, prog, header, nonce)};
+        if (ethash::is_less_or_equal(r.final_hash, boundary))
+            return {true, nonce, r.final_hash, r.mix_hash};
+    }
+    return {};
+}
+
+ethash::hash256 from_hex(const char* hex)
+{
+    ethash::hash256 h{};
+    for (size_t i{0}; i < sizeof(h.bytes); ++i)
+    {
+        unsigned byte;
+        std::sscanf(hex + 2 * i, "%2x", &byte);
+        h.bytes[i] = static_cast<uint8_t>(byte);
+    }
+    return h;
+}
+
+// Hashes of the implementation preceding the program cache and the SIMD rounds
+struct known_answer
+{
+    uint32_t epoch;
+    uint32_t period;
+    const char* header;
+    uint64_t nonce;
+    const char* final_hash;
+    const char* mix_hash;
+};
+
+const known_answer known_answers[] = {
+    {0, 0, "0000000000000000000000000000000000000000000000000000000000000000", 0x0000000000000000,
+        "c36c86314cd0fe3d8dfbe67140c9b868516fb9e87c51a28ec7e65871c26db124",
+        "1bb2302336b4228e02ac82801fef6f636681f3d8cc74c21aeb9e4492a57e25a5"},
+    {0, 720, "9a1c0d6ab6e8a4df1c2fbd8b1d49a0b7e3e6d28c1e8a5a1cdd40f0e2ab7d3c11", 0x123456789abcdef0,
+        "52291e4a885604dc0ed2b6e3391fc5aae3338fa1491d10afb9f178ce15851700",
+        "7f0c370b805c3e1503222c7810bd6fcc8870e21950f1a4285efbf425d5fc67c8"},
+    {0, 1249, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", 0xffffffffffffffff,
+        "41705230001ed5cbc040c13f9f4ec5342eb7c86bbadfa1d87828c602bd0f2102",
+        "fa986707a74a2b09a079efa3bcd0c737c5cb4a2c26e9c70c30b8d45b8bc37946"},
+    {7, 8770, "2f1d0e3c4b5a69788796a5b4c3d2e1f00f1e2d3c4b5a69788796a5b4c3d2e1f0", 0x00000000deadbeef,
+        "abc1d05f45ecbe62576fc76e757e7978b2b834aa6cdcf214aaf88eb7716ec107",
+        "5dd5cdc6d9e82e71e8e4eae373cbd9dfedb2de86f6dcff6edd9dd3911fa2cebd"},
+    {7, 9999, "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 0x8000000000000000,
+        "cc42538b7da0d580c859011bb12db21d3d7fbfbd626f019be80287a51fb606ae",
+        "878a1c00122c2392fd12b46b891a24fb072d91f96dfbb8ab3ac8fc00c7223d1f"},
+};
+
+void check_known_answers()
+{
+    for (const auto& t : known_answers)
+    {
+        const auto ctx{ethash::get_epoch_context(t.epoch, false)};
+        const auto header{from_hex(t.header)};
+        const auto r{progpow::hash(*ctx, t.period, header, t.nonce)};
+        CHECK(ethash::to_hex(r.final_hash) == t.final_hash);
+        CHECK(ethash::to_hex(r.mix_hash) == t.mix_hash);
+
+        // Searches hash the same
+        const auto found{progpow::search(*ctx, t.period, header, r.final_hash, t.nonce, 1)};
+        CHECK(found.solution_found && found.final_hash == r.final_hash && found.mix_hash == r.mix_hash);
+    }
+}
+
+void check_same(const ethash::search_result& got, const ethash::search_result& want)
+{
+    CHECK(got.solution_found == want.solution_found);
+    if (!got.solution_found || !want.solution_found)
+        return;
+    CHECK(got.nonce == want.nonce);
+    CHECK(got.final_hash == want.final_hash);
+    CHECK(got.mix_hash == want.mix_hash);
+}
+
+void check_search(const ethash::epoch_context& ctx, const progpow::program& prog)
+{
+    ethash::hash256 header{};
+    for (size_t i{0}; i < sizeof(header.bytes); ++i)
+        header.bytes[i] = static_cast<uint8_t>(i * 7 + 1);
+
+    ethash::hash256 easy;
+    std::memset(easy.bytes, 0xff, sizeof(easy.bytes));
+
+    constexpr uint64_t last{~uint64_t(0)};
+
+    // Batches ending exactly at 2^64, shorter and longer than one internal batch
+    check_same(progpow::search(ctx, prog, header, easy, last, 1), naive_search(ctx, prog, header, easy, last, 1));
+    check_same(
+        progpow::search(ctx, prog, header, easy, last - 1, 2), naive_search(ctx, prog, header, easy, last - 1, 2));
+    CHECK(progpow::search(ctx, prog, header, easy, last - 1, 2).nonce == last - 1);
+
+    // Only the last nonce of the range is allowed to pass : the whole range up to
+    // 2^64 - 1 has to be searched
+    for (const size_t count : {1, 3, 4, 5, 8, 13})
+    {
+        const uint64_t start{last - (count - 1)};
+        const auto boundary{progpow::hash(ctx, prog, header, last).final_hash};
+        const auto want{naive_search(ctx, prog, header, boundary, start, count)};
+        CHECK(want.solution_found);
+        check_same(progpow::search(ctx, prog, header, boundary, start, count), want);
+    }
+
+    // Nothing past the range : a target met only by the nonce after it is not found
+    {
+        const auto boundary{progpow::hash(ctx, prog, header, 0).final_hash};
+        const auto want{naive_search(ctx, prog, header, boundary, last - 6, 7)};
+        check_same(progpow::search(ctx, prog, header, boundary, last - 6, 7), want);
+    }
+
+    // Ordinary ranges, unaligned counts
+    for (const size_t count : {1, 2, 7, 16, 33})
+    {
+        const uint64_t start{0x123456789abcdefULL};
+        const auto boundary{progpow::hash(ctx, prog, header, start + count - 1).final_hash};
+        check_same(progpow::search(ctx, prog, header, boundary, start, count),
+            naive_search(ctx, prog, header, boundary, start, count));
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    const auto ctx{ethash::get_epoch_context(0, false)};
+    const auto prog{progpow::get_program(0)};
+    CHECK(ctx && prog);
+    if (!ctx || !prog)
+        return 1;
+
+    using progpow::detail::round_implementation;
+    const std::pair<round_implementation, const char*> implementations[] = {
+        {round_implementation::generic, "generic"},
+        {round_implementation::avx2, "avx2"},
+        {round_implementation::avx512, "avx512"},
+    };
+    for (const auto& impl : implementations)
+    {
+        if (!progpow::detail::use_round_implementation(impl.first))
+        {
+            std::fprintf(stderr, "%s rounds not supported, skipped\n", impl.second);
+            continue;
+        }
+        const int failures{test::failures()};
+        check_known_answers();
+        check_search(*ctx, *prog);
+        if (test::failures() != failures)
+            std::fprintf(stderr, "with %s rounds\n", impl.second);
+    }
+
+    return test::checkResult();
+}
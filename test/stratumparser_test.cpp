@@ -0,0 +1,157 @@
+// Checks the stratum scanner handles typical messages and declines the
+// ones left to jsoncpp : escaped strings, more than 8 params, ids that
+// don't fit 32 bits
+
+#include <libpoolprotocols/stratum/StratumParser.h>
+
+#include <json/json.h>
+
+#include <cstring>
+#include <string>
+
+#include "check.h"
+
+using namespace dev;
+using namespace dev::stratum;
+
+namespace
+{
+bool scan(std::string const& _line, StratumMessage& _msg)
+{
+    return scanStratumMessage(_line.data(), _line.size(), _msg);
+}
+
+// Lines declined by the scanner must still be valid for the fallback
+bool jsoncppParses(std::string const& _line)
+{
+    Json::Value value;
+    Json::Reader reader;
+    return reader.parse(_line, value) && value.isObject();
+}
+
+const std::string c_header = "0x9a1c0d6ab6e8a4df1c2fbd8b1d49a0b7e3e6d28c1e8a5a1cdd40f0e2ab7d3c11";
+
+}  // namespace
+
+int main()
+{
+    StratumMessage msg;
+
+    // A notify the scanner handles by itself
+    {
+        const std::string line = "{\"id\":null,\"method\":\"mining.notify\",\"params\":[\"a1b2\",\"" + c_header +
+                                 "\",\"0x00\",\"0x00000000ffff\",true,1234,\"1d00ffff\"]}";
+        CHECK(scan(line, msg));
+        CHECK(msg.method == "mining.notify");
+        CHECK(msg.id == 0);
+        CHECK(msg.paramsCount == 7);
+        CHECK(msg.params[0].isString() && msg.params[0].text == "a1b2");
+        CHECK(msg.params[4].isTrue());
+        CHECK(msg.params[5].kind == JsonToken::Kind::Number && msg.params[5].text == "1234");
+
+        h256 header;
+        CHECK(hexToHash(msg.params[1].text, header));
+        CHECK(header == h256(c_header));
+        h256 target;
+        CHECK(hexToHash(msg.params[3].text, target, true));
+        CHECK(target == h256(0xffff));
+        CHECK(!hexToHash(msg.params[3].text, target));
+    }
+
+    // Escaped strings : in keys and methods the line is declined, in params the
+    // value is not decoded so the notify decoder falls back
+    {
+        const std::string key = "{\"i\\u0064\":1,\"result\":true}";
+        CHECK(!scan(key, msg));
+        CHECK(jsoncppParses(key));
+
+        const std::string method = "{\"id\":null,\"method\":\"mining\\u002enotify\",\"params\":[\"a\"]}";
+        CHECK(!scan(method, msg));
+        CHECK(jsoncppParses(method));
+
+        const std::string param = "{\"id\":null,\"method\":\"mining.notify\",\"params\":[\"a\\\"b\",\"x\"]}";
+        CHECK(scan(param, msg));
+        CHECK(msg.paramsCount == 2);
+        CHECK(msg.params[0].kind == JsonToken::Kind::Other);
+        CHECK(msg.params[1].isString() && msg.params[1].text == "x");
+        CHECK(jsoncppParses(param));
+    }
+
+    // Up to 8 params are scanned, more are left to jsoncpp
+    {
+        const std::string eight = "{\"method\":\"m\",\"params\":[1,2,3,4,5,6,7,8]}";
+        CHECK(scan(eight, msg));
+        CHECK(msg.paramsCount == 8);
+        CHECK(msg.params[7].text == "8");
+
+        const std::string nine = "{\"method\":\"m\",\"params\":[1,2,3,4,5,6,7,8,9]}";
+        CHECK(!scan(nine, msg));
+        CHECK(jsoncppParses(nine));
+    }
+
+    // Numeric ids must fit 32 bits, other ids are left to jsoncpp
+    {
+        const std::string max = "{\"id\":4294967295,\"result\":true}";
+        CHECK(scan(max, msg));
+        CHECK(msg.id == 4294967295U);
+        CHECK(msg.result.isTrue());
+
+        for (const std::string line :
+            {"{\"id\":4294967296,\"result\":true}", "{\"id\":18446744073709551616,\"result\":true}",
+                "{\"id\":-1,\"result\":true}", "{\"id\":\"7\",\"result\":true}"})
+        {
+            CHECK(!scan(line, msg));
+            CHECK(jsoncppParses(line));
+        }
+    }
+
+    // Literals are exactly true, false, null or a JSON number. Anything else is
+    // declined, for jsoncpp to decide
+    {
+        for (const std::string value : {"nullx", "nul", "tru", "truex", "fals", "falsey", "+1", "01", "-", "1.",
+                 ".5", "1e", "1e+", "--1", "0x10", "1a", "12-3", "1.2.3", "NaN", "Infinity"})
+        {
+            CHECK(!scan("{\"id\":1,\"result\":" + value + "}", msg));
+            CHECK(!scan("{\"id\":1,\"error\":" + value + ",\"result\":null}", msg));
+            CHECK(!scan("{\"method\":\"m\",\"params\":[" + value + "]}", msg));
+        }
+        CHECK(!jsoncppParses("{\"id\":1,\"error\":nullx}"));
+        CHECK(!jsoncppParses("{\"id\":1,\"result\":tru}"));
+
+        const std::string literals = "{\"method\":\"m\",\"params\":[true , false,null ]}";
+        CHECK(scan(literals, msg));
+        CHECK(msg.paramsCount == 3);
+        CHECK(msg.params[0].isTrue() && msg.params[0].text == "true");
+        CHECK(msg.params[1].kind == JsonToken::Kind::Bool && !msg.params[1].isTrue());
+        CHECK(msg.params[2].kind == JsonToken::Kind::Null && msg.params[2].text == "null");
+        CHECK(jsoncppParses(literals));
+
+        const std::string numbers = "{\"method\":\"m\",\"params\":[0,-0,12,-3.25,1e9,2E-3,1.5e+2]}";
+        CHECK(scan(numbers, msg));
+        CHECK(msg.paramsCount == 7);
+        const char* texts[] = {"0", "-0", "12", "-3.25", "1e9", "2E-3", "1.5e+2"};
+        for (unsigned i = 0; i < 7; i++)
+            CHECK(msg.params[i].kind == JsonToken::Kind::Number && msg.params[i].text == texts[i]);
+        CHECK(jsoncppParses(numbers));
+    }
+
+    // Lines cut after the backslash of an escape
+    for (const std::string line : {"{\"id\":1,\"result\":\"ab\\", "{\"id\":1,\"result\":[\"a\\",
+             "{\"method\":\"m\",\"params\":[\"\\", "{\"method\":\"m\",\"params\":{\"\\"})
+    {
+        CHECK(!scan(line, msg));
+        CHECK(!jsoncppParses(line));
+    }
+
+    // Not a single object
+    CHECK(!scan("[1,2]", msg));
+    CHECK(!scan("{\"id\":1} {\"id\":2}", msg));
+    CHECK(!scan("{\"id\":1", msg));
+
+    uint64_t value;
+    CHECK(parseUnsigned("0x1f", value, 0) && value == 0x1f);
+    CHECK(parseUnsigned("1d00ffff", value, 16) && value == 0x1d00ffff);
+    CHECK(!parseUnsigned("12a", value));
+
+    return test::checkResult();
+}
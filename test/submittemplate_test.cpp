@@ -0,0 +1,151 @@
+// Checks share submissions serialised from templates are byte for byte the
+// requests EthStratumClient built with jsoncpp before them, in every stratum
+// mode, with and without a worker name, extranonces and escaped job ids
+
+#include <libpoolprotocols/stratum/SubmitTemplate.h>
+
+#include <libdevcore/CommonData.h>
+
+#include <json/json.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "check.h"
+
+using namespace dev;
+using namespace dev::stratum;
+
+namespace
+{
+// EthStratumClient::StratumProtocol
+enum
+{
+    STRATUM = 0,
+    ETHPROXY,
+    ETHEREUMSTRATUM,
+    ETHEREUMSTRATUM2
+};
+
+struct Share
+{
+    int mode;
+    std::string job;
+    h256 header;
+    unsigned exSizeBytes;
+    std::string userDotWorker;
+    std::string worker;
+    std::string workerId;
+};
+
+// The request as submitSolution wrote it with jsoncpp
+std::string jsoncppRequest(Share const& _s, unsigned _id, uint64_t _nonce, h256 const& _mix)
+{
+    Json::Value jReq;
+    jReq["id"] = _id;
+    jReq["method"] = "mining.submit";
+    jReq["params"] = Json::Value(Json::arrayValue);
+
+    switch (_s.mode)
+    {
+    case STRATUM:
+        jReq["jsonrpc"] = "2.0";
+        jReq["params"].append(_s.userDotWorker);
+        jReq["params"].append(_s.job);
+        jReq["params"].append(toHex(_nonce, HexPrefix::Add));
+        jReq["params"].append(_s.header.hex(HexPrefix::Add));
+        jReq["params"].append(_mix.hex(HexPrefix::Add));
+        if (!_s.worker.empty())
+            jReq["worker"] = _s.worker;
+        break;
+
+    case ETHPROXY:
+        jReq["method"] = "eth_submitWork";
+        jReq["params"].append(toHex(_nonce, HexPrefix::Add));
+        jReq["params"].append(_s.header.hex(HexPrefix::Add));
+        jReq["params"].append(_mix.hex(HexPrefix::Add));
+        if (!_s.worker.empty())
+            jReq["worker"] = _s.worker;
+        break;
+
+    case ETHEREUMSTRATUM:
+        jReq["params"].append(_s.userDotWorker);
+        jReq["params"].append(_s.job);
+        jReq["params"].append(toHex(_nonce, HexPrefix::DontAdd).substr(_s.exSizeBytes));
+        break;
+
+    case ETHEREUMSTRATUM2:
+        jReq["params"].append(_s.job);
+        jReq["params"].append(toHex(_nonce, HexPrefix::DontAdd).substr(_s.exSizeBytes));
+        jReq["params"].append(_s.workerId);
+        break;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    return Json::writeString(builder, jReq);
+}
+
+void checkShare(Share const& _s)
+{
+    SubmitTemplate t;
+    const unsigned digits = SubmitTemplate::nonceDigits(_s.mode, _s.exSizeBytes);
+    t.build(_s.mode, _s.job, _s.header, digits, _s.userDotWorker, _s.worker, _s.workerId);
+    CHECK(t.matches(_s.mode, _s.job, _s.header, digits));
+
+    const h256 mix("0x0f1e2d3c4b5a69788796a5b4c3d2e1f00123456789abcdef0fedcba987654321");
+    for (unsigned id : {1U, 40U, 999U, 1000U, 1001U, 65536U, 4000000000U})
+        for (uint64_t nonce : {0ULL, 0x0123456789abcdefULL, 0x00000000ffffffffULL, ~0ULL})
+        {
+            std::unique_ptr<std::string> line{t.fill(id, nonce, mix)};
+            const std::string expected = jsoncppRequest(_s, id, nonce, mix);
+            CHECK(*line == expected);
+            if (*line != expected)
+                std::fprintf(stderr, "  got      %s\n  expected %s\n", line->c_str(), expected.c_str());
+        }
+}
+
+}  // namespace
+
+int main()
+{
+    const h256 header("0x9a1c0d6ab6e8a4df1c2fbd8b1d49a0b7e3e6d28c1e8a5a1cdd40f0e2ab7d3c11");
+    const std::string jobs[] = {
+        "6f3a1b",
+        "0x2f1d0e3c4b5a69788796a5b4c3d2e1f00f1e2d3c4b5a69788796a5b4c3d2e1f0",
+        "a\"b\\c/d\n\t\x01\x1f",
+        "caf\xc3\xa9",
+    };
+
+    for (int mode : {STRATUM, ETHPROXY, ETHEREUMSTRATUM, ETHEREUMSTRATUM2})
+        for (auto const& job : jobs)
+            for (const char* worker : {"", "rig1", "rig \"2\""})
+                for (unsigned exSize : {0U, 2U, 4U})
+                {
+                    // Only EthereumStratum pools own part of the nonce
+                    if (exSize && mode != ETHEREUMSTRATUM && mode != ETHEREUMSTRATUM2)
+                        continue;
+                    checkShare({mode, job, header, exSize, "0xabcdef.rig1", worker, "w-123"});
+                }
+
+    // Templates are per job, mode and nonce digits
+    SubmitTemplate t;
+    CHECK(!t.matches(STRATUM, "6f3a1b", header, 16));
+    t.build(STRATUM, "6f3a1b", header, 16, "0xabcdef", "", "");
+    CHECK(t.matches(STRATUM, "6f3a1b", header, 16));
+    CHECK(!t.matches(ETHPROXY, "6f3a1b", header, 16));
+    CHECK(!t.matches(STRATUM, "6f3a1c", header, 16));
+    CHECK(!t.matches(STRATUM, "6f3a1b", h256(), 16));
+    CHECK(!t.matches(STRATUM, "6f3a1b", header, 14));
+    t.clear();
+    CHECK(!t.matches(STRATUM, "6f3a1b", header, 16));
+
+    CHECK(SubmitTemplate::nonceDigits(STRATUM, 2) == 16);
+    CHECK(SubmitTemplate::nonceDigits(ETHPROXY, 2) == 16);
+    CHECK(SubmitTemplate::nonceDigits(ETHEREUMSTRATUM, 2) == 14);
+    CHECK(SubmitTemplate::nonceDigits(ETHEREUMSTRATUM2, 4) == 12);
+    CHECK(SubmitTemplate::nonceDigits(ETHEREUMSTRATUM, 20) == 0);
+
+    return test::checkResult();
+}